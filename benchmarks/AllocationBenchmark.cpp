@@ -0,0 +1,71 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "../execution/Machine.hpp"
+
+/**
+ * @brief Measure how long it takes for the interpreter to register, collect and free a large amount of objects,
+ * as well as how long it takes to destroy an interpreter that still has a large amount of live objects
+ *
+ * Usage: allocation_benchmark [object count]
+ */
+int main(int argc, char **argv)
+{
+    using Clock = std::chrono::steady_clock;
+    size_t count = 1000000;
+    if (argc > 1)
+    {
+        count = std::stoul(argv[1]);
+    }
+    Clock::time_point start = Clock::now();
+    Clock::time_point allocated;
+    Clock::time_point collected;
+    {
+        GobLang::Machine machine;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i % 2 == 0)
+            {
+                machine.createArrayOfSize(0);
+            }
+            else
+            {
+                machine.createString("bench", true);
+            }
+        }
+        allocated = Clock::now();
+        std::cout << "Registered objects: " << machine.getObjectCount() << std::endl;
+        machine.collectGarbage();
+        collected = Clock::now();
+        std::cout << "Objects after collection: " << machine.getObjectCount() << std::endl;
+    }
+    Clock::time_point end = Clock::now();
+    Clock::time_point liveAllocated;
+    {
+        GobLang::Machine machine;
+        for (size_t i = 0; i < count; i++)
+        {
+            machine.createArrayOfSize(0);
+        }
+        liveAllocated = Clock::now();
+        const GobLang::SlabAllocator &allocator = machine.getAllocator();
+        for (size_t i = 0; i < GobLang::SlabAllocator::SizeClassCount; i++)
+        {
+            GobLang::SlabAllocator::SizeClassCounters const &counters = allocator.getSizeClassCounters(i);
+            if (counters.allocations > 0)
+            {
+                std::cout << "Size class " << counters.slotSize << "b: " << counters.liveObjects << " live objects in " << counters.slabCount << " slabs" << std::endl;
+            }
+        }
+    }
+    Clock::time_point liveEnd = Clock::now();
+
+    auto ms = [](Clock::time_point a, Clock::time_point b)
+    { return std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count(); };
+    std::cout << "Allocation of " << count << " objects: " << ms(start, allocated) << "ms" << std::endl;
+    std::cout << "Collection: " << ms(allocated, collected) << "ms" << std::endl;
+    std::cout << "Machine destruction: " << ms(collected, end) << "ms" << std::endl;
+    std::cout << "Machine destruction with " << count << " live objects: " << ms(liveAllocated, liveEnd) << "ms" << std::endl;
+    return EXIT_SUCCESS;
+}
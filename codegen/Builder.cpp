@@ -1,6 +1,7 @@
 #include "Builder.hpp"
 #include "../execution/Operations.hpp"
 #include "Lexems.hpp"
+#include "Parser.hpp"
 #include <algorithm>
 
 using namespace GobLang;
@@ -176,21 +177,34 @@ std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::Builder::creat
     for (std::vector<std::unique_ptr<CodeGenValue>>::const_iterator it = args.begin(); it != args.end(); it++)
     {
         std::vector<uint8_t> argBytes = (*it)->getGetOperationBytes();
-        bytes.insert(bytes.begin(), argBytes.begin(), argBytes.end());
+        // native constructors receive the first argument on top of the stack, while functions defined by the user receive it at the bottom
+        if (funcIt != m_functions.end())
+        {
+            bytes.insert(bytes.end(), argBytes.begin(), argBytes.end());
+        }
+        else
+        {
+            bytes.insert(bytes.begin(), argBytes.begin(), argBytes.end());
+        }
     }
     // call
     if (funcIt != m_functions.end())
     {
-        bytes.push_back((uint8_t)Operation::GetLocalFunction);
+        if (args.size() > UINT8_MAX)
+        {
+            throw ParsingError(0, 0, "Too many arguments passed to a function, function calls are limited to 255 arguments");
+        }
+        // function is known at compile time, so it can be called without getting a reference to it first
+        bytes.push_back((uint8_t)Operation::CallLocal);
         bytes.push_back((uint8_t)(funcIt - m_functions.begin()));
+        bytes.push_back((uint8_t)args.size());
     }
     else
     {
-        bytes.push_back((uint8_t)GobLang::Operation::PushConstString);
+        bytes.push_back((uint8_t)GobLang::Operation::GetGlobalSlot);
         bytes.push_back((uint8_t)nameId);
-        bytes.push_back((uint8_t)GobLang::Operation::Get);
+        bytes.push_back((uint8_t)Operation::Call);
     }
-    bytes.push_back((uint8_t)Operation::Call);
     return std::make_unique<GeneratedCodeGenValue>(std::move(bytes));
 }
 
@@ -231,6 +245,22 @@ std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::Builder::creat
     return std::make_unique<GeneratedCodeGenValue>(std::move(bytes));
 }
 
+std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::Builder::createMethodCall(
+    std::unique_ptr<FieldAccessCodeGenValue> method,
+    std::vector<std::unique_ptr<CodeGenValue>> args)
+{
+    std::vector<uint8_t> bytes;
+
+    for (std::vector<std::unique_ptr<CodeGenValue>>::const_reverse_iterator it = args.rbegin(); it != args.rend(); it++)
+    {
+        std::vector<uint8_t> argBytes = (*it)->getGetOperationBytes();
+        bytes.insert(bytes.begin(), argBytes.begin(), argBytes.end());
+    }
+    std::vector<uint8_t> callBytes = method->getCallOperationBytes();
+    bytes.insert(bytes.end(), callBytes.begin(), callBytes.end());
+    return std::make_unique<GeneratedCodeGenValue>(std::move(bytes));
+}
+
 std::unique_ptr<GobLang::Codegen::ArrayAccessCodeGenValue> GobLang::Codegen::Builder::createArrayAccess(
     std::unique_ptr<CodeGenValue> array,
     std::unique_ptr<CodeGenValue> index)
@@ -240,9 +270,13 @@ std::unique_ptr<GobLang::Codegen::ArrayAccessCodeGenValue> GobLang::Codegen::Bui
 
 std::unique_ptr<GobLang::Codegen::FieldAccessCodeGenValue> GobLang::Codegen::Builder::createFieldAccess(
     std::unique_ptr<CodeGenValue> object,
-    std::unique_ptr<CodeGenValue> field)
+    size_t fieldNameId)
 {
-    return std::make_unique<FieldAccessCodeGenValue>(object->getGetOperationBytes(), field->getGetOperationBytes());
+    if (m_fieldCacheCount > UINT16_MAX)
+    {
+        throw ParsingError(0, 0, "Too many field accesses, field access inline caches are limited to 65536");
+    }
+    return std::make_unique<FieldAccessCodeGenValue>(object->getGetOperationBytes(), fieldNameId, m_fieldCacheCount++);
 }
 
 std::unique_ptr<GobLang::Codegen::VariableCodeGenValue> GobLang::Codegen::Builder::createVariableAccess(size_t nameId)
@@ -54,13 +54,31 @@ namespace GobLang::Codegen
             std::unique_ptr<CodeGenValue> value,
             std::vector<std::unique_ptr<CodeGenValue>> args);
 
+        /**
+         * @brief Create a call of the object method, which receives the object as the last argument
+         *
+         * @param method Access to the method field of the object
+         * @param args Arguments of the call
+         * @return std::unique_ptr<CodeGenValue>
+         */
+        std::unique_ptr<CodeGenValue> createMethodCall(
+            std::unique_ptr<FieldAccessCodeGenValue> method,
+            std::vector<std::unique_ptr<CodeGenValue>> args);
+
         std::unique_ptr<ArrayAccessCodeGenValue> createArrayAccess(
             std::unique_ptr<CodeGenValue> array,
             std::unique_ptr<CodeGenValue> index);
 
+        /**
+         * @brief Create access to the field with a name known at compile time. Every access gets its own inline cache
+         *
+         * @param object Object which field is accessed
+         * @param fieldNameId Id of the field name string
+         * @return std::unique_ptr<FieldAccessCodeGenValue>
+         */
         std::unique_ptr<FieldAccessCodeGenValue> createFieldAccess(
             std::unique_ptr<CodeGenValue> object,
-            std::unique_ptr<CodeGenValue> field);
+            size_t fieldNameId);
 
         std::unique_ptr<VariableCodeGenValue> createVariableAccess(size_t nameId);
 
@@ -85,11 +103,16 @@ namespace GobLang::Codegen
 
         std::vector<Struct::Structure> getTypes() const;
 
+        /// @brief How many field access inline caches were used by the generated code
+        size_t getFieldCacheCount() const { return m_fieldCacheCount; }
+
     private:
         std::vector<std::unique_ptr<BlockContext>> m_blocks;
 
         std::vector<std::unique_ptr<Function>> m_functions;
 
         std::vector<std::unique_ptr<TypeCodeGenInfo>> m_types;
+
+        size_t m_fieldCacheCount = 0;
     };
 } // namespace Goblang::Codegen
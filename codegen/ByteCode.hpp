@@ -12,5 +12,11 @@ namespace GobLang::Codegen
         std::vector<uint8_t> operations;
         std::vector<Function> functions;
         std::vector<Struct::Structure> structures;
+        /// @brief How many field access inline caches are used by the operations
+        size_t fieldCacheCount = 0;
+        /// @brief Max amount of local variables of the main code, which are created when the code starts. Zero if unknown
+        size_t maxLocalCount = 0;
+        /// @brief Max amount of operands the main code keeps on the stack. Zero if unknown
+        size_t maxStackDepth = 0;
     };
 }
\ No newline at end of file
@@ -15,9 +15,7 @@ std::vector<uint8_t> GobLang::Codegen::VariableCodeGenValue::getGetOperationByte
 {
     if (!m_local)
     {
-        return {(uint8_t)Operation::PushConstString,
-                (uint8_t)m_id,
-                (uint8_t)Operation::Get};
+        return {(uint8_t)Operation::GetGlobalSlot, (uint8_t)m_id};
     }
     return {(uint8_t)Operation::GetLocal, (uint8_t)m_id};
 }
@@ -26,9 +24,7 @@ std::vector<uint8_t> GobLang::Codegen::VariableCodeGenValue::getSetOperationByte
 {
     if (!m_local)
     {
-        return {(uint8_t)Operation::PushConstString,
-                (uint8_t)m_id,
-                (uint8_t)Operation::Set};
+        return {(uint8_t)Operation::SetGlobalSlot, (uint8_t)m_id};
     }
     return {(uint8_t)Operation::SetLocal, (uint8_t)m_id};
 }
@@ -187,27 +183,44 @@ std::vector<uint8_t> GobLang::Codegen::FunctionCodeGenValue::getGetOperationByte
 
 GobLang::Codegen::FieldAccessCodeGenValue::FieldAccessCodeGenValue(
     std::vector<uint8_t> object,
-    std::vector<uint8_t> fieldBytes) : m_objectBytes(std::move(object)),
-                                       m_fieldBytes(std::move(fieldBytes))
+    size_t fieldNameId,
+    size_t cacheId) : m_objectBytes(std::move(object)),
+                      m_fieldNameId(fieldNameId),
+                      m_cacheId(cacheId)
 {
 }
 
 std::vector<uint8_t> GobLang::Codegen::FieldAccessCodeGenValue::getGetOperationBytes()
 {
-    std::vector<uint8_t> bytes = m_fieldBytes;
-    bytes.insert(bytes.end(), m_objectBytes.begin(), m_objectBytes.end());
-    bytes.push_back((uint8_t)Operation::GetField);
+    std::vector<uint8_t> bytes = m_objectBytes;
+    bytes.push_back((uint8_t)Operation::GetFieldSlot);
+    _appendFieldSlotArgs(bytes);
     return bytes;
 }
 
 std::vector<uint8_t> GobLang::Codegen::FieldAccessCodeGenValue::getSetOperationBytes()
 {
-    std::vector<uint8_t> bytes = m_fieldBytes;
-    bytes.insert(bytes.end(), m_objectBytes.begin(), m_objectBytes.end());
-    bytes.push_back((uint8_t)Operation::SetField);
+    std::vector<uint8_t> bytes = m_objectBytes;
+    bytes.push_back((uint8_t)Operation::SetFieldSlot);
+    _appendFieldSlotArgs(bytes);
     return bytes;
 }
 
+std::vector<uint8_t> GobLang::Codegen::FieldAccessCodeGenValue::getCallOperationBytes()
+{
+    std::vector<uint8_t> bytes = m_objectBytes;
+    bytes.push_back((uint8_t)Operation::CallMethodSlot);
+    _appendFieldSlotArgs(bytes);
+    return bytes;
+}
+
+void GobLang::Codegen::FieldAccessCodeGenValue::_appendFieldSlotArgs(std::vector<uint8_t> &bytes) const
+{
+    bytes.push_back((uint8_t)m_fieldNameId);
+    bytes.push_back((uint8_t)(m_cacheId >> 8));
+    bytes.push_back((uint8_t)m_cacheId);
+}
+
 GobLang::Codegen::TypeCodeGenInfo::TypeCodeGenInfo(
     size_t nameId,
     std::vector<size_t> fieldIds,
@@ -212,13 +212,22 @@ namespace GobLang::Codegen
     class FieldAccessCodeGenValue : public CodeGenValue
     {
     public:
-        explicit FieldAccessCodeGenValue(std::vector<uint8_t> object, std::vector<uint8_t> fieldBytes);
+        explicit FieldAccessCodeGenValue(std::vector<uint8_t> object, size_t fieldNameId, size_t cacheId);
         std::vector<uint8_t> getGetOperationBytes() override;
 
         std::vector<uint8_t> getSetOperationBytes() override;
 
+        /// @brief Get bytes that call the field as a method of the object
+        std::vector<uint8_t> getCallOperationBytes();
+
     private:
+        /// @brief Append field name and inline cache ids to the operation bytes
+        /// @param bytes Bytes to append to
+        void _appendFieldSlotArgs(std::vector<uint8_t> &bytes) const;
+
         std::vector<uint8_t> m_objectBytes;
-        std::vector<uint8_t> m_fieldBytes;
+        size_t m_fieldNameId;
+        /// @brief Id of the inline cache used by the interpreter to remember where the field is located
+        size_t m_cacheId;
     };
 } // namespace GobLang::Codegen
@@ -1,4 +1,5 @@
 #include "CodeGenerator.hpp"
+#include <optional>
 
 using namespace GobLang::Codegen;
 
@@ -54,9 +55,93 @@ ByteCode GobLang::Codegen::CodeGenerator::getByteCode()
     }
     result.operations.insert(result.operations.end(), funcBytes.begin(), funcBytes.end());
     result.structures = builder.getTypes();
+    result.fieldCacheCount = builder.getFieldCacheCount();
+    computeFrameSizes(result);
     return result;
 }
 
+void GobLang::Codegen::CodeGenerator::computeFrameSizes(ByteCode &code)
+{
+    // functions are placed one after another after the main code, so every frame ends where the next one starts
+    size_t mainEnd = code.functions.empty() ? code.operations.size() : code.functions.front().start;
+    FrameSize main = getFrameSize(code.operations, 0, mainEnd, 0);
+    code.maxLocalCount = main.localCount;
+    code.maxStackDepth = main.stackDepth;
+    for (size_t i = 0; i < code.functions.size(); i++)
+    {
+        size_t end = i + 1 < code.functions.size() ? code.functions[i + 1].start : code.operations.size();
+        FrameSize size = getFrameSize(code.operations, code.functions[i].start, end, code.functions[i].arguments.size());
+        code.functions[i].maxLocalCount = size.localCount;
+        code.functions[i].maxStackDepth = size.stackDepth;
+    }
+}
+
+GobLang::Codegen::CodeGenerator::FrameSize GobLang::Codegen::CodeGenerator::getFrameSize(
+    std::vector<uint8_t> const &operations,
+    size_t start,
+    size_t end,
+    size_t argCount)
+{
+    FrameSize size{.localCount = argCount, .stackDepth = 0};
+    // max amount of operands at the start of every operation, which is only known for operations that were reached
+    std::vector<std::optional<size_t>> depths(end - start);
+    std::vector<std::pair<size_t, size_t>> pending = {{start, 0}};
+    while (!pending.empty())
+    {
+        auto [address, depth] = pending.back();
+        pending.pop_back();
+        if (address < start || address >= end)
+        {
+            throw ParsingError(0, 0, "Generated code leaves the function at " + std::to_string(address));
+        }
+        if (depths[address - start].has_value() && depths[address - start].value() >= depth)
+        {
+            continue;
+        }
+        depths[address - start] = depth;
+        EncodedOperation operation = decodeOperation(operations, address);
+        StackEffect effect = getStackEffect(operation.op, operation.arg, operation.arg2);
+        if (depth < effect.pops)
+        {
+            throw ParsingError(0, 0, "Generated code pops from an empty stack at " + std::to_string(address));
+        }
+        depth = effect.clear ? 0 : depth - effect.pops + effect.maxPushes;
+        size.stackDepth = std::max(size.stackDepth, depth);
+        if (operation.op == Operation::SetLocal)
+        {
+            size.localCount = std::max(size.localCount, (size_t)operation.arg + 1);
+        }
+        size_t next = address + 1 + operation.argSize;
+        switch (operation.op)
+        {
+        case Operation::Jump:
+            pending.emplace_back(address + operation.arg, depth);
+            break;
+        case Operation::JumpBack:
+            // loops are statements, which leave no operands behind, so the start of the loop was already reached with the same depth.
+            // native calls consume their own arguments, which static effects don't see, so following the jump would only grow the estimate
+            if (operation.arg > address - start)
+            {
+                throw ParsingError(0, 0, "Generated code leaves the function at " + std::to_string(address));
+            }
+            break;
+        case Operation::JumpIf:
+        case Operation::JumpIfNot:
+            pending.emplace_back(address + operation.arg, depth);
+            pending.emplace_back(next, depth);
+            break;
+        case Operation::Return:
+        case Operation::ReturnValue:
+        case Operation::End:
+            break;
+        default:
+            pending.emplace_back(next, depth);
+            break;
+        }
+    }
+    return size;
+}
+
 std::unique_ptr<FunctionNode> GobLang::Codegen::CodeGenerator::parseFunctionDefinition()
 {
     consumeKeyword(Keyword::Function, "Expected 'func'");
@@ -189,7 +274,7 @@ std::unique_ptr<CodeNode> GobLang::Codegen::CodeGenerator::parseStandaloneExpres
         return val;
     }
     consumeSeparator(Separator::End, "Expected ';'");
-    return expr;
+    return std::make_unique<ExpressionStatementNode>(std::move(expr));
 }
 
 std::unique_ptr<ArrayLiteralNode> GobLang::Codegen::CodeGenerator::parseArrayLiteral()
@@ -361,9 +446,9 @@ std::unique_ptr<CodeNode> GobLang::Codegen::CodeGenerator::parseIdExpression(std
         {
             advance();
             IdToken const *t = getTokenOrError<IdToken>("Expected an identifier");
-            std::unique_ptr<CodeNode> id = std::make_unique<StringNode>(t->getId());
+            size_t fieldNameId = t->getId();
             advance();
-            value = std::make_unique<FieldAccessNode>(std::move(value), std::move(id));
+            value = std::make_unique<FieldAccessNode>(std::move(value), fieldNameId);
         }
         else
         {
@@ -16,6 +16,29 @@ namespace GobLang::Codegen
 
         ByteCode getByteCode();
 
+        /// @brief Max amount of local variables and operands of a single frame
+        struct FrameSize
+        {
+            size_t localCount;
+            size_t stackDepth;
+        };
+
+        /// @brief Find out how many local variables and operands the main code and every function use at most, which lets the interpreter reserve the whole frame at once
+        /// @param code Generated code, which gets the sizes
+        void computeFrameSizes(ByteCode &code);
+
+        /**
+         * @brief Follow every path through the code of a frame to find its size, throwing `ParsingError` if the generated code
+         * can pop from an empty stack or jumps outside of the frame. Jumps back are not followed, since loops start and end with no operands
+         *
+         * @param operations Generated byte code
+         * @param start Address of the first operation of the frame
+         * @param end Address right after the last operation of the frame
+         * @param argCount Amount of arguments, which are the local variables the frame starts with
+         * @return FrameSize Size of the frame, assuming that every call leaves at most one value
+         */
+        static FrameSize getFrameSize(std::vector<uint8_t> const &operations, size_t start, size_t end, size_t argCount);
+
         std::unique_ptr<FunctionNode> parseFunctionDefinition();
 
         std::unique_ptr<FunctionPrototypeNode> parseFunctionPrototype();
@@ -267,6 +267,16 @@ std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::FunctionCallNo
     {
         args.push_back((*it)->generateCode(builder));
     }
+    // functions defined by the user are called directly if they are called by name
+    if (IdNode *id = dynamic_cast<IdNode *>(m_value.get()); id != nullptr && builder.hasLocalFunctionWithName(id->getId()))
+    {
+        return builder.createCall(id->getId(), std::move(args));
+    }
+    // methods are called without getting them as a value, which would create a bound function object for native methods
+    if (FieldAccessNode *field = dynamic_cast<FieldAccessNode *>(m_value.get()); field != nullptr)
+    {
+        return builder.createMethodCall(field->generateFieldAccess(builder), std::move(args));
+    }
     return builder.createCallFromValue(
         std::make_unique<GeneratedCodeGenValue>(m_value->generateCode(builder)->getGetOperationBytes()),
         std::move(args));
@@ -616,6 +626,23 @@ std::string GobLang::Codegen::ReturnNode::toString()
     return R"({"type" : "ret", "expr" : )" + m_val->toString() + "}";
 }
 
+GobLang::Codegen::ExpressionStatementNode::ExpressionStatementNode(std::unique_ptr<CodeNode> expr) : m_expr(std::move(expr))
+{
+}
+
+std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::ExpressionStatementNode::generateCode(Builder &builder)
+{
+    std::vector<uint8_t> bytes = m_expr->generateCode(builder)->getGetOperationBytes();
+    // calls leave either their result or nothing, so the whole operand stack of the statement is removed instead of a single value
+    bytes.push_back((uint8_t)Operation::Discard);
+    return std::make_unique<GeneratedCodeGenValue>(std::move(bytes));
+}
+
+std::string GobLang::Codegen::ExpressionStatementNode::toString()
+{
+    return m_expr->toString();
+}
+
 GobLang::Codegen::CharacterNode::CharacterNode(char ch) : m_char(ch)
 {
 }
@@ -681,19 +708,19 @@ std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::UnaryOperation
 
 GobLang::Codegen::FieldAccessNode::FieldAccessNode(
     std::unique_ptr<CodeNode> left,
-    std::unique_ptr<CodeNode> right) : m_left(std::move(left)),
-                                       m_right(std::move(right))
+    size_t fieldNameId) : m_left(std::move(left)),
+                          m_fieldNameId(fieldNameId)
 {
 }
 
 std::string GobLang::Codegen::FieldAccessNode::toString()
 {
-    return R"({"type" : "getfield", "left":)" + m_left->toString() + ", \"right\": " + m_right->toString() + "}";
+    return R"({"type" : "getfield", "left":)" + m_left->toString() + ", \"right\": {\"str\": " + std::to_string(m_fieldNameId) + "}}";
 }
 
-std::unique_ptr<GobLang::Codegen::CodeGenValue> GobLang::Codegen::FieldAccessNode::generateCode(Builder &builder)
+std::unique_ptr<GobLang::Codegen::FieldAccessCodeGenValue> GobLang::Codegen::FieldAccessNode::generateFieldAccess(Builder &builder)
 {
-    return builder.createFieldAccess(m_left->generateCode(builder), m_right->generateCode(builder));
+    return builder.createFieldAccess(m_left->generateCode(builder), m_fieldNameId);
 }
 
 GobLang::Codegen::TypeDefinitionNode::TypeDefinitionNode(
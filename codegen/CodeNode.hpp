@@ -24,6 +24,8 @@ namespace GobLang::Codegen
         std::unique_ptr<CodeGenValue> generateCode(Builder &builder) override;
         std::string toString() override;
 
+        size_t getId() const { return m_id; }
+
     private:
         size_t m_id;
     };
@@ -141,6 +143,18 @@ namespace GobLang::Codegen
         std::unique_ptr<CodeNode> m_val;
     };
 
+    /// @brief Expression used as a statement, whose value is removed from the stack once it is calculated
+    class ExpressionStatementNode : public CodeNode
+    {
+    public:
+        explicit ExpressionStatementNode(std::unique_ptr<CodeNode> expr);
+        std::unique_ptr<CodeGenValue> generateCode(Builder &builder) override;
+        std::string toString() override;
+
+    private:
+        std::unique_ptr<CodeNode> m_expr;
+    };
+
     class SequenceNode : public CodeNode
     {
     public:
@@ -172,13 +186,15 @@ namespace GobLang::Codegen
     class FieldAccessNode : public CodeNode
     {
     public:
-        explicit FieldAccessNode(std::unique_ptr<CodeNode> left, std::unique_ptr<CodeNode> right);
+        explicit FieldAccessNode(std::unique_ptr<CodeNode> left, size_t fieldNameId);
         std::string toString() override;
-        std::unique_ptr<CodeGenValue> generateCode(Builder &builder) override;
+        std::unique_ptr<CodeGenValue> generateCode(Builder &builder) override { return generateFieldAccess(builder); }
+
+        std::unique_ptr<FieldAccessCodeGenValue> generateFieldAccess(Builder &builder);
 
     private:
         std::unique_ptr<CodeNode> m_left;
-        std::unique_ptr<CodeNode> m_right;
+        size_t m_fieldNameId;
     };
     class BinaryOperationNode : public CodeNode
     {
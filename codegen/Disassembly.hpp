@@ -72,6 +72,19 @@ namespace GobLang::Codegen
                     std::cout << std::hex << val << std::dec;
                 }
                 break;
+                case OperatorArgType::FieldSlot:
+                {
+                    uint16_t cacheId = parseBytesIntoValue<uint16_t>(it + 2, bytecode.end());
+                    std::cout << std::to_string(*(it + 1)) << " " << cacheId;
+                    it += 1 + sizeof(uint16_t);
+                    address += 1 + sizeof(uint16_t);
+                }
+                break;
+                case OperatorArgType::LocalCall:
+                    std::cout << std::to_string(*(it + 1)) << " " << std::to_string(*(it + 2));
+                    it += 2;
+                    address += 2;
+                    break;
                 case OperatorArgType::UnsignedInt:
                 {
                     uint32_t val = parseBytesIntoValue<uint32_t>(it + 1, bytecode.end());
@@ -1,57 +1,45 @@
 #include "Array.hpp"
 #include "Value.hpp"
 #include "Exception.hpp"
-GobLang::ArrayNode::ArrayNode(size_t size)
+#include "GarbageCollector.hpp"
+GobLang::ArrayNode::ArrayNode(size_t size, ArrayElementType type) : MemoryNode(Kind), m_elementType(type), m_size(size)
 {
-    m_data = std::vector<Value>(size);
-}
-void GobLang::ArrayNode::setItem(size_t i, Value const &item)
-{
-    if (i >= m_data.size())
-    {
-        throw RuntimeException(
-            std::string("Attempted to read out of bounds of the array. i = ") +
-            std::to_string(i) +
-            " in array of size " +
-            std::to_string(m_data.size()));
-    }
-    // check if object that we are setting is itself to avoid creating a ref cycle
-    if ((Type)item.index() == Type::MemoryObj && std::get<MemoryNode *>(item) != this)
+    if (isPacked())
     {
-        std::get<MemoryNode *>(item)->increaseRefCount();
+        m_packed = std::vector<uint8_t>(size * _getElementSize(type));
     }
-    if ((Type)m_data[i].index() == Type::MemoryObj && std::get<MemoryNode *>(m_data[i]) != this)
+    else
     {
-        std::get<MemoryNode *>(m_data[i])->decreaseRefCount();
+        m_data = std::vector<Value>(size);
     }
-    m_data[i] = item;
 }
 
-GobLang::Value *GobLang::ArrayNode::getItem(size_t i)
+GobLang::ArrayElementType GobLang::ArrayNode::getElementTypeOf(Value const &value)
 {
-
-    if (i < m_data.size())
-    {
-        return &m_data[i];
-    }
-    else
+    switch (value.getType())
     {
-        throw RuntimeException(
-            std::string("Attempted to read out of bounds of the array. i = ") +
-            std::to_string(i) +
-            " in array of size " +
-            std::to_string(m_data.size()));
-        return nullptr;
+    case Type::Int:
+        return ArrayElementType::Int;
+    case Type::UnsignedInt:
+        return ArrayElementType::UnsignedInt;
+    case Type::Float:
+        return ArrayElementType::Float;
+    case Type::Char:
+        return ArrayElementType::Char;
+    case Type::Bool:
+        return ArrayElementType::Bool;
+    default:
+        return ArrayElementType::Generic;
     }
 }
 
 std::string GobLang::ArrayNode::toString(bool pretty, size_t depth)
 {
     std::string text = "[";
-    for (size_t i = 0; i < m_data.size(); i++)
+    for (size_t i = 0; i < m_size; i++)
     {
-        text += valueToString(m_data[i], pretty, depth);
-        if (i != m_data.size() - 1)
+        text += valueToString(getItem(i), pretty, depth);
+        if (i != m_size - 1)
         {
             text += ",";
         }
@@ -61,21 +49,106 @@ std::string GobLang::ArrayNode::toString(bool pretty, size_t depth)
 
 void GobLang::ArrayNode::append(Value const &item)
 {
-    // check if object that we are setting is itself to avoid creating a ref cycle
-    if ((Type)item.index() == Type::MemoryObj && std::get<MemoryNode *>(item) != this)
+    if (isPacked() && getElementTypeOf(item) == m_elementType)
     {
-        std::get<MemoryNode *>(item)->increaseRefCount();
+        m_packed.resize(m_packed.size() + _getElementSize(m_elementType));
+        m_size++;
+        setItem(m_size - 1, item);
+        return;
     }
+    _unpack();
+    _writeBarrier(item);
     m_data.push_back(item);
+    m_size++;
+    _markItemDirty(m_size - 1);
 }
 
-GobLang::ArrayNode::~ArrayNode()
+void GobLang::ArrayNode::trace(GarbageCollector &gc)
 {
-    for (std::vector<Value>::iterator it = m_data.begin(); it != m_data.end(); it++)
+    for (Value const &item : m_data)
     {
-        if ((Type)it->index() == Type::MemoryObj)
+        gc.markValue(item);
+    }
+}
+
+void GobLang::ArrayNode::traceRemembered(GarbageCollector &gc)
+{
+    if (m_dirtyItems.size() >= m_data.size())
+    {
+        trace(gc);
+    }
+    else
+    {
+        for (size_t i : m_dirtyItems)
         {
-            std::get<MemoryNode *>((*it))->decreaseRefCount();
+            gc.markValue(m_data[i]);
         }
     }
 }
+
+void GobLang::ArrayNode::forget()
+{
+    MemoryNode::forget();
+    m_dirtyItems.clear();
+}
+
+size_t GobLang::ArrayNode::_getElementSize(ArrayElementType type)
+{
+    switch (type)
+    {
+    case ArrayElementType::Int:
+        return sizeof(int32_t);
+    case ArrayElementType::UnsignedInt:
+        return sizeof(uint32_t);
+    case ArrayElementType::Float:
+        return sizeof(float);
+    case ArrayElementType::Char:
+        return sizeof(char);
+    case ArrayElementType::Bool:
+        return sizeof(bool);
+    default:
+        return sizeof(Value);
+    }
+}
+
+void GobLang::ArrayNode::_setGenericItem(size_t i, Value const &item)
+{
+    _unpack();
+    _writeBarrier(item);
+    _markItemDirty(i);
+    m_data[i] = item;
+}
+
+void GobLang::ArrayNode::_unpack()
+{
+    if (!isPacked())
+    {
+        return;
+    }
+    std::vector<Value> data;
+    data.reserve(m_size);
+    for (size_t i = 0; i < m_size; i++)
+    {
+        data.push_back(getItem(i));
+    }
+    m_data = std::move(data);
+    m_packed = std::vector<uint8_t>();
+    m_elementType = ArrayElementType::Generic;
+}
+
+void GobLang::ArrayNode::_throwOutOfBounds(size_t i) const
+{
+    throw RuntimeException(
+        std::string("Attempted to read out of bounds of the array. i = ") +
+        std::to_string(i) +
+        " in array of size " +
+        std::to_string(m_size));
+}
+
+void GobLang::ArrayNode::_markItemDirty(size_t i)
+{
+    if (isRemembered() && m_dirtyItems.size() < m_data.size())
+    {
+        m_dirtyItems.push_back(i);
+    }
+}
@@ -1,25 +1,195 @@
 #pragma once
+#include <cstring>
 #include "Memory.hpp"
+#include "Value.hpp"
 
 namespace GobLang
 {
+    /**
+     * @brief Type of the elements that array stores. Arrays of primitive types store elements without the type, which makes them smaller
+     * and avoids checking the type of every element
+     *
+     */
+    enum class ArrayElementType : uint8_t
+    {
+        /// @brief Array stores values of any type
+        Generic,
+        Int,
+        UnsignedInt,
+        Float,
+        Char,
+        Bool,
+    };
+
     class ArrayNode : public MemoryNode
     {
     public:
-        explicit ArrayNode(size_t size);
+        static constexpr MemoryNodeKind Kind = MemoryNodeKind::Array;
+
+        /**
+         * @brief Create array of a given size
+         *
+         * @param size Size of the array
+         * @param type Type of the elements. Generic arrays are filled with null, while packed arrays are filled with zeroes of the element type
+         */
+        explicit ArrayNode(size_t size, ArrayElementType type = ArrayElementType::Generic);
+
+        /**
+         * @brief Get type of the packed array that could store the value
+         *
+         * @param value Value to check
+         * @return ArrayElementType Element type or generic if value can't be stored in a packed array
+         */
+        static ArrayElementType getElementTypeOf(Value const &value);
 
-        void setItem(size_t i, Value const &item);
-        Value *getItem(size_t i);
+        /// @brief Get type of the elements stored in the array
+        ArrayElementType getElementType() const { return m_elementType; }
+
+        /// @brief Whether array stores elements without their type
+        bool isPacked() const { return m_elementType != ArrayElementType::Generic; }
+
+        /**
+         * @brief Set item of the array. Storing a value of a different type into a packed array converts it into a generic array
+         *
+         * @param i Id of the item
+         * @param item Value to store
+         */
+        void setItem(size_t i, Value const &item)
+        {
+            if (i >= m_size)
+            {
+                _throwOutOfBounds(i);
+            }
+            switch (m_elementType)
+            {
+            case ArrayElementType::Int:
+                if (item.is<int32_t>())
+                {
+                    _setPacked(i, item.as<int32_t>());
+                    return;
+                }
+                break;
+            case ArrayElementType::UnsignedInt:
+                if (item.is<uint32_t>())
+                {
+                    _setPacked(i, item.as<uint32_t>());
+                    return;
+                }
+                break;
+            case ArrayElementType::Float:
+                if (item.is<float>())
+                {
+                    _setPacked(i, item.as<float>());
+                    return;
+                }
+                break;
+            case ArrayElementType::Char:
+                if (item.is<char>())
+                {
+                    _setPacked(i, item.as<char>());
+                    return;
+                }
+                break;
+            case ArrayElementType::Bool:
+                if (item.is<bool>())
+                {
+                    _setPacked(i, item.as<bool>());
+                    return;
+                }
+                break;
+            case ArrayElementType::Generic:
+                break;
+            }
+            _setGenericItem(i, item);
+        }
+
+        /**
+         * @brief Get item of the array
+         *
+         * @param i Id of the item
+         * @return Value Value of the item
+         */
+        Value getItem(size_t i) const
+        {
+            if (i >= m_size)
+            {
+                _throwOutOfBounds(i);
+            }
+            switch (m_elementType)
+            {
+            case ArrayElementType::Int:
+                return Value(_getPacked<int32_t>(i));
+            case ArrayElementType::UnsignedInt:
+                return Value(_getPacked<uint32_t>(i));
+            case ArrayElementType::Float:
+                return Value(_getPacked<float>(i));
+            case ArrayElementType::Char:
+                return Value(_getPacked<char>(i));
+            case ArrayElementType::Bool:
+                return Value(_getPacked<bool>(i));
+            case ArrayElementType::Generic:
+                break;
+            }
+            return m_data[i];
+        }
 
         std::string toString(bool pretty, size_t depth) override;
 
-        size_t getSize() const { return m_data.size(); }
+        size_t getSize() const { return m_size; }
+
+        void append(Value const &item);
 
-        void append(Value const& item);
+        void trace(GarbageCollector &gc) override;
 
-        virtual ~ArrayNode();
+        void traceRemembered(GarbageCollector &gc) override;
+
+        void forget() override;
+
+        virtual ~ArrayNode() = default;
 
     private:
+        /// @brief Get size of a single element of packed array in bytes
+        static size_t _getElementSize(ArrayElementType type);
+
+        template <typename T>
+        T _getPacked(size_t i) const
+        {
+            T val;
+            std::memcpy(&val, m_packed.data() + i * sizeof(T), sizeof(T));
+            return val;
+        }
+
+        template <typename T>
+        void _setPacked(size_t i, T val)
+        {
+            std::memcpy(m_packed.data() + i * sizeof(T), &val, sizeof(T));
+        }
+
+        /// @brief Store value in the generic storage, converting packed array into a generic one if needed
+        /// @param i Id of the item
+        /// @param item Value to store
+        void _setGenericItem(size_t i, Value const &item);
+
+        /// @brief Move all elements from packed storage into generic storage
+        void _unpack();
+
+        [[noreturn]] void _throwOutOfBounds(size_t i) const;
+
+        /// @brief Record that item was written while array is in the remembered set
+        /// @param i Id of the item
+        void _markItemDirty(size_t i);
+
+        ArrayElementType m_elementType;
+        size_t m_size;
+        /// @brief Items of generic arrays
         std::vector<Value> m_data;
+        /// @brief Items of packed arrays stored one after another without their types
+        std::vector<uint8_t> m_packed;
+        /**
+         * @brief Ids of items that were written while array was in the remembered set.
+         * Once there are as many entries as there are items every item is traced instead
+         *
+         */
+        std::vector<size_t> m_dirtyItems;
     };
 } // namespace SimpleLang
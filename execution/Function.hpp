@@ -59,5 +59,13 @@ namespace GobLang
          * @brief Which address to jump to when calling this function
          */
         size_t start;
+        /**
+         * @brief Max amount of local variables of the function, including the arguments, which are created when the function is called. Zero if unknown
+         */
+        size_t maxLocalCount = 0;
+        /**
+         * @brief Max amount of operands the function keeps on the stack. Zero if unknown
+         */
+        size_t maxStackDepth = 0;
     };
 } // namespace GobLang
@@ -1,10 +1,16 @@
 #include "FunctionRef.hpp"
+#include "GarbageCollector.hpp"
 
-GobLang::FunctionRef::FunctionRef(FunctionValue const * func, MemoryNode *owner) : m_func(func), m_owner(owner)
+GobLang::FunctionRef::FunctionRef(FunctionValue const * func, MemoryNode *owner) : MemoryNode(Kind), m_func(func), m_owner(owner)
 {
 
 }
 
-GobLang::FunctionRef::FunctionRef(size_t localFuncId) : m_localFuncId(localFuncId)
+GobLang::FunctionRef::FunctionRef(size_t localFuncId) : MemoryNode(Kind), m_localFuncId(localFuncId)
 {
 }
+
+void GobLang::FunctionRef::trace(GarbageCollector &gc)
+{
+    gc.markObject(m_owner);
+}
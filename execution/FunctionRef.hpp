@@ -6,6 +6,8 @@ namespace GobLang
     class FunctionRef : public MemoryNode
     {
     public:
+        static constexpr MemoryNodeKind Kind = MemoryNodeKind::FunctionRef;
+
         explicit FunctionRef(FunctionValue const *func, MemoryNode *owner = nullptr);
         explicit FunctionRef(size_t localFuncId);
         bool hasOwner() const { return m_owner != nullptr; }
@@ -14,11 +16,14 @@ namespace GobLang
         MemoryNode *getOwner() { return m_owner; }
         FunctionValue const *getFunction() const { return m_func; }
 
+        /// @brief Bound functions keep their owner alive
+        void trace(GarbageCollector &gc) override;
+
     private:
         /// @brief The object that owns this function. If null then this function is static
-        MemoryNode *m_owner;
+        MemoryNode *m_owner = nullptr;
         /// @brief The actual function object. Either an int to reference id of a function or NativeFunction object
-        FunctionValue const *m_func;
+        FunctionValue const *m_func = nullptr;
 
         size_t m_localFuncId = -1;
     };
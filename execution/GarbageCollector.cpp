@@ -0,0 +1,277 @@
+#include "GarbageCollector.hpp"
+#include "String.hpp"
+
+void GobLang::GcPauseHistogram::record(std::chrono::nanoseconds pause)
+{
+    size_t bucket = 0;
+    for (int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(pause).count(); micros > 0 && bucket < BucketCount - 1; micros >>= 1)
+    {
+        bucket++;
+    }
+    buckets[bucket]++;
+    pauseCount++;
+    longestPause = std::max(longestPause, pause);
+    totalPauseTime += pause;
+}
+
+void GobLang::GarbageCollector::addObject(MemoryNode *obj)
+{
+    if (!obj->isRegistered())
+    {
+        m_youngTail->insert(obj);
+        m_youngTail = obj;
+        obj->registerGC(this);
+        m_youngCount++;
+    }
+}
+
+void GobLang::GarbageCollector::rememberObject(MemoryNode *obj)
+{
+    if (!obj->isRemembered())
+    {
+        obj->remember();
+        m_rememberedObjects.push_back(obj);
+    }
+}
+
+void GobLang::GarbageCollector::startCollection(bool full)
+{
+    m_fullCollection = full;
+}
+
+void GobLang::GarbageCollector::markValue(Value const &val)
+{
+    if (val.getType() == Type::MemoryObj)
+    {
+        markObject(val.as<MemoryNode *>());
+    }
+}
+
+void GobLang::GarbageCollector::markObject(MemoryNode *obj)
+{
+    // during minor collection old objects are considered alive and are not traced
+    if (obj != nullptr && !obj->isMarked() && (m_fullCollection || !obj->isOld()))
+    {
+        obj->mark();
+        m_greyObjects.push_back(obj);
+    }
+}
+
+void GobLang::GarbageCollector::collect()
+{
+    if (!m_fullCollection)
+    {
+        for (MemoryNode *obj : m_rememberedObjects)
+        {
+            obj->traceRemembered(*this);
+        }
+    }
+    _trace();
+    // every young object that survives is promoted so nothing has to be remembered after collection
+    // this has to be cleared before sweeping because full collection might delete remembered objects
+    _clearRememberedObjects();
+    if (m_fullCollection)
+    {
+        _sweep(m_oldRoot, m_oldTail, m_oldCount, false);
+    }
+    _sweep(m_youngRoot, m_youngTail, m_youngCount, true);
+    if (m_fullCollection)
+    {
+        m_fullCollectionThreshold = m_oldCount * 2;
+    }
+}
+
+void GobLang::GarbageCollector::startIncrementalCollection()
+{
+    m_fullCollection = true;
+    m_phase = CollectionPhase::Marking;
+}
+
+bool GobLang::GarbageCollector::traceUntil(std::chrono::steady_clock::time_point deadline)
+{
+    size_t traced = 0;
+    while (!m_greyObjects.empty())
+    {
+        MemoryNode *obj = m_greyObjects.back();
+        m_greyObjects.pop_back();
+        obj->trace(*this);
+        if (++traced % ObjectsPerDeadlineCheck == 0 && std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+    }
+    return m_greyObjects.empty();
+}
+
+void GobLang::GarbageCollector::finishMarking()
+{
+    _trace();
+    _clearRememberedObjects();
+    // objects promoted from the young generation are appended after the current tail and are already unmarked, so they must not be swept
+    m_sweepCursor = m_oldRoot.getNext();
+    m_sweepEnd = m_oldTail;
+    _sweep(m_youngRoot, m_youngTail, m_youngCount, true);
+    m_fullCollection = false;
+    m_phase = CollectionPhase::Sweeping;
+}
+
+bool GobLang::GarbageCollector::sweepUntil(std::chrono::steady_clock::time_point deadline)
+{
+    size_t swept = 0;
+    while (m_sweepCursor != nullptr)
+    {
+        MemoryNode *curr = m_sweepCursor;
+        m_sweepCursor = curr == m_sweepEnd ? nullptr : curr->getNext();
+        _sweepObject(curr, m_oldTail, m_oldCount, false);
+        if (++swept % ObjectsPerDeadlineCheck == 0 && std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+    }
+    if (m_sweepCursor != nullptr)
+    {
+        return false;
+    }
+    m_sweepEnd = nullptr;
+    m_phase = CollectionPhase::Idle;
+    m_fullCollectionThreshold = m_oldCount * 2;
+    return true;
+}
+
+GobLang::StringNode *GobLang::GarbageCollector::findInternedString(std::string const &str)
+{
+    // strings that were not swept yet might be already dead and returning them would bring them back to life
+    if (m_phase == CollectionPhase::Sweeping)
+    {
+        return nullptr;
+    }
+    auto [begin, end] = m_internedStrings.equal_range(std::hash<std::string>{}(str));
+    for (std::unordered_multimap<size_t, StringNode *>::iterator it = begin; it != end; it++)
+    {
+        // strings can be modified after being interned so the contents have to be checked
+        if (it->second->getString() == str)
+        {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+void GobLang::GarbageCollector::internString(StringNode *str)
+{
+    size_t hash = std::hash<std::string>{}(str->getString());
+    str->markInterned(hash);
+    m_internedStrings.emplace(hash, str);
+}
+
+GobLang::GarbageCollector::~GarbageCollector()
+{
+    for (MemoryNode *root : {m_oldRoot.getNext(), m_youngRoot.getNext()})
+    {
+        while (root != nullptr)
+        {
+            MemoryNode *del = root;
+            root = root->getNext();
+            // slabs are freed all at once by the allocator
+            _destroyObject(del, false);
+        }
+    }
+}
+
+void GobLang::GarbageCollector::_removeInternedString(StringNode *str)
+{
+    auto [begin, end] = m_internedStrings.equal_range(str->getInternHash());
+    for (std::unordered_multimap<size_t, StringNode *>::iterator it = begin; it != end; it++)
+    {
+        if (it->second == str)
+        {
+            m_internedStrings.erase(it);
+            return;
+        }
+    }
+}
+
+void GobLang::GarbageCollector::_trace()
+{
+    while (!m_greyObjects.empty())
+    {
+        MemoryNode *obj = m_greyObjects.back();
+        m_greyObjects.pop_back();
+        obj->trace(*this);
+    }
+}
+
+void GobLang::GarbageCollector::_sweep(MemoryNode &root, MemoryNode *&tail, size_t &count, bool promote)
+{
+    MemoryNode *curr = root.getNext();
+    while (curr != nullptr)
+    {
+        MemoryNode *next = curr->getNext();
+        _sweepObject(curr, tail, count, promote);
+        curr = next;
+    }
+}
+
+void GobLang::GarbageCollector::_sweepObject(MemoryNode *obj, MemoryNode *&tail, size_t &count, bool promote)
+{
+    bool alive = obj->isMarked();
+    if (obj == tail && (!alive || promote))
+    {
+        tail = obj->getPrev();
+    }
+    if (alive)
+    {
+        obj->unmark();
+        if (promote)
+        {
+            obj->unlink();
+            obj->promote();
+            m_oldTail->insert(obj);
+            m_oldTail = obj;
+            count--;
+            m_oldCount++;
+        }
+    }
+    else
+    {
+        obj->unlink();
+        _deleteObject(obj);
+        count--;
+    }
+}
+
+void GobLang::GarbageCollector::_clearRememberedObjects()
+{
+    for (MemoryNode *obj : m_rememberedObjects)
+    {
+        obj->forget();
+    }
+    m_rememberedObjects.clear();
+}
+
+void GobLang::GarbageCollector::_deleteObject(MemoryNode *obj)
+{
+    if (StringNode *str = node_cast<StringNode>(obj); str != nullptr && str->isInterned())
+    {
+        _removeInternedString(str);
+    }
+    _destroyObject(obj, true);
+}
+
+void GobLang::GarbageCollector::_destroyObject(MemoryNode *obj, bool reuseMemory)
+{
+    uint32_t size = obj->getAllocationSize();
+    if (size == 0)
+    {
+        delete obj;
+        return;
+    }
+    if (!reuseMemory && SlabAllocator::isSlabAllocated(size))
+    {
+        obj->~MemoryNode();
+        return;
+    }
+    void *block = dynamic_cast<void *>(obj);
+    obj->~MemoryNode();
+    m_allocator.deallocate(block, size);
+}
@@ -0,0 +1,292 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include "Value.hpp"
+#include "Memory.hpp"
+#include "SlabAllocator.hpp"
+
+namespace GobLang
+{
+    class StringNode;
+
+    /**
+     * @brief Distribution of the time that interpreter spent in the garbage collector per single pause
+     *
+     */
+    struct GcPauseHistogram
+    {
+        static constexpr size_t BucketCount = 20;
+        /**
+         * @brief Amount of pauses per duration range. First bucket counts pauses shorter than 1 microsecond,
+         * every next bucket `i` counts pauses in range [2^(i-1), 2^i) microseconds and the last bucket also counts everything longer than that
+         *
+         */
+        std::array<size_t, BucketCount> buckets = {};
+        /// @brief Total amount of recorded pauses
+        size_t pauseCount = 0;
+        /// @brief Duration of the longest pause
+        std::chrono::nanoseconds longestPause = std::chrono::nanoseconds::zero();
+        /// @brief Combined duration of all pauses
+        std::chrono::nanoseconds totalPauseTime = std::chrono::nanoseconds::zero();
+
+        /**
+         * @brief Add pause to the histogram
+         *
+         * @param pause Duration of the pause
+         */
+        void record(std::chrono::nanoseconds pause);
+    };
+
+    /// @brief State of the incremental collection
+    enum class CollectionPhase
+    {
+        /// @brief No collection is in progress
+        Idle,
+        /// @brief Objects are being marked in slices while the program keeps running
+        Marking,
+        /// @brief Old generation is being swept in slices while the program keeps running
+        Sweeping
+    };
+
+    /**
+     * @brief Generational tracing mark and sweep garbage collector that owns every object registered by the interpreter.
+     *
+     * Objects are kept in two doubly linked lists: young objects that were registered since the last collection and old objects that survived at least one collection.
+     * Collection is done by marking the roots provided by the owner of the collector, tracing everything reachable from them and then deleting every object that was not marked.
+     * Minor collections only trace and sweep young objects, treating old objects as alive and using the remembered set to find young objects referenced by old ones.
+     * Full collections trace and sweep both generations.
+     *
+     * Full collections can also be incremental, in which case marking and sweeping of the old generation are split into time limited slices that are interleaved with program execution.
+     * Marking uses tri-color invariant: marked objects are either grey(in the grey list) or black(traced), while the write barrier marks every object that gets stored in an already marked object.
+     * Roots are marked again once there are no grey objects left, because values on the stack and in variables are not covered by the write barrier
+     *
+     */
+    class GarbageCollector
+    {
+    public:
+        explicit GarbageCollector() = default;
+
+        GarbageCollector(GarbageCollector const &) = delete;
+        GarbageCollector &operator=(GarbageCollector const &) = delete;
+
+        /**
+         * @brief Register object to be handled by the garbage collector. Objects that are already registered are ignored
+         *
+         * @param obj Object to register
+         */
+        void addObject(MemoryNode *obj);
+
+        /**
+         * @brief Add old object to the remembered set. Called by the write barrier when old object starts referencing a young object
+         *
+         * @param obj Old object to remember
+         */
+        void rememberObject(MemoryNode *obj);
+
+        /**
+         * @brief Prepare for a new collection. Must be called before marking the roots
+         *
+         * @param full If true both generations are collected, otherwise only young objects are collected
+         */
+        void startCollection(bool full);
+
+        /**
+         * @brief Start a full collection that will be performed in slices. Roots must be marked after calling this
+         *
+         */
+        void startIncrementalCollection();
+
+        /**
+         * @brief Trace marked objects until there are no grey objects left or until the deadline is reached
+         *
+         * @param deadline Time after which no more objects should be traced
+         * @return true if there are no grey objects left
+         */
+        bool traceUntil(std::chrono::steady_clock::time_point deadline);
+
+        /**
+         * @brief Finish marking of the incremental collection and switch to sweeping. Roots must be marked again before calling this.
+         * Young objects are swept right away, while the old generation is swept in slices
+         *
+         */
+        void finishMarking();
+
+        /**
+         * @brief Sweep old objects until every object that existed when the marking finished was checked or until the deadline is reached
+         *
+         * @param deadline Time after which no more objects should be swept
+         * @return true if sweeping is finished and collection is complete
+         */
+        bool sweepUntil(std::chrono::steady_clock::time_point deadline);
+
+        CollectionPhase getPhase() const { return m_phase; }
+
+        /// @brief Is incremental collection currently marking objects. Write barrier has to mark stored objects during this phase
+        bool isMarking() const { return m_phase == CollectionPhase::Marking; }
+
+        /**
+         * @brief Add duration of a garbage collection pause to the histogram
+         *
+         * @param pause How long the program was paused
+         */
+        void recordPause(std::chrono::nanoseconds pause) { m_pauseHistogram.record(pause); }
+
+        GcPauseHistogram const &getPauseHistogram() const { return m_pauseHistogram; }
+
+        /// @brief Allocator that provides memory for objects created by the interpreter
+        SlabAllocator &getAllocator() { return m_allocator; }
+
+        SlabAllocator const &getAllocator() const { return m_allocator; }
+
+        /// @brief Remove all recorded pauses
+        void resetPauseHistogram() { m_pauseHistogram = GcPauseHistogram(); }
+
+        /**
+         * @brief Mark value as reachable. If value is an object that was not yet marked it will be traced during collection
+         *
+         * @param val Value to mark
+         */
+        void markValue(Value const &val);
+
+        /**
+         * @brief Mark object as reachable. Objects that were not yet marked will be traced during collection
+         *
+         * @param obj Object to mark
+         */
+        void markObject(MemoryNode *obj);
+
+        /**
+         * @brief Trace all objects reachable from the marked objects and delete everything that was not reached.
+         * All surviving young objects are promoted to the old generation.
+         * Collection must be started and all roots must be marked before calling this
+         *
+         */
+        void collect();
+
+        /// @brief Whether enough objects were allocated since the last collection to run a new one
+        bool shouldCollect() const { return m_youngCount >= m_threshold; }
+
+        /// @brief Whether old generation grew enough since the last full collection that the next collection should be a full one
+        bool isFullCollectionDue() const { return m_oldCount >= std::max(m_threshold, m_fullCollectionThreshold); }
+
+        /**
+         * @brief Set how many objects have to be allocated since the last collection before garbage collector runs again.
+         * Old generation is collected once it doubles in size since the last full collection, but never before it reaches this amount of objects
+         *
+         * @param allocations Size of the young generation that triggers a collection
+         */
+        void setThreshold(size_t allocations) { m_threshold = allocations; }
+
+        size_t getThreshold() const { return m_threshold; }
+
+        /// @brief Amount of objects currently tracked by the garbage collector
+        size_t getObjectCount() const { return m_youngCount + m_oldCount; }
+
+        /// @brief Amount of objects that were registered since the last collection
+        size_t getYoungObjectCount() const { return m_youngCount; }
+
+        /**
+         * @brief Find interned string with the given contents. While old generation is being swept no strings are returned
+         *
+         * @param str Contents of the string
+         * @return StringNode* Interned string or nullptr if there is no such string
+         */
+        StringNode *findInternedString(std::string const &str);
+
+        /**
+         * @brief Add string to the intern table. The table does not keep the string alive, entry is removed once string is deleted
+         *
+         * @param str String to intern
+         */
+        void internString(StringNode *str);
+
+        ~GarbageCollector();
+
+    private:
+        /// @brief Remove string from the interned string table, if it is present there
+        /// @param str String to remove
+        void _removeInternedString(StringNode *str);
+
+        /// @brief Mark objects until there are no more marked objects that were not traced
+        void _trace();
+
+        /**
+         * @brief Delete all unmarked objects in the list and reset marks on the remaining ones
+         *
+         * @param root Root of the list to sweep
+         * @param tail Last object in the list, updated if it gets deleted
+         * @param count Amount of objects in the list, updated for every deleted object
+         * @param promote If true surviving objects are moved to the old generation
+         */
+        void _sweep(MemoryNode &root, MemoryNode *&tail, size_t &count, bool promote);
+
+        /**
+         * @brief Delete object if it is not marked, otherwise reset the mark
+         *
+         * @param obj Object to check
+         * @param tail Last object in the list the object is in, updated if object is removed from the list
+         * @param count Amount of objects in the list, updated if object is removed from the list
+         * @param promote If true surviving object is moved to the old generation
+         */
+        void _sweepObject(MemoryNode *obj, MemoryNode *&tail, size_t &count, bool promote);
+
+        /// @brief Remove all objects from the remembered set
+        void _clearRememberedObjects();
+
+        /// @brief Delete object and remove it from the intern table
+        /// @param obj Object to delete
+        void _deleteObject(MemoryNode *obj);
+
+        /**
+         * @brief Call destructor of the object and release its memory
+         *
+         * @param obj Object to destroy
+         * @param reuseMemory If false memory taken from slabs is not returned to the allocator, because allocator is about to free every slab
+         */
+        void _destroyObject(MemoryNode *obj, bool reuseMemory);
+
+        /// @brief Memory for the objects, declared before object lists so that it would outlive them
+        SlabAllocator m_allocator;
+        /// @brief Objects that survived at least one collection
+        MemoryNode m_oldRoot;
+        /// @brief Last object in the old object list, used to promote objects without walking the list
+        MemoryNode *m_oldTail = &m_oldRoot;
+        /// @brief Objects that were registered since the last collection
+        MemoryNode m_youngRoot;
+        /// @brief Last object in the young object list, used to register new objects without walking the list
+        MemoryNode *m_youngTail = &m_youngRoot;
+        /// @brief Objects that were marked but whose references were not yet marked
+        std::vector<MemoryNode *> m_greyObjects;
+        /// @brief Old objects that might reference young objects
+        std::vector<MemoryNode *> m_rememberedObjects;
+        /// @brief Is current collection a full collection
+        bool m_fullCollection = false;
+        CollectionPhase m_phase = CollectionPhase::Idle;
+        /// @brief Next old object to be checked by incremental sweeping
+        MemoryNode *m_sweepCursor = nullptr;
+        /// @brief Last old object that existed when marking was finished. Objects promoted after it are not swept
+        MemoryNode *m_sweepEnd = nullptr;
+        /// @brief How many objects are traced or swept between checking if the slice deadline was reached
+        static constexpr size_t ObjectsPerDeadlineCheck = 64;
+        GcPauseHistogram m_pauseHistogram;
+        /// @brief Amount of young objects that triggers a collection
+        size_t m_threshold = DEFAULT_GC_ALLOCATION_THRESHOLD;
+        /// @brief Size of the old generation that triggers a full collection, which is twice the amount of objects that survived the last full collection
+        size_t m_fullCollectionThreshold = 0;
+        /// @brief How many objects were registered since the last garbage collection
+        size_t m_youngCount = 0;
+        /// @brief How many objects survived garbage collections
+        size_t m_oldCount = 0;
+        /**
+         * @brief Strings that can be reused by createString, grouped by the hash of their contents.
+         *  Entries do not keep strings alive and are removed once the string is deleted
+         *
+         */
+        std::unordered_multimap<size_t, StringNode *> m_internedStrings;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <bit>
+#include "Operations.hpp"
+
+namespace GobLang
+{
+    /**
+     * @brief Operation decoded from the byte code with its arguments already parsed, which is what the interpreter executes.
+     *
+     * Byte code stays the format used for storing and disassembling the code, while instructions are created from it once when the code is loaded
+     *
+     */
+    struct alignas(16) Instruction
+    {
+        Operation op = Operation::None;
+        /**
+         * @brief First argument of the operation. This is the constant for push operations, id of the variable or the slot,
+         * id of the field name for field access or the index of the instruction to jump to for jumps
+         *
+         */
+        uint32_t arg = 0;
+        /// @brief Second argument of the operation, used by operations that have more than one argument
+        uint32_t arg2 = 0;
+        /// @brief Third argument of the operation, only used by superinstructions. This is the index of the instruction to jump to for conditional superinstructions
+        uint32_t arg3 = 0;
+
+        int32_t getInt() const { return std::bit_cast<int32_t>(arg); }
+
+        float getFloat() const { return std::bit_cast<float>(arg); }
+    };
+}
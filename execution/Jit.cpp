@@ -0,0 +1,982 @@
+#include "Jit.hpp"
+#include <map>
+#include <algorithm>
+#include <cstring>
+#ifdef GOB_LANG_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    enum Register : uint8_t
+    {
+        Rax = 0,
+        Rcx = 1,
+        Rbx = 3,
+        Rsp = 4,
+        Rsi = 6,
+        Rdi = 7,
+        R8 = 8,
+        R9 = 9,
+        R10 = 10,
+        R11 = 11,
+        R12 = 12,
+        R13 = 13,
+        R14 = 14,
+        R15 = 15,
+    };
+
+    // registers that hold the state of the machine while compiled code runs, all of them are preserved by the helpers
+    constexpr Register MachineRegister = Rbx;
+    /// @brief Pointer past the last value of the stack
+    constexpr Register StackEndRegister = R12;
+    /// @brief Pointer to the first local variable of the current frame
+    constexpr Register LocalsRegister = R13;
+    /// @brief Pointer to the first operand of the current frame, which is right after the last local variable
+    constexpr Register OperandsRegister = R14;
+    /// @brief Pointer to the end of the memory allocated for the stack
+    constexpr Register StackCapacityRegister = R15;
+    /// @brief Registers that hold local variables which always store integers. Helpers don't preserve them,
+    /// so local variables are written to the stack before every call of a helper and loaded again after it
+    constexpr Register LocalRegisters[GobLang::Jit::MaxRegisterLocals] = {R9, R10, R11, Rsi, Rdi};
+
+    /// @brief Condition codes used by conditional jumps and setcc
+    enum Condition : uint8_t
+    {
+        Below = 0x2,
+        AboveOrEqual = 0x3,
+        Equal = 0x4,
+        NotEqual = 0x5,
+        BelowOrEqual = 0x6,
+        Above = 0x7,
+        Less = 0xC,
+        GreaterOrEqual = 0xD,
+        LessOrEqual = 0xE,
+        Greater = 0xF,
+    };
+
+    /// @brief Operations that are selected by the reg field of the modrm byte of the instructions with immediate operand
+    enum ImmediateOperation : uint8_t
+    {
+        AddImmediate = 0,
+        OrImmediate = 1,
+        SubImmediate = 5,
+        CompareImmediate = 7,
+    };
+
+    // opcodes of operations in form `op r/m, reg`
+    constexpr uint8_t AddOpcode = 0x01;
+    constexpr uint8_t OrOpcode = 0x09;
+    constexpr uint8_t SubOpcode = 0x29;
+    constexpr uint8_t CompareOpcode = 0x39;
+    constexpr uint8_t StoreOpcode = 0x89;
+    // opcodes of operations in form `op reg, r/m`
+    constexpr uint8_t AddFromMemoryOpcode = 0x03;
+    constexpr uint8_t CompareWithMemoryOpcode = 0x3B;
+    constexpr uint8_t LoadOpcode = 0x8B;
+
+    /**
+     * @brief Writes x86-64 machine code into a byte buffer and resolves jumps to labels once all of them are known
+     *
+     */
+    class Assembler
+    {
+    public:
+        /// @brief Position in the code that the jump has to be patched at once the label is known
+        struct Fixup
+        {
+            size_t position;
+            size_t label;
+        };
+
+        /// @brief Create label that is not used by any instruction
+        size_t createLabel() { return m_nextLabel++; }
+
+        void bind(size_t label) { m_labels[label] = m_code.size(); }
+
+        void emit(std::initializer_list<uint8_t> bytes)
+        {
+            for (uint8_t byte : bytes)
+            {
+                m_code.push_back(byte);
+            }
+        }
+
+        void emit32(uint32_t val)
+        {
+            for (size_t i = 0; i < sizeof(val); i++)
+            {
+                m_code.push_back((uint8_t)(val >> (i * 8)));
+            }
+        }
+
+        void emit64(uint64_t val)
+        {
+            for (size_t i = 0; i < sizeof(val); i++)
+            {
+                m_code.push_back((uint8_t)(val >> (i * 8)));
+            }
+        }
+
+        /// @brief Emit 32 bit offset to the label, which is relative to the end of the offset
+        void emitLabelOffset(size_t label)
+        {
+            m_fixups.push_back(Fixup{.position = m_code.size(), .label = label});
+            emit32(0);
+        }
+
+        /// @brief jmp rel32
+        void jump(size_t label)
+        {
+            emit({0xE9});
+            emitLabelOffset(label);
+        }
+
+        /// @brief jcc rel32
+        void jumpIf(Condition condition, size_t label)
+        {
+            emit({0x0F, (uint8_t)(0x80 | condition)});
+            emitLabelOffset(label);
+        }
+
+        /// @brief `op r/m, reg` or `op reg, r/m` where r/m is [base + offset]
+        void operationWithMemory(uint8_t opcode, uint8_t reg, uint8_t base, int32_t offset)
+        {
+            _emitRex(true, reg, base);
+            emit({opcode, (uint8_t)(0x80 | ((reg & 7) << 3) | (base & 7))});
+            if ((base & 7) == Rsp)
+            {
+                // rsp and r12 as base require sib byte
+                emit({0x24});
+            }
+            emit32((uint32_t)offset);
+        }
+
+        /// @brief mov dst, [base + offset]
+        void load(uint8_t dst, uint8_t base, int32_t offset) { operationWithMemory(LoadOpcode, dst, base, offset); }
+
+        /// @brief mov [base + offset], src
+        void store(uint8_t base, int32_t offset, uint8_t src) { operationWithMemory(StoreOpcode, src, base, offset); }
+
+        /// @brief `op dst, src` for opcodes in `op r/m, reg` form, using 64 or 32 bit registers
+        void operation(bool wide, uint8_t opcode, uint8_t dst, uint8_t src)
+        {
+            _emitRex(wide, src, dst);
+            emit({opcode, (uint8_t)(0xC0 | ((src & 7) << 3) | (dst & 7))});
+        }
+
+        /// @brief `op dst, imm32` using 64 or 32 bit register
+        void operationWithImmediate(bool wide, ImmediateOperation op, uint8_t dst, uint32_t imm)
+        {
+            _emitRex(wide, 0, dst);
+            emit({0x81, (uint8_t)(0xC0 | (op << 3) | (dst & 7))});
+            emit32(imm);
+        }
+
+        /// @brief imul dst, src using 32 bit registers
+        void multiply(uint8_t dst, uint8_t src)
+        {
+            _emitRex(false, dst, src);
+            emit({0x0F, 0xAF, (uint8_t)(0xC0 | ((dst & 7) << 3) | (src & 7))});
+        }
+
+        /// @brief shl dst, amount
+        void shiftLeft(uint8_t dst, uint8_t amount)
+        {
+            _emitRex(true, 0, dst);
+            emit({0xC1, (uint8_t)(0xE0 | (dst & 7)), amount});
+        }
+
+        /// @brief shr dst, amount
+        void shiftRight(uint8_t dst, uint8_t amount)
+        {
+            _emitRex(true, 0, dst);
+            emit({0xC1, (uint8_t)(0xE8 | (dst & 7)), amount});
+        }
+
+        /// @brief push reg
+        void push(uint8_t reg)
+        {
+            _emitRex(false, 0, reg);
+            emit({(uint8_t)(0x50 | (reg & 7))});
+        }
+
+        /// @brief pop reg
+        void pop(uint8_t reg)
+        {
+            _emitRex(false, 0, reg);
+            emit({(uint8_t)(0x58 | (reg & 7))});
+        }
+
+        /// @brief mov dst, imm64
+        void moveImmediate(uint8_t dst, uint64_t imm)
+        {
+            _emitRex(true, 0, dst);
+            emit({(uint8_t)(0xB8 | (dst & 7))});
+            emit64(imm);
+        }
+
+        /// @brief Set rax to 1 if condition is true and to 0 otherwise
+        void setIf(Condition condition)
+        {
+            // setcc al
+            emit({0x0F, (uint8_t)(0x90 | condition), 0xC0});
+            // movzx eax, al
+            emit({0x0F, 0xB6, 0xC0});
+        }
+
+        /**
+         * @brief Call helper(machine, pc, arg, arg2, arg3) following System V calling convention.
+         * Machine is kept in rbx, which is preserved by the callee
+         *
+         */
+        void callHelper(GobLang::Jit::OperationHelper helper, uint32_t pc, uint32_t arg, uint32_t arg2, uint32_t arg3)
+        {
+            // mov rdi, rbx
+            emit({0x48, 0x89, 0xDF});
+            // mov esi, pc
+            emit({0xBE});
+            emit32(pc);
+            // mov edx, arg
+            emit({0xBA});
+            emit32(arg);
+            // mov ecx, arg2
+            emit({0xB9});
+            emit32(arg2);
+            // mov r8d, arg3
+            emit({0x41, 0xB8});
+            emit32(arg3);
+            // mov rax, helper
+            emit({0x48, 0xB8});
+            emit64(reinterpret_cast<uint64_t>(helper));
+            // call rax
+            emit({0xFF, 0xD0});
+        }
+
+        /// @brief Write offsets of every jump
+        /// @return false if some jump refers to a label that was never bound
+        bool resolve()
+        {
+            for (Fixup const &fixup : m_fixups)
+            {
+                std::map<size_t, size_t>::const_iterator it = m_labels.find(fixup.label);
+                if (it == m_labels.end())
+                {
+                    return false;
+                }
+                int32_t offset = (int32_t)((int64_t)it->second - (int64_t)(fixup.position + sizeof(int32_t)));
+                std::memcpy(m_code.data() + fixup.position, &offset, sizeof(offset));
+            }
+            return true;
+        }
+
+        std::vector<uint8_t> const &getCode() const { return m_code; }
+
+    private:
+        /// @brief Emit REX prefix if it is needed for 64 bit operation or for registers r8-r15
+        /// @param wide Whether operation uses 64 bit registers
+        /// @param reg Register in the reg field of modrm byte
+        /// @param rm Register in the r/m field of modrm byte
+        void _emitRex(bool wide, uint8_t reg, uint8_t rm)
+        {
+            uint8_t prefix = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((rm & 8) ? 0x01 : 0);
+            if (prefix != 0x40)
+            {
+                emit({prefix});
+            }
+        }
+
+        std::vector<uint8_t> m_code;
+        std::map<size_t, size_t> m_labels;
+        std::vector<Fixup> m_fixups;
+        /// @brief Labels of instructions use their indices, so other labels start far past any index
+        size_t m_nextLabel = SIZE_MAX / 2;
+    };
+
+    /// @brief Largest id of a local variable that native operations access directly, so that offsets of locals fit into instructions
+    constexpr uint32_t MaxNativeLocalId = 1 << 24;
+
+    /**
+     * @brief Emits native versions of operations. Every native operation either finishes the operation and jumps to `done` (or to the target of the jump)
+     * or jumps to `slow` without changing anything, where the helper performs the operation including reporting of errors.
+     *
+     * End of the stack and positions of the current frame are kept in registers, so native operations don't touch the machine itself.
+     * The end of the stack is written back before every call of a helper and all registers are loaded again once helper returns,
+     * because helpers can change the stack and the frame
+     *
+     */
+    class NativeOperationWriter
+    {
+    public:
+        NativeOperationWriter(
+            Assembler &assembler,
+            GobLang::Jit::MachineLayout const &layout,
+            std::vector<uint32_t> const &registerLocals,
+            std::vector<uint32_t> const &writtenRegisterLocals)
+            : m_assembler(assembler), m_layout(layout), m_registerLocals(registerLocals), m_writtenRegisterLocals(writtenRegisterLocals) {}
+
+        /// @brief Write registers that could have changed back to the machine
+        void storeState()
+        {
+            m_assembler.store(MachineRegister, m_layout.stackEnd, StackEndRegister);
+        }
+
+        /// @brief Store local variables kept in registers that could have changed back to the stack
+        void storeRegisterLocals()
+        {
+            for (uint32_t id : m_writtenRegisterLocals)
+            {
+                m_assembler.operation(false, StoreOpcode, Rax, _getRegister(id).value());
+                _tagInt();
+                m_assembler.store(LocalsRegister, _getOffset(id), Rax);
+            }
+        }
+
+        /// @brief Load local variables kept in registers from the stack, jumping to `fail` if one of them doesn't exist or doesn't store an integer anymore
+        void loadRegisterLocals(size_t fail)
+        {
+            if (m_registerLocals.empty())
+            {
+                return;
+            }
+            _checkLocal(*std::max_element(m_registerLocals.begin(), m_registerLocals.end()), fail);
+            for (uint32_t id : m_registerLocals)
+            {
+                m_assembler.load(Rax, LocalsRegister, _getOffset(id));
+                _checkInt(Rax, fail);
+                m_assembler.operation(false, StoreOpcode, _getRegister(id).value(), Rax);
+            }
+        }
+
+        bool hasRegisterLocals() const { return !m_registerLocals.empty(); }
+
+        /// @brief Save registers of the local variables on the native stack, for helpers that don't access local variables
+        void pushRegisterLocals()
+        {
+            for (size_t i = 0; i < m_registerLocals.size(); i++)
+            {
+                m_assembler.push(LocalRegisters[i]);
+            }
+            if (m_registerLocals.size() % 2 != 0)
+            {
+                // sub rsp, 8 to keep the stack aligned for the call
+                m_assembler.emit({0x48, 0x83, 0xEC, 0x08});
+            }
+        }
+
+        /// @brief Restore registers saved by `pushRegisterLocals`
+        void popRegisterLocals()
+        {
+            if (m_registerLocals.size() % 2 != 0)
+            {
+                // add rsp, 8
+                m_assembler.emit({0x48, 0x83, 0xC4, 0x08});
+            }
+            for (size_t i = m_registerLocals.size(); i-- > 0;)
+            {
+                m_assembler.pop(LocalRegisters[i]);
+            }
+        }
+
+        /// @brief Load state of the stack and the current frame from the machine into registers
+        void loadState()
+        {
+            Assembler &a = m_assembler;
+            a.load(StackEndRegister, MachineRegister, m_layout.stackEnd);
+            a.load(StackCapacityRegister, MachineRegister, m_layout.stackCapacity);
+            a.load(LocalsRegister, MachineRegister, m_layout.frameBase);
+            a.shiftLeft(LocalsRegister, 3);
+            a.operationWithMemory(AddFromMemoryOpcode, LocalsRegister, MachineRegister, m_layout.stackBegin);
+            a.load(OperandsRegister, MachineRegister, m_layout.frameLocalCapacity);
+            a.shiftLeft(OperandsRegister, 3);
+            a.operation(true, AddOpcode, OperandsRegister, LocalsRegister);
+        }
+
+        /**
+         * @brief Emit native version of the instruction if it has one
+         *
+         * @param instruction Instruction to emit
+         * @param slow Label of the call to the helper
+         * @param done Label of the code that continues after the instruction
+         * @return true Native version was emitted
+         * @return false Instruction is always performed by the helper
+         */
+        bool write(GobLang::Jit::JitInstruction const &instruction, size_t slow, size_t done)
+        {
+            using GobLang::Operation;
+            Assembler &a = m_assembler;
+            switch (instruction.op)
+            {
+            case Operation::PushConstInt:
+                _pushConst(m_layout.intBits | instruction.arg, slow, done);
+                return true;
+            case Operation::PushTrue:
+                _pushConst(m_layout.trueBits, slow, done);
+                return true;
+            case Operation::PushFalse:
+                _pushConst(m_layout.falseBits, slow, done);
+                return true;
+            case Operation::GetLocal:
+                if (instruction.arg >= MaxNativeLocalId)
+                {
+                    return false;
+                }
+                if (std::optional<Register> reg = _getRegister(instruction.arg); reg.has_value())
+                {
+                    _checkCapacity(slow);
+                    a.operation(false, StoreOpcode, Rax, reg.value());
+                    _tagInt();
+                    _push(Rax);
+                    a.jump(done);
+                    return true;
+                }
+                _checkLocal(instruction.arg, slow);
+                _checkCapacity(slow);
+                a.load(Rax, LocalsRegister, _getOffset(instruction.arg));
+                _push(Rax);
+                a.jump(done);
+                return true;
+            case Operation::SetLocal:
+                if (instruction.arg >= MaxNativeLocalId)
+                {
+                    return false;
+                }
+                if (std::optional<Register> reg = _getRegister(instruction.arg); reg.has_value())
+                {
+                    // other types are stored by the helper, after which the code leaves as the variable no longer stores an integer
+                    _checkOperands(1, slow);
+                    a.load(Rax, StackEndRegister, -_getOffset(1));
+                    _checkInt(Rax, slow);
+                    a.operation(false, StoreOpcode, reg.value(), Rax);
+                    _pop(1);
+                    a.jump(done);
+                    return true;
+                }
+                _checkLocal(instruction.arg, slow);
+                _checkOperands(1, slow);
+                a.load(Rax, StackEndRegister, -_getOffset(1));
+                a.store(LocalsRegister, _getOffset(instruction.arg), Rax);
+                _pop(1);
+                a.jump(done);
+                return true;
+            case Operation::AddInt:
+            case Operation::SubInt:
+            case Operation::MulInt:
+            case Operation::LessInt:
+            case Operation::MoreInt:
+            case Operation::LessOrEqInt:
+            case Operation::MoreOrEqInt:
+                _binaryInt(instruction.op, slow, done);
+                return true;
+            case Operation::JumpIfNot:
+            case Operation::JumpIf:
+                if (!instruction.target.has_value())
+                {
+                    return false;
+                }
+                _jumpIfCondition(instruction.op == Operation::JumpIf, instruction.target.value(), slow, done);
+                return true;
+            case Operation::IncLocalByConst:
+                if (instruction.arg2 >= MaxNativeLocalId)
+                {
+                    return false;
+                }
+                if (std::optional<Register> reg = _getRegister(instruction.arg2); reg.has_value())
+                {
+                    a.operationWithImmediate(false, AddImmediate, reg.value(), instruction.arg);
+                    a.jump(done);
+                    return true;
+                }
+                _checkLocal(instruction.arg2, slow);
+                a.load(Rax, LocalsRegister, _getOffset(instruction.arg2));
+                _checkInt(Rax, slow);
+                a.operationWithImmediate(false, AddImmediate, Rax, instruction.arg);
+                _tagInt();
+                a.store(LocalsRegister, _getOffset(instruction.arg2), Rax);
+                a.jump(done);
+                return true;
+            case Operation::PushLocalAddConst:
+            case Operation::PushLocalSubConst:
+                if (instruction.arg2 >= MaxNativeLocalId)
+                {
+                    return false;
+                }
+                _checkCapacity(slow);
+                _loadIntLocal(Rax, instruction.arg2, slow);
+                a.operationWithImmediate(
+                    false,
+                    instruction.op == Operation::PushLocalAddConst ? AddImmediate : SubImmediate,
+                    Rax,
+                    instruction.arg);
+                _tagInt();
+                _push(Rax);
+                a.jump(done);
+                return true;
+            case Operation::JumpIfNotLessLocalConst:
+            case Operation::JumpIfNotLessOrEqLocalConst:
+                if (instruction.arg2 >= MaxNativeLocalId || !instruction.target.has_value())
+                {
+                    return false;
+                }
+                _loadIntLocal(Rax, instruction.arg2, slow);
+                a.operationWithImmediate(false, CompareImmediate, Rax, instruction.arg);
+                a.jumpIf(instruction.op == Operation::JumpIfNotLessLocalConst ? Less : LessOrEqual, done);
+                a.jump(instruction.target.value());
+                return true;
+            case Operation::JumpIfNotLessLocals:
+                if (instruction.arg >= MaxNativeLocalId || instruction.arg2 >= MaxNativeLocalId || !instruction.target.has_value())
+                {
+                    return false;
+                }
+                _loadIntLocal(Rax, instruction.arg, slow);
+                _loadIntLocal(Rcx, instruction.arg2, slow);
+                a.operation(false, CompareOpcode, Rax, Rcx);
+                a.jumpIf(Less, done);
+                a.jump(instruction.target.value());
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    private:
+        /// @brief Offset of the nth value in bytes
+        static int32_t _getOffset(uint32_t id) { return (int32_t)(id * sizeof(uint64_t)); }
+
+        /// @brief Get register that holds the local variable or nothing if the variable is stored on the stack
+        std::optional<Register> _getRegister(uint32_t id) const
+        {
+            std::vector<uint32_t>::const_iterator it = std::find(m_registerLocals.begin(), m_registerLocals.end(), id);
+            if (it == m_registerLocals.end())
+            {
+                return std::nullopt;
+            }
+            return LocalRegisters[it - m_registerLocals.begin()];
+        }
+
+        /// @brief Load integer stored in the local variable into the lower half of the register, jumping to `slow` if variable doesn't store an integer
+        void _loadIntLocal(uint8_t dst, uint32_t id, size_t slow)
+        {
+            if (std::optional<Register> reg = _getRegister(id); reg.has_value())
+            {
+                m_assembler.operation(false, StoreOpcode, dst, reg.value());
+                return;
+            }
+            _checkLocal(id, slow);
+            m_assembler.load(dst, LocalsRegister, _getOffset(id));
+            _checkInt(dst, slow);
+        }
+
+        /// @brief Jump to `slow` if there is no space for another value on the stack
+        void _checkCapacity(size_t slow)
+        {
+            m_assembler.operation(true, CompareOpcode, StackEndRegister, StackCapacityRegister);
+            m_assembler.jumpIf(AboveOrEqual, slow);
+        }
+
+        /// @brief Jump to `slow` if the current function has less than `count` values above its local variables
+        void _checkOperands(uint32_t count, size_t slow)
+        {
+            Assembler &a = m_assembler;
+            a.operation(true, StoreOpcode, Rax, StackEndRegister);
+            a.operation(true, SubOpcode, Rax, OperandsRegister);
+            a.operationWithImmediate(true, CompareImmediate, Rax, _getOffset(count));
+            a.jumpIf(Less, slow);
+        }
+
+        /// @brief Jump to `slow` if there is no local variable with the given id
+        void _checkLocal(uint32_t id, size_t slow)
+        {
+            Assembler &a = m_assembler;
+            a.load(R8, MachineRegister, m_layout.frameLocalCount);
+            a.operationWithImmediate(true, CompareImmediate, R8, id);
+            a.jumpIf(BelowOrEqual, slow);
+        }
+
+        /// @brief Jump to `slow` if register doesn't store an integer
+        void _checkInt(uint8_t reg, size_t slow)
+        {
+            Assembler &a = m_assembler;
+            a.operation(true, StoreOpcode, R8, reg);
+            a.shiftRight(R8, 32);
+            a.operationWithImmediate(false, CompareImmediate, R8, (uint32_t)(m_layout.intBits >> 32));
+            a.jumpIf(NotEqual, slow);
+        }
+
+        /// @brief Turn result of 32 bit operation in eax into an integer value, 32 bit operations already cleared the upper half of rax
+        void _tagInt()
+        {
+            m_assembler.moveImmediate(R8, m_layout.intBits);
+            m_assembler.operation(true, OrOpcode, Rax, R8);
+        }
+
+        void _push(uint8_t reg)
+        {
+            m_assembler.store(StackEndRegister, 0, reg);
+            m_assembler.operationWithImmediate(true, AddImmediate, StackEndRegister, _getOffset(1));
+        }
+
+        void _pop(uint32_t count)
+        {
+            m_assembler.operationWithImmediate(true, SubImmediate, StackEndRegister, _getOffset(count));
+        }
+
+        void _pushConst(uint64_t bits, size_t slow, size_t done)
+        {
+            _checkCapacity(slow);
+            m_assembler.moveImmediate(Rax, bits);
+            _push(Rax);
+            m_assembler.jump(done);
+        }
+
+        void _binaryInt(GobLang::Operation op, size_t slow, size_t done)
+        {
+            using GobLang::Operation;
+            Assembler &a = m_assembler;
+            _checkOperands(2, slow);
+            a.load(Rax, StackEndRegister, -_getOffset(2));
+            a.load(Rcx, StackEndRegister, -_getOffset(1));
+            _checkInt(Rax, slow);
+            _checkInt(Rcx, slow);
+            switch (op)
+            {
+            case Operation::AddInt:
+                a.operation(false, AddOpcode, Rax, Rcx);
+                _tagInt();
+                break;
+            case Operation::SubInt:
+                a.operation(false, SubOpcode, Rax, Rcx);
+                _tagInt();
+                break;
+            case Operation::MulInt:
+                a.multiply(Rax, Rcx);
+                _tagInt();
+                break;
+            default:
+                a.operation(false, CompareOpcode, Rax, Rcx);
+                a.setIf(op == Operation::LessInt       ? Less
+                        : op == Operation::MoreInt     ? Greater
+                        : op == Operation::LessOrEqInt ? LessOrEqual
+                                                       : GreaterOrEqual);
+                // false differs from true only in the lowest bit
+                a.moveImmediate(R8, m_layout.falseBits);
+                a.operation(true, OrOpcode, Rax, R8);
+                break;
+            }
+            a.store(StackEndRegister, -_getOffset(2), Rax);
+            _pop(1);
+            a.jump(done);
+        }
+
+        void _jumpIfCondition(bool jumpIfTrue, size_t target, size_t slow, size_t done)
+        {
+            Assembler &a = m_assembler;
+            size_t isTrue = a.createLabel();
+            _checkOperands(1, slow);
+            a.load(Rax, StackEndRegister, -_getOffset(1));
+            a.moveImmediate(R8, m_layout.trueBits);
+            a.operation(true, CompareOpcode, Rax, R8);
+            a.jumpIf(Equal, isTrue);
+            a.moveImmediate(R8, m_layout.falseBits);
+            a.operation(true, CompareOpcode, Rax, R8);
+            a.jumpIf(NotEqual, slow);
+            _pop(1);
+            a.jump(jumpIfTrue ? done : target);
+            a.bind(isTrue);
+            _pop(1);
+            a.jump(jumpIfTrue ? target : done);
+        }
+
+        Assembler &m_assembler;
+        GobLang::Jit::MachineLayout const &m_layout;
+        /// @brief Local variables kept in registers, in the same order as `LocalRegisters`
+        std::vector<uint32_t> m_registerLocals;
+        /// @brief Local variables kept in registers that are changed by the code and have to be written back to the stack
+        std::vector<uint32_t> m_writtenRegisterLocals;
+    };
+} // namespace
+
+std::vector<uint32_t> GobLang::Jit::getAccessedLocals(JitInstruction const &instruction)
+{
+    switch (instruction.op)
+    {
+    case Operation::GetLocal:
+    case Operation::SetLocal:
+        return {instruction.arg};
+    case Operation::IncLocalByConst:
+    case Operation::PushLocalAddConst:
+    case Operation::PushLocalSubConst:
+    case Operation::JumpIfNotLessLocalConst:
+    case Operation::JumpIfNotLessOrEqLocalConst:
+        return {instruction.arg2};
+    case Operation::JumpIfNotLessLocals:
+        return {instruction.arg, instruction.arg2};
+    case Operation::GetLocalField:
+    case Operation::SetLocalField:
+        return {instruction.arg3};
+    default:
+        return {};
+    }
+}
+
+bool GobLang::Jit::canAccessRegisterLocals(Operation op)
+{
+    switch (op)
+    {
+    case Operation::GetLocal:
+    case Operation::SetLocal:
+    case Operation::IncLocalByConst:
+    case Operation::PushLocalAddConst:
+    case Operation::PushLocalSubConst:
+    case Operation::JumpIfNotLessLocalConst:
+    case Operation::JumpIfNotLessOrEqLocalConst:
+    case Operation::JumpIfNotLessLocals:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::unique_ptr<GobLang::Jit::CompiledCode> GobLang::Jit::CompiledCode::compile(
+    std::vector<JitInstruction> const &instructions,
+    size_t entry,
+    OperationHelper bailout,
+    MachineLayout const &layout,
+    std::vector<uint32_t> const &registerLocals)
+{
+#ifdef GOB_LANG_JIT_AVAILABLE
+    // labels of instructions use their indices, while leaving the code uses a label past every index
+    size_t const leaveLabel = SIZE_MAX;
+    // local variables can only be kept in registers by native operations, which need the layout
+    std::vector<uint32_t> locals = layout.valid ? registerLocals : std::vector<uint32_t>{};
+    if (locals.size() > MaxRegisterLocals ||
+        std::any_of(locals.begin(), locals.end(), [](uint32_t id)
+                    { return id >= MaxNativeLocalId; }))
+    {
+        return nullptr;
+    }
+    std::vector<uint32_t> writtenLocals;
+    for (JitInstruction const &instruction : instructions)
+    {
+        if (instruction.op != Operation::SetLocal && instruction.op != Operation::IncLocalByConst)
+        {
+            continue;
+        }
+        uint32_t id = getAccessedLocals(instruction).front();
+        if (std::find(locals.begin(), locals.end(), id) != locals.end() &&
+            std::find(writtenLocals.begin(), writtenLocals.end(), id) == writtenLocals.end())
+        {
+            writtenLocals.push_back(id);
+        }
+    }
+    Assembler assembler;
+    NativeOperationWriter writer(assembler, layout, locals, writtenLocals);
+    // exits taken once local variables kept in registers don't store integers anymore, whose values are only on the stack at that point
+    std::map<size_t, size_t> typeExits;
+    auto getTypeExit = [&assembler, &typeExits](size_t index)
+    {
+        if (!typeExits.contains(index))
+        {
+            typeExits[index] = assembler.createLabel();
+        }
+        return typeExits[index];
+    };
+    // push rbx, r12, r13, r14, r15 which together with the return address keeps the stack aligned to 16 bytes for the calls
+    assembler.emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+    // mov rbx, rdi
+    assembler.emit({0x48, 0x89, 0xFB});
+    if (layout.valid)
+    {
+        writer.loadState();
+    }
+    if (writer.hasRegisterLocals())
+    {
+        writer.loadRegisterLocals(getTypeExit(entry));
+    }
+    assembler.jump(entry);
+    // jumps to instructions that were not compiled go to exits that let the interpreter continue from the target
+    std::vector<JitInstruction> resolved = instructions;
+    std::vector<size_t> indices;
+    for (JitInstruction const &instruction : instructions)
+    {
+        indices.push_back(instruction.index);
+    }
+    std::map<size_t, size_t> exits;
+    for (JitInstruction &instruction : resolved)
+    {
+        if (!instruction.target.has_value())
+        {
+            continue;
+        }
+        size_t target = instruction.target.value();
+        if (!std::binary_search(indices.begin(), indices.end(), target))
+        {
+            size_t exit = assembler.createLabel();
+            exits[exit] = target;
+            instruction.target = exit;
+        }
+    }
+    for (size_t i = 0; i < resolved.size(); i++)
+    {
+        JitInstruction const &instruction = resolved[i];
+        assembler.bind(instruction.index);
+        if (instruction.helper == nullptr)
+        {
+            if (!instruction.target.has_value())
+            {
+                return nullptr;
+            }
+            assembler.jump(instruction.target.value());
+            continue;
+        }
+        size_t slow = assembler.createLabel();
+        size_t done = assembler.createLabel();
+        size_t next = instruction.index + 1;
+        if (layout.valid && instruction.helper != bailout)
+        {
+            writer.write(instruction, slow, done);
+        }
+        assembler.bind(slow);
+        // jumping back only checks whether garbage has to be collected, which happens on every iteration of the loop,
+        // so local variables stay in registers instead of being written to the stack and checked again
+        bool keepsLocals = writer.hasRegisterLocals() && instruction.op == Operation::JumpBack;
+        if (layout.valid)
+        {
+            if (!keepsLocals)
+            {
+                writer.storeRegisterLocals();
+            }
+            writer.storeState();
+        }
+        if (keepsLocals)
+        {
+            writer.pushRegisterLocals();
+        }
+        assembler.callHelper(instruction.helper, (uint32_t)instruction.index, instruction.arg, instruction.arg2, instruction.arg3);
+        if (keepsLocals)
+        {
+            writer.popRegisterLocals();
+        }
+        if (layout.valid)
+        {
+            writer.loadState();
+        }
+        if (keepsLocals && instruction.target.has_value())
+        {
+            // cmp eax, Branch
+            assembler.emit({0x83, 0xF8, (uint8_t)HelperResult::Branch});
+            assembler.jumpIf(Equal, instruction.target.value());
+            assembler.jumpIf(Below, done);
+            writer.storeRegisterLocals();
+            assembler.jump(leaveLabel);
+        }
+        else if (instruction.target.has_value() && writer.hasRegisterLocals())
+        {
+            size_t branch = assembler.createLabel();
+            // cmp eax, Branch
+            assembler.emit({0x83, 0xF8, (uint8_t)HelperResult::Branch});
+            assembler.jumpIf(Equal, branch);
+            assembler.jumpIf(Above, leaveLabel);
+            writer.loadRegisterLocals(getTypeExit(next));
+            assembler.jump(done);
+            assembler.bind(branch);
+            writer.loadRegisterLocals(getTypeExit(instructions[i].target.value()));
+            assembler.jump(instruction.target.value());
+        }
+        else if (instruction.target.has_value())
+        {
+            // cmp eax, Branch
+            assembler.emit({0x83, 0xF8, (uint8_t)HelperResult::Branch});
+            assembler.jumpIf(Equal, instruction.target.value());
+            assembler.jumpIf(Above, leaveLabel);
+        }
+        else
+        {
+            // test eax, eax
+            assembler.emit({0x85, 0xC0});
+            assembler.jumpIf(NotEqual, leaveLabel);
+            writer.loadRegisterLocals(getTypeExit(next));
+        }
+        assembler.bind(done);
+        // instructions are sorted, so if the next instruction is not placed right after this one it was not compiled
+        // and the interpreter has to continue from it
+        if (i + 1 == resolved.size() || resolved[i + 1].index != next)
+        {
+            if (layout.valid)
+            {
+                writer.storeRegisterLocals();
+                writer.storeState();
+            }
+            assembler.callHelper(bailout, (uint32_t)next, 0, 0, 0);
+            assembler.jump(leaveLabel);
+        }
+    }
+    for (std::pair<size_t const, size_t> const &exit : exits)
+    {
+        assembler.bind(exit.first);
+        if (layout.valid)
+        {
+            writer.storeRegisterLocals();
+            writer.storeState();
+        }
+        assembler.callHelper(bailout, (uint32_t)exit.second, 0, 0, 0);
+        assembler.jump(leaveLabel);
+    }
+    for (std::pair<size_t const, size_t> const &exit : typeExits)
+    {
+        assembler.bind(exit.second);
+        writer.storeState();
+        assembler.callHelper(bailout, (uint32_t)exit.first, 0, 0, 0);
+        assembler.jump(leaveLabel);
+    }
+    assembler.bind(leaveLabel);
+    // pop r15, r14, r13, r12, rbx
+    assembler.emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B});
+    // ret
+    assembler.emit({0xC3});
+    if (!assembler.resolve())
+    {
+        return nullptr;
+    }
+
+    return _createExecutable(assembler.getCode());
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<GobLang::Jit::CompiledCode> GobLang::Jit::CompiledCode::_createExecutable(std::vector<uint8_t> const &code)
+{
+#ifdef GOB_LANG_JIT_AVAILABLE
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (code.size() + pageSize - 1) / pageSize * pageSize;
+    void *memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    // memory is never writable and executable at the same time
+    if (mprotect(memory, mappedSize, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, mappedSize);
+        return nullptr;
+    }
+    return std::unique_ptr<CompiledCode>(new CompiledCode(memory, code.size(), mappedSize));
+#else
+    return nullptr;
+#endif
+}
+
+GobLang::Jit::CompiledCode::CompiledCode(void *memory, size_t size, size_t mappedSize)
+    : m_memory(memory), m_size(size), m_mappedSize(mappedSize), m_entry(reinterpret_cast<EntryFunction>(memory))
+{
+}
+
+GobLang::Jit::CompiledCode::~CompiledCode()
+{
+#ifdef GOB_LANG_JIT_AVAILABLE
+    munmap(m_memory, m_mappedSize);
+#endif
+}
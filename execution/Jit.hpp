@@ -0,0 +1,210 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include "Operations.hpp"
+
+// native code is only generated for x86-64 systems that provide mmap, other platforms always use the interpreter
+#if defined(__x86_64__) && defined(__unix__)
+#define GOB_LANG_JIT_AVAILABLE 1
+#endif
+
+namespace GobLang
+{
+    class Machine;
+}
+
+namespace GobLang::Jit
+{
+    /**
+     * @brief Result of an operation called from the compiled code, which tells the compiled code where to continue
+     *
+     */
+    enum HelperResult : uint32_t
+    {
+        /// @brief Continue with the next instruction
+        Continue = 0,
+        /// @brief Jump to the target of the instruction
+        Branch = 1,
+        /// @brief Leave compiled code, because the function returned or the interpreter has to continue execution
+        Leave = 2,
+    };
+
+    /**
+     * @brief Function that performs a single operation for the compiled code
+     *
+     * @param machine Machine that executes the code
+     * @param pc Index of the instruction that is being executed
+     * @param arg First argument of the instruction
+     * @param arg2 Second argument of the instruction
+     * @param arg3 Third argument of the instruction
+     * @return uint32_t One of `HelperResult` values
+     */
+    using OperationHelper = uint32_t (*)(Machine *machine, uint32_t pc, uint32_t arg, uint32_t arg2, uint32_t arg3);
+
+    /**
+     * @brief Instruction of the function prepared for compilation
+     *
+     */
+    struct JitInstruction
+    {
+        /// @brief Index of the instruction in the code of the machine
+        size_t index;
+        Operation op;
+        /// @brief Operation to call or nullptr for unconditional jumps, which are performed without calling anything
+        OperationHelper helper;
+        uint32_t arg = 0;
+        uint32_t arg2 = 0;
+        uint32_t arg3 = 0;
+        /// @brief Index of the instruction to jump to if helper returns `Branch` or unconditionally if there is no helper.
+        /// For traces of loops this is the side of the branch that was not taken while the trace was recorded
+        std::optional<size_t> target = std::nullopt;
+    };
+
+    /// @brief Most local variables that compiled code keeps in registers
+    constexpr size_t MaxRegisterLocals = 5;
+
+    /// @brief Get ids of the local variables that the instruction reads or writes
+    std::vector<uint32_t> getAccessedLocals(JitInstruction const &instruction);
+
+    /**
+     * @brief Check if native version of the operation can use local variables kept in registers, which is the case for operations
+     * that only read integers from local variables or write integers into them
+     *
+     */
+    bool canAccessRegisterLocals(Operation op);
+
+    /**
+     * @brief Where the machine stores values that are used directly by the native code. Operations on integers, booleans and local variables
+     * are performed by the native code when operands have the expected types, and call their helpers otherwise
+     *
+     */
+    struct MachineLayout
+    {
+        /// @brief Whether the layout is known. Without it every operation is performed by calling its helper
+        bool valid = false;
+        /// @brief Offset of the pointer to the first value of the value stack from the start of the machine
+        int32_t stackBegin = 0;
+        /// @brief Offset of the pointer past the last value of the value stack
+        int32_t stackEnd = 0;
+        /// @brief Offset of the pointer to the end of the memory allocated for the value stack
+        int32_t stackCapacity = 0;
+        /// @brief Offset of the position of the first local variable of the current frame
+        int32_t frameBase = 0;
+        /// @brief Offset of the amount of local variables of the current frame
+        int32_t frameLocalCount = 0;
+        /// @brief Offset of the amount of values reserved for local variables of the current frame, after which the operands start
+        int32_t frameLocalCapacity = 0;
+        /// @brief Bits of integer 0, integers differ from it only in the lower 32 bits
+        uint64_t intBits = 0;
+        uint64_t falseBits = 0;
+        uint64_t trueBits = 0;
+    };
+
+    /// @brief Way in which native code is generated
+    enum class Backend
+    {
+        /// @brief Code is written instruction by instruction by the built-in x86-64 assembler
+        Assembler,
+        /// @brief Code is made by copying precompiled stencils of the instructions and patching their holes
+        Stencils,
+    };
+
+    /// @brief Whether native code can be generated on this platform
+    constexpr bool isSupported()
+    {
+#ifdef GOB_LANG_JIT_AVAILABLE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// @brief Whether stencils were built together with the interpreter, which requires GCC or Clang targeting x86-64 ELF
+    constexpr bool areStencilsSupported()
+    {
+#if defined(GOB_LANG_JIT_AVAILABLE) && defined(GOB_LANG_JIT_STENCILS)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Native x86-64 code of a single function placed in executable memory.
+     *
+     * Compiled code calls the helper of every instruction one after another with arguments of the instruction stored directly in the code,
+     * so there is no decoding or dispatching of operations, while jumps between instructions are native jumps.
+     * Common operations on integers, booleans and local variables are done by the native code itself and only call the helper
+     * if the operands have unexpected types or an error has to be reported
+     *
+     */
+    class CompiledCode
+    {
+    public:
+        CompiledCode(CompiledCode const &) = delete;
+        CompiledCode &operator=(CompiledCode const &) = delete;
+
+        /**
+         * @brief Generate native code for the instructions
+         *
+         * @param instructions Instructions sorted by index. Execution that reaches an instruction that is not in the list,
+         * either by a jump or by moving past the previous instruction, leaves the code through `bailout`
+         * @param entry Index of the instruction that starts the execution
+         * @param bailout Helper that is called when execution reaches an instruction that was not compiled, which must return `Leave`
+         * @param layout Layout of the machine used by native versions of the operations
+         * @param registerLocals Local variables that are expected to always store integers, which are kept unboxed in registers
+         * and are only written back to the stack before calling helpers. Every instruction that accesses them must be one of the operations
+         * accepted by `canAccessRegisterLocals`. Code leaves through `bailout` if any of them doesn't store an integer when code starts or after a helper
+         * @return std::unique_ptr<CompiledCode> Compiled code or nullptr if native code can not be generated
+         */
+        static std::unique_ptr<CompiledCode> compile(
+            std::vector<JitInstruction> const &instructions,
+            size_t entry,
+            OperationHelper bailout,
+            MachineLayout const &layout,
+            std::vector<uint32_t> const &registerLocals = {});
+
+        /**
+         * @brief Generate native code for the instructions by copying the stencil of every instruction one after another and patching
+         * arguments, helpers and jump targets into them. Stencils are precompiled from `stencils/Stencils.cpp` at build time,
+         * so generating code takes only a copy and a few writes per instruction
+         *
+         * @param instructions Instructions sorted by index, same as for `compile`
+         * @param entry Index of the instruction that starts the execution
+         * @param bailout Helper that is called when execution reaches an instruction that was not compiled, which must return `Leave`
+         * @param layout Layout of the machine used by native versions of the operations
+         * @return std::unique_ptr<CompiledCode> Compiled code or nullptr if native code can not be generated or stencils are not available
+         */
+        static std::unique_ptr<CompiledCode> compileWithStencils(
+            std::vector<JitInstruction> const &instructions,
+            size_t entry,
+            OperationHelper bailout,
+            MachineLayout const &layout);
+
+        /// @brief Execute the code until one of the helpers returns `Leave`
+        /// @param machine Machine that is passed to every helper
+        void run(Machine *machine) const { m_entry(machine); }
+
+        /// @brief Size of the generated code in bytes
+        size_t getSize() const { return m_size; }
+
+        ~CompiledCode();
+
+    private:
+        using EntryFunction = void (*)(Machine *);
+
+        explicit CompiledCode(void *memory, size_t size, size_t mappedSize);
+
+        /// @brief Copy the code into newly allocated executable memory
+        /// @return std::unique_ptr<CompiledCode> Compiled code or nullptr if memory could not be allocated
+        static std::unique_ptr<CompiledCode> _createExecutable(std::vector<uint8_t> const &code);
+
+        void *m_memory;
+        size_t m_size;
+        size_t m_mappedSize;
+        EntryFunction m_entry;
+    };
+}
@@ -2,224 +2,687 @@
 #include "FunctionRef.hpp"
 #include <iostream>
 #include <vector>
-GobLang::Machine::Machine(Codegen::ByteCode const &code)
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <iterator>
+GobLang::Machine::Machine()
+{
+    m_stack.reserve(DEFAULT_VALUE_STACK_SIZE);
+    m_callFrames.reserve(DEFAULT_CALL_FRAME_COUNT);
+}
+
+GobLang::Machine::Machine(Codegen::ByteCode const &code) : Machine()
 {
     m_constStrings = code.ids;
     m_operations = code.operations;
     m_functions = code.functions;
+    for (size_t i = 0; i < m_functions.size(); i++)
+    {
+        m_localFunctionRefs.push_back(allocate<FunctionRef>(i));
+    }
+    m_fieldSlotCaches.resize(code.fieldCacheCount);
+    _reserveFrame(code.maxLocalCount + code.maxStackDepth);
+    m_frame.localCapacity = code.maxLocalCount;
+    m_stack.resize(m_frame.localCapacity);
+    _decodeOperations();
     for (Struct::Structure const &structure : code.structures)
     {
         Structure *str = new Structure();
         *str = structure;
+        str->updateFieldIds();
         m_structures.push_back(std::unique_ptr<Structure>(str));
     }
 }
 void GobLang::Machine::addFunction(FunctionValue const &func, std::string const &name)
 {
-    m_globals[name] = Value(func);
+    m_globals[getGlobalSlot(name)] = GlobalVariable{.value = Value(func), .defined = true};
 }
 
 void GobLang::Machine::step()
 {
-    if (m_programCounter >= m_operations.size())
+    if (isAtTheEnd())
     {
         return;
     }
-    switch ((Operation)m_operations[m_programCounter])
+    // between operations every value in use is stored on the stack or in a variable, so this is where collection is safe
+    _collectGarbageIfNeeded();
+    _execute<true, true>(1);
+}
+
+void GobLang::Machine::run()
+{
+    _collectGarbageIfNeeded();
+    if (m_uncheckedExecution)
     {
-    case Operation::Add:
-        _add();
-        break;
-    case Operation::Sub:
-        _sub();
-        break;
-    case Operation::Mul:
-        _mul();
-        break;
-    case Operation::Div:
-        _div();
-        break;
-    case Operation::Modulo:
-        _mod();
-        break;
-    case Operation::Call:
-        _call();
-        break;
-    case Operation::GetLocalFunction:
-        _getLocalFunc();
-        break;
-    case Operation::Set:
-        _set();
-        collectGarbage();
-        break;
-    case Operation::Get:
-        _get();
-        break;
-    case Operation::GetLocal:
-        _getLocal();
-        break;
-    case Operation::BitAnd:
-        _bitAnd();
-        break;
-    case Operation::BitOr:
-        _bitOr();
-        break;
-    case Operation::BitXor:
-        _bitXor();
-        break;
-    case Operation::BitNot:
-        _bitNot();
-        break;
-    case Operation::ShiftLeft:
-        _shiftLeft();
-        break;
-    case Operation::ShiftRight:
-        _shiftRight();
-        break;
-    case Operation::SetLocal:
-        _setLocal();
-        collectGarbage();
-        break;
-    case Operation::PushConstInt:
-        _pushConstInt();
-        break;
-    case Operation::PushConstUnsignedInt:
-        _pushConstUnsignedInt();
-        break;
-    case Operation::PushConstFloat:
-        _pushConstFloat();
-        break;
-    case Operation::PushConstChar:
-        _pushConstChar();
-        break;
-    case Operation::PushConstString:
-        _pushConstString();
-        break;
-    case Operation::GetArray:
-        _getArray();
-        break;
-    case Operation::SetArray:
-        _setArray();
-        collectGarbage();
-        break;
-    case Operation::GetField:
-        _getField();
-        break;
-    case Operation::SetField:
-        _setField();
-        collectGarbage();
-        break;
-    case Operation::CallMethod:
-        _callMethod();
-        break;
-    case Operation::Jump:
-        _jump();
-        return; // this uses return because we want to avoid advancing the counter after jmp
-    case Operation::JumpBack:
-        _jumpBack();
-        return;
-    case Operation::JumpIfNot:
-        _jumpIfNot();
-        return;
-    case Operation::JumpIf:
-        _jumpIf();
-        return;
-    case Operation::PushTrue:
-        pushToStack(Value(true));
-        break;
-    case Operation::PushFalse:
-        pushToStack(Value(false));
-        break;
-    case Operation::PushNull:
-        _pushConstNull();
-        break;
-    case Operation::Equals:
-        _eq();
-        break;
-    case Operation::NotEq:
-        _neq();
-        break;
-    case Operation::Less:
-        _less();
-        break;
-    case Operation::More:
-        _more();
-        break;
-    case Operation::Not:
-        _not();
-        break;
-    case Operation::And:
-        _and();
-        break;
-    case Operation::Or:
-        _or();
-        break;
-    case Operation::LessOrEq:
-        _lessOrEq();
-        break;
-    case Operation::MoreOrEq:
-        _moreOrEq();
-        break;
-    case Operation::Negate:
-        _negate();
-        break;
-    case Operation::ShrinkLocal:
-        _shrink();
-        collectGarbage();
-        break;
-    case Operation::Return:
-        _return();
-        collectGarbage();
-        break;
-    case Operation::ReturnValue:
-        _returnWithValue();
-        break;
-    case Operation::CreateArray:
-        _createArray();
-        break;
-    case Operation::New:
-        _new();
-        break;
-    case Operation::End:
-        m_forcedEnd = true;
-        break;
-    default:
-        std::cerr << "Invalid op code: " << (int32_t)m_operations[m_programCounter] << " at " << std::hex << m_programCounter << std::dec << std::endl;
-        break;
+        // stops once the frame is not in the verified state, and the rest of the code runs with checks
+        _execute<false, false>(0);
     }
-    m_programCounter++;
+    _execute<false, true>(0);
 }
 
+size_t GobLang::Machine::run(size_t maxInstructions)
+{
+    _collectGarbageIfNeeded();
+    return _execute<true, true>(maxInstructions);
+}
+
+inline void GobLang::Machine::_collectGarbageIfNeeded()
+{
+    if (m_gc.getPhase() != CollectionPhase::Idle)
+    {
+        if (std::chrono::steady_clock::now() >= m_nextGcSlice)
+        {
+            _collectGarbageSlice();
+        }
+    }
+    else if (m_gc.shouldCollect())
+    {
+        if (m_gcPauseBudget.count() > 0)
+        {
+            _collectGarbageSlice();
+        }
+        else
+        {
+            collectGarbage(m_gc.isFullCollectionDue());
+        }
+    }
+}
+
+// Threaded dispatch jumps straight from the end of one operation to the code of the next one using a table of label addresses,
+// which is a gcc/clang extension. Other compilers use a switch inside of a loop instead
+#if defined(GOB_LANG_USE_COMPUTED_GOTO) && defined(__GNUC__)
+#define GOB_LANG_THREADED_DISPATCH 1
+#define GOB_LANG_OPERATION(name) op_##name
+#define GOB_LANG_INVALID_OPERATION op_Invalid
+#define GOB_LANG_JUMP_TO_OPERATION() goto *DispatchTable[(size_t)code[pc].op]
+#else
+#define GOB_LANG_OPERATION(name) case Operation::name
+#define GOB_LANG_INVALID_OPERATION default
+#define GOB_LANG_JUMP_TO_OPERATION() goto dispatch
+#endif
+
+// Stops execution if the end of the code was reached or enough operations were executed, otherwise continues with the operation at pc
+#define GOB_LANG_DISPATCH()                                 \
+    do                                                      \
+    {                                                       \
+        if (pc >= codeSize)                                 \
+        {                                                   \
+            goto finish;                                    \
+        }                                                   \
+        if constexpr (Limited)                              \
+        {                                                   \
+            if (executed == maxInstructions)                \
+            {                                               \
+                goto finish;                                \
+            }                                               \
+            executed++;                                     \
+        }                                                   \
+        GOB_LANG_JUMP_TO_OPERATION();                       \
+    } while (false)
+
+// Move to the next instruction and continue execution
+#define GOB_LANG_NEXT() \
+    pc++;               \
+    GOB_LANG_DISPATCH()
+
+// Unchecked execution relies on the frame having what the verifier expects, which calls and compiled code can change in any way.
+// If the frame at the given instruction doesn't match, execution stops there and continues with checks
+#define GOB_LANG_LEAVE_UNLESS_VERIFIED(next) \
+    if constexpr (!Checked)                  \
+    {                                        \
+        if (!_isInVerifiedState(next))       \
+        {                                    \
+            pc = next;                       \
+            goto finish;                     \
+        }                                    \
+    }
+
+// Runs the function whose frame was just created as native code if it was compiled. Compiled code is only used without an instruction limit,
+// because it doesn't count executed instructions
+#define GOB_LANG_ENTER_COMPILED_FUNCTION(...)             \
+    if constexpr (!Limited)                               \
+    {                                                     \
+        if (m_jitEnabled)                                 \
+        {                                                 \
+            switch (_enterCompiledFunction(__VA_ARGS__))  \
+            {                                             \
+            case JitExit::Returned:                       \
+                pc = m_programCounter;                    \
+                GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);   \
+                break;                                    \
+            case JitExit::Bailout:                        \
+                pc = m_programCounter;                    \
+                GOB_LANG_LEAVE_UNLESS_VERIFIED(pc);       \
+                GOB_LANG_DISPATCH();                      \
+            case JitExit::Exception:                      \
+                pc = m_programCounter;                    \
+                std::rethrow_exception(m_jitException);   \
+            case JitExit::NotCompiled:                    \
+                break;                                    \
+            }                                             \
+        }                                                 \
+    }
+
+// Runs the trace of the loop that the counter jumped back to if the loop was compiled. Execution continues from wherever the trace left the loop
+#define GOB_LANG_ENTER_LOOP_TRACE(jumpBack)                \
+    if constexpr (!Limited)                                \
+    {                                                      \
+        if (m_jitEnabled)                                  \
+        {                                                  \
+            m_programCounter = pc;                         \
+            switch (_enterLoopTrace(jumpBack))             \
+            {                                              \
+            case JitExit::Returned:                        \
+            case JitExit::Bailout:                         \
+                pc = m_programCounter;                     \
+                GOB_LANG_LEAVE_UNLESS_VERIFIED(pc);        \
+                break;                                     \
+            case JitExit::Exception:                       \
+                pc = m_programCounter;                     \
+                std::rethrow_exception(m_jitException);    \
+            case JitExit::NotCompiled:                     \
+                break;                                     \
+            }                                              \
+        }                                                  \
+    }
+
+// Generic operation that rewrites itself into the version specialized for the types of operands it received
+#define GOB_LANG_QUICKENING_OPERATION(name, handler)                  \
+    GOB_LANG_OPERATION(name):                                         \
+    {                                                                 \
+        Operation quickened = _getQuickenedOperation(code[pc]);      \
+        handler();                                                    \
+        code[pc].op = quickened;                                      \
+    }                                                                 \
+    GOB_LANG_NEXT()
+
+// Specialized operation that returns to the generic version if operands don't have the expected type
+#define GOB_LANG_QUICKENED_OPERATION(name, generic, handler, type, op) \
+    GOB_LANG_OPERATION(name):                                          \
+    if (!_tryBinaryOperation<type, Checked>(op))                       \
+    {                                                                  \
+        _deoptimize(code[pc], Operation::generic);                     \
+        handler();                                                     \
+    }                                                                  \
+    GOB_LANG_NEXT()
+
+template <bool Limited, bool Checked>
+size_t GobLang::Machine::_execute(size_t maxInstructions)
+{
+    size_t executed = 0;
+    if (m_forcedEnd)
+    {
+        return executed;
+    }
+    if (m_instructionsOutdated)
+    {
+        _decodeOperations();
+    }
+    // not const because quickening rewrites instructions in place
+    Instruction *code = m_instructions.data();
+    size_t const codeSize = m_instructions.size();
+    // kept in a local variable so that it can stay in a register, operations that need to read or change the counter of the machine synchronise it
+    size_t pc = m_programCounter;
+    if constexpr (!Checked)
+    {
+        if (!_isInVerifiedState(pc))
+        {
+            return executed;
+        }
+    }
+#ifdef GOB_LANG_THREADED_DISPATCH
+    static void *const DispatchTable[] = {
+        // `None` is never produced by the code generator and is reported the same way as unknown codes
+        &&op_Invalid,
+        &&op_Add,
+        &&op_Sub,
+        &&op_Mul,
+        &&op_Div,
+        &&op_Modulo,
+        &&op_Call,
+        &&op_GetLocalFunction,
+        &&op_CallLocal,
+        &&op_Set,
+        &&op_Get,
+        &&op_SetGlobalSlot,
+        &&op_GetGlobalSlot,
+        &&op_GetLocal,
+        &&op_SetLocal,
+        &&op_GetArray,
+        &&op_SetArray,
+        &&op_GetField,
+        &&op_SetField,
+        &&op_GetFieldSlot,
+        &&op_SetFieldSlot,
+        &&op_CallMethod,
+        &&op_CallMethodSlot,
+        &&op_PushConstInt,
+        &&op_PushConstUnsignedInt,
+        &&op_PushConstFloat,
+        &&op_PushConstChar,
+        &&op_PushConstString,
+        &&op_PushTrue,
+        &&op_PushFalse,
+        &&op_PushNull,
+        &&op_Equals,
+        &&op_Less,
+        &&op_More,
+        &&op_LessOrEq,
+        &&op_MoreOrEq,
+        &&op_NotEq,
+        &&op_And,
+        &&op_Or,
+        &&op_Not,
+        &&op_BitAnd,
+        &&op_BitOr,
+        &&op_BitXor,
+        &&op_BitNot,
+        &&op_ShiftLeft,
+        &&op_ShiftRight,
+        &&op_Negate,
+        &&op_Jump,
+        &&op_JumpBack,
+        &&op_JumpIfNot,
+        &&op_JumpIf,
+        &&op_ShrinkLocal,
+        &&op_Return,
+        &&op_ReturnValue,
+        &&op_CreateArray,
+        &&op_New,
+        &&op_End,
+        &&op_Discard,
+        &&op_IncLocalByConst,
+        &&op_PushLocalAddConst,
+        &&op_PushLocalSubConst,
+        &&op_JumpIfNotLessLocalConst,
+        &&op_JumpIfNotLessOrEqLocalConst,
+        &&op_JumpIfNotLessLocals,
+        &&op_GetLocalField,
+        &&op_SetLocalField,
+        &&op_AddInt,
+        &&op_AddUnsignedInt,
+        &&op_AddFloat,
+        &&op_AddString,
+        &&op_SubInt,
+        &&op_SubUnsignedInt,
+        &&op_SubFloat,
+        &&op_MulInt,
+        &&op_MulUnsignedInt,
+        &&op_MulFloat,
+        &&op_DivInt,
+        &&op_DivUnsignedInt,
+        &&op_DivFloat,
+        &&op_LessInt,
+        &&op_LessFloat,
+        &&op_MoreInt,
+        &&op_MoreFloat,
+        &&op_LessOrEqInt,
+        &&op_LessOrEqFloat,
+        &&op_MoreOrEqInt,
+        &&op_MoreOrEqFloat,
+    };
+    static_assert(sizeof(DispatchTable) / sizeof(DispatchTable[0]) == (size_t)Operation::MoreOrEqFloat + 1, "Every operation must have an entry in the dispatch table");
+#endif
+    try
+    {
+        GOB_LANG_DISPATCH();
+#ifndef GOB_LANG_THREADED_DISPATCH
+    dispatch:
+        switch (code[pc].op)
+#endif
+        {
+        GOB_LANG_QUICKENING_OPERATION(Add, _add);
+        GOB_LANG_QUICKENING_OPERATION(Sub, _sub);
+        GOB_LANG_QUICKENING_OPERATION(Mul, _mul);
+        GOB_LANG_QUICKENING_OPERATION(Div, _div);
+        GOB_LANG_OPERATION(Modulo):
+            _mod();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Call):
+        {
+            // calls are where recursion allocates, so they are also checked for garbage collection
+            m_programCounter = pc;
+            _collectGarbageIfNeeded();
+            size_t depth = m_callFrames.size();
+            _call();
+            pc = m_programCounter;
+            if (m_callFrames.size() > depth)
+            {
+                GOB_LANG_ENTER_COMPILED_FUNCTION();
+            }
+            else
+            {
+                GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            }
+        }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetLocalFunction):
+            _getLocalFunc(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(CallLocal):
+            m_programCounter = pc;
+            _collectGarbageIfNeeded();
+        {
+            size_t funcId = code[pc].arg;
+            _callLocal(funcId, code[pc].arg2);
+            pc = m_programCounter;
+            GOB_LANG_ENTER_COMPILED_FUNCTION(funcId);
+        }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Set):
+            _set();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Get):
+            _get();
+            GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetGlobalSlot):
+            _setGlobalSlot(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetGlobalSlot):
+            _getGlobalSlot(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetLocal):
+            _getLocal<Checked>(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetLocal):
+            _setLocal<Checked>(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetArray):
+            _getArray();
+            GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetArray):
+            _setArray();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetField):
+            _getField();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetField):
+            _setField();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetFieldSlot):
+            _getFieldSlot(code[pc].arg, code[pc].arg2);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetFieldSlot):
+            _setFieldSlot(code[pc].arg, code[pc].arg2);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(CallMethod):
+            m_programCounter = pc;
+            _collectGarbageIfNeeded();
+            _callMethod();
+            GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(CallMethodSlot):
+            m_programCounter = pc;
+            _collectGarbageIfNeeded();
+        {
+            size_t depth = m_callFrames.size();
+            _callMethodSlot(code[pc].arg, code[pc].arg2);
+            pc = m_programCounter;
+            if (m_callFrames.size() > depth)
+            {
+                GOB_LANG_ENTER_COMPILED_FUNCTION();
+            }
+            else
+            {
+                GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            }
+        }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushConstInt):
+            pushToStack(Value(code[pc].getInt()));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushConstUnsignedInt):
+            pushToStack(Value(code[pc].arg));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushConstFloat):
+            pushToStack(Value(code[pc].getFloat()));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushConstChar):
+            pushToStack(Value((char)code[pc].arg));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushConstString):
+            _pushConstString(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushTrue):
+            pushToStack(Value(true));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushFalse):
+            pushToStack(Value(false));
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushNull):
+            _pushConstNull();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Equals):
+            _eq();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(NotEq):
+            _neq();
+            GOB_LANG_NEXT();
+        GOB_LANG_QUICKENING_OPERATION(Less, _less);
+        GOB_LANG_QUICKENING_OPERATION(More, _more);
+        GOB_LANG_OPERATION(Not):
+            _not();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(And):
+            _and();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Or):
+            _or();
+            GOB_LANG_NEXT();
+        GOB_LANG_QUICKENING_OPERATION(LessOrEq, _lessOrEq);
+        GOB_LANG_QUICKENING_OPERATION(MoreOrEq, _moreOrEq);
+        GOB_LANG_OPERATION(Negate):
+            _negate();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(BitAnd):
+            _bitAnd();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(BitOr):
+            _bitOr();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(BitXor):
+            _bitXor();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(BitNot):
+            _bitNot();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(ShiftLeft):
+            _shiftLeft();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(ShiftRight):
+            _shiftRight();
+            GOB_LANG_NEXT();
+        // targets of the jumps are converted into instruction indices when the code is decoded
+        GOB_LANG_OPERATION(Jump):
+            pc = code[pc].arg;
+            GOB_LANG_DISPATCH();
+        GOB_LANG_OPERATION(JumpBack):
+            // every loop goes through a jump back, so this is where long running code gets a chance to collect garbage
+            m_programCounter = pc;
+            _collectGarbageIfNeeded();
+        {
+            size_t jumpBack = pc;
+            pc = code[pc].arg;
+            GOB_LANG_ENTER_LOOP_TRACE(jumpBack);
+        }
+            GOB_LANG_DISPATCH();
+        GOB_LANG_OPERATION(JumpIfNot):
+            if (!_popCondition<Checked>())
+            {
+                pc = code[pc].arg;
+                GOB_LANG_DISPATCH();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(JumpIf):
+            if (_popCondition<Checked>())
+            {
+                pc = code[pc].arg;
+                GOB_LANG_DISPATCH();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(ShrinkLocal):
+            _shrink(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Return):
+            m_programCounter = pc;
+            _return();
+            pc = m_programCounter;
+            GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(ReturnValue):
+            m_programCounter = pc;
+            _returnWithValue();
+            pc = m_programCounter;
+            GOB_LANG_LEAVE_UNLESS_VERIFIED(pc + 1);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(CreateArray):
+            _createArray(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(New):
+            _new(code[pc].arg);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(Discard):
+            _discard();
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(IncLocalByConst):
+            _incLocalByConst<Checked>(code[pc].arg2, code[pc].getInt());
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushLocalAddConst):
+            _pushLocalAddConst<Checked>(code[pc].arg2, code[pc].getInt());
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(PushLocalSubConst):
+            _pushLocalSubConst<Checked>(code[pc].arg2, code[pc].getInt());
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(JumpIfNotLessLocalConst):
+            if (!_isLocalLessThanConst<Checked>(code[pc].arg2, code[pc].getInt()))
+            {
+                pc = code[pc].arg3;
+                GOB_LANG_DISPATCH();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(JumpIfNotLessOrEqLocalConst):
+            if (!_isLocalLessOrEqConst<Checked>(code[pc].arg2, code[pc].getInt()))
+            {
+                pc = code[pc].arg3;
+                GOB_LANG_DISPATCH();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(JumpIfNotLessLocals):
+            if (!_isLocalLessThanLocal<Checked>(code[pc].arg, code[pc].arg2))
+            {
+                pc = code[pc].arg3;
+                GOB_LANG_DISPATCH();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(GetLocalField):
+            _getLocal<Checked>(code[pc].arg3);
+            _getFieldSlot(code[pc].arg, code[pc].arg2);
+            GOB_LANG_NEXT();
+        GOB_LANG_OPERATION(SetLocalField):
+            _getLocal<Checked>(code[pc].arg3);
+            _setFieldSlot(code[pc].arg, code[pc].arg2);
+            GOB_LANG_NEXT();
+        GOB_LANG_QUICKENED_OPERATION(AddInt, Add, _add, int32_t, std::plus<>());
+        GOB_LANG_QUICKENED_OPERATION(AddUnsignedInt, Add, _add, uint32_t, std::plus<>());
+        GOB_LANG_QUICKENED_OPERATION(AddFloat, Add, _add, float, std::plus<>());
+        GOB_LANG_OPERATION(AddString):
+            if (!_tryAddStrings())
+            {
+                _deoptimize(code[pc], Operation::Add);
+                _add();
+            }
+            GOB_LANG_NEXT();
+        GOB_LANG_QUICKENED_OPERATION(SubInt, Sub, _sub, int32_t, std::minus<>());
+        GOB_LANG_QUICKENED_OPERATION(SubUnsignedInt, Sub, _sub, uint32_t, std::minus<>());
+        GOB_LANG_QUICKENED_OPERATION(SubFloat, Sub, _sub, float, std::minus<>());
+        GOB_LANG_QUICKENED_OPERATION(MulInt, Mul, _mul, int32_t, std::multiplies<>());
+        GOB_LANG_QUICKENED_OPERATION(MulUnsignedInt, Mul, _mul, uint32_t, std::multiplies<>());
+        GOB_LANG_QUICKENED_OPERATION(MulFloat, Mul, _mul, float, std::multiplies<>());
+        GOB_LANG_QUICKENED_OPERATION(DivInt, Div, _div, int32_t, std::divides<>());
+        GOB_LANG_QUICKENED_OPERATION(DivUnsignedInt, Div, _div, uint32_t, std::divides<>());
+        GOB_LANG_QUICKENED_OPERATION(DivFloat, Div, _div, float, std::divides<>());
+        GOB_LANG_QUICKENED_OPERATION(LessInt, Less, _less, int32_t, std::less<>());
+        GOB_LANG_QUICKENED_OPERATION(LessFloat, Less, _less, float, std::less<>());
+        GOB_LANG_QUICKENED_OPERATION(MoreInt, More, _more, int32_t, std::greater<>());
+        GOB_LANG_QUICKENED_OPERATION(MoreFloat, More, _more, float, std::greater<>());
+        GOB_LANG_QUICKENED_OPERATION(LessOrEqInt, LessOrEq, _lessOrEq, int32_t, std::less_equal<>());
+        GOB_LANG_QUICKENED_OPERATION(LessOrEqFloat, LessOrEq, _lessOrEq, float, std::less_equal<>());
+        GOB_LANG_QUICKENED_OPERATION(MoreOrEqInt, MoreOrEq, _moreOrEq, int32_t, std::greater_equal<>());
+        GOB_LANG_QUICKENED_OPERATION(MoreOrEqFloat, MoreOrEq, _moreOrEq, float, std::greater_equal<>());
+        GOB_LANG_OPERATION(End):
+            m_forcedEnd = true;
+            pc++;
+            goto finish;
+        GOB_LANG_INVALID_OPERATION:
+            std::cerr << "Invalid op code: " << (int32_t)code[pc].op << " at " << std::hex << m_instructionAddresses[pc] << std::dec << std::endl;
+            GOB_LANG_NEXT();
+        }
+    }
+    catch (...)
+    {
+        m_programCounter = pc;
+        throw;
+    }
+finish:
+    m_programCounter = pc;
+    return executed;
+}
+
+#undef GOB_LANG_QUICKENED_OPERATION
+#undef GOB_LANG_QUICKENING_OPERATION
+#undef GOB_LANG_ENTER_COMPILED_FUNCTION
+#undef GOB_LANG_ENTER_LOOP_TRACE
+#undef GOB_LANG_LEAVE_UNLESS_VERIFIED
+#undef GOB_LANG_NEXT
+#undef GOB_LANG_DISPATCH
+#undef GOB_LANG_JUMP_TO_OPERATION
+#undef GOB_LANG_INVALID_OPERATION
+#undef GOB_LANG_OPERATION
+#undef GOB_LANG_THREADED_DISPATCH
+
 void GobLang::Machine::printGlobalsInfo()
 {
-    for (std::map<std::string, Value>::iterator it = m_globals.begin(); it != m_globals.end(); it++)
+    for (size_t i = 0; i < m_globals.size(); i++)
     {
-        std::cout << it->first << "(" << typeToString((Type)it->second.index()) << ")" << " = " << valueToString(it->second, true, 0) << std::endl;
+        if (m_globals[i].defined)
+        {
+            Value const &value = m_globals[i].value;
+            std::cout << m_globalNames[i] << "(" << typeToString(value.getType()) << ")" << " = " << valueToString(value, true, 0) << std::endl;
+        }
     }
 }
 
 void GobLang::Machine::printVariablesInfo()
 {
-    std::cout << "Local(" << m_variables.size() << "):" << std::endl;
-    for (std::vector<std::vector<Value>>::iterator layerIt = m_variables.begin(); layerIt != m_variables.end(); layerIt++)
+    std::cout << "Local(" << m_callFrames.size() + 1 << "):" << std::endl;
+    for (size_t i = 0; i <= m_callFrames.size(); i++)
     {
-        std::cout << "Frame: " << layerIt - m_variables.begin() << std::endl;
-        for (std::vector<Value>::iterator it = layerIt->begin(); it != layerIt->end(); it++)
+        CallFrame const &frame = i < m_callFrames.size() ? m_callFrames[i] : m_frame;
+        std::cout << "Frame: " << i << std::endl;
+        for (size_t j = 0; j < frame.localCount; j++)
         {
-            std::cout << it - layerIt->begin() << ": " << typeToString((Type)it->index()) << " = " << valueToString(*it, true, 0) << std::endl;
+            Value const &val = m_stack[frame.base + j];
+            std::cout << j << ": " << typeToString(val.getType()) << " = " << valueToString(val, true, 0) << std::endl;
         }
     }
 }
 
 void GobLang::Machine::printStack()
 {
-    std::cout << "Stack(" << m_operationStack.size() << "):" << std::endl;
-    for (std::vector<std::vector<Value>>::iterator layerIt = m_operationStack.begin(); layerIt != m_operationStack.end(); layerIt++)
+    std::cout << "Stack(" << m_callFrames.size() + 1 << "):" << std::endl;
+    for (size_t i = 0; i <= m_callFrames.size(); i++)
     {
-        std::cout << "Frame: " << layerIt - m_operationStack.begin() << std::endl;
-        for (std::vector<Value>::reverse_iterator it = layerIt->rbegin(); it != layerIt->rend(); it++)
+        CallFrame const &frame = i < m_callFrames.size() ? m_callFrames[i] : m_frame;
+        // operands of the frame end where the next frame starts
+        size_t end = i + 1 < m_callFrames.size() ? m_callFrames[i + 1].base : (i < m_callFrames.size() ? m_frame.base : m_stack.size());
+        std::cout << "Frame: " << i << std::endl;
+        for (size_t j = end; j > frame.base + frame.localCapacity; j--)
         {
-            std::cout << it - layerIt->rbegin() << ": " << typeToString((Type)it->index()) << " = " << valueToString(*it, true, 0) << std::endl;
+            Value const &val = m_stack[j - 1];
+            std::cout << end - j << ": " << typeToString(val.getType()) << " = " << valueToString(val, true, 0) << std::endl;
         }
     }
 }
@@ -227,50 +690,50 @@ void GobLang::Machine::printStack()
 GobLang::Value *GobLang::Machine::getStackTop()
 
 {
-    if (m_operationStack.back().empty())
+    if (m_stack.size() <= _getOperandBase())
     {
         return nullptr;
     }
     else
     {
-        return &m_operationStack.back()[m_operationStack.size() - 1];
+        return &m_stack.back();
     }
 }
 
 GobLang::Value GobLang::Machine::getStackTopAndPop()
 {
-    if (m_operationStack.back().empty())
+    if (m_stack.size() <= _getOperandBase())
     {
         throw RuntimeException("Unable to get value from the stack because stack is empty");
     }
-    return _getFromTopAndPop();
+    Value v = _getFromTopAndPop();
+    if (m_nativeCallDepth > 0 && v.getType() == Type::MemoryObj)
+    {
+        m_nativeRoots.push_back(v.as<MemoryNode *>());
+    }
+    return v;
 }
 
-GobLang::ArrayNode *GobLang::Machine::createArrayOfSize(int32_t size)
+GobLang::ArrayNode *GobLang::Machine::createArrayOfSize(int32_t size, ArrayElementType type)
 {
-    ArrayNode *node = new ArrayNode(size);
-    addObject(node);
+    ArrayNode *node = allocate<ArrayNode>(size, type);
     return node;
 }
 
 GobLang::StringNode *GobLang::Machine::createString(std::string const &str, bool alwaysNew)
 {
-    MemoryNode *root = &m_memoryRoot;
-    StringNode *node = nullptr;
-    // avoid making instance for each call, check if there is anything that uses this already
-    while (root != nullptr && !alwaysNew)
+    if (!alwaysNew)
     {
-        if (StringNode *strNode = dynamic_cast<StringNode *>(root); strNode != nullptr && strNode->getString() == str)
+        // avoid making instance for each call, check if there is anything that uses this already
+        if (StringNode *node = m_gc.findInternedString(str); node != nullptr)
         {
-            node = strNode;
-            break;
+            return node;
         }
-        root = root->getNext();
     }
-    if (node == nullptr)
+    StringNode *node = allocate<StringNode>(str);
+    if (!alwaysNew)
     {
-        node = new StringNode(str);
-        addObject(node);
+        m_gc.internString(node);
     }
     return node;
 }
@@ -279,130 +742,141 @@ void GobLang::Machine::addObject(MemoryNode *obj)
 {
     if (!obj->isRegistered())
     {
-        m_memoryRoot.pushBack(obj);
-        obj->registerGC();
+        m_gc.addObject(obj);
+        if (m_nativeCallDepth > 0)
+        {
+            m_nativeRoots.push_back(obj);
+        }
     }
 }
 
 void GobLang::Machine::popStack()
 {
-    m_operationStack.back().pop_back();
+    m_stack.pop();
 }
 
 void GobLang::Machine::pushToStack(Value const &val)
 {
-    m_operationStack.back().push_back(val);
+    m_stack.push(val);
 }
 
 void GobLang::Machine::pushIntToStack(int32_t val)
 {
-    m_operationStack.back().push_back(Value(val));
+    m_stack.push(Value(val));
 }
 
 void GobLang::Machine::pushFloatToStack(float val)
 {
-    m_operationStack.back().push_back(Value(val));
+    m_stack.push(Value(val));
 }
 
 void GobLang::Machine::pushObjectToStack(MemoryNode *obj)
 {
-    m_operationStack.back().push_back(Value(obj));
+    m_stack.push(Value(obj));
 }
 
 void GobLang::Machine::setLocalVariableValue(size_t id, Value const &val)
 {
-    std::vector<Value> &varFrame = m_variables.back();
-    if (id >= varFrame.size())
+    if (id >= m_frame.localCount)
     {
-        varFrame.resize(id + 1);
-    }
-    if ((Type)val.index() == Type::MemoryObj)
-    {
-        std::get<MemoryNode *>(val)->increaseRefCount();
-    }
-    if ((Type)varFrame[id].index() == Type::MemoryObj)
-    {
-        std::get<MemoryNode *>(varFrame[id])->decreaseRefCount();
+        if (id >= m_frame.localCapacity)
+        {
+            // only frames of code with unknown size grow here, which moves the operands that are already on the stack
+            m_stack.insert(_getOperandBase(), id + 1 - m_frame.localCapacity);
+            m_frame.localCapacity = id + 1;
+        }
+        m_frame.localCount = id + 1;
     }
-    varFrame[id] = val;
+    m_stack[m_frame.base + id] = val;
 }
 
 GobLang::Value *GobLang::Machine::getLocalVariableValue(size_t id)
 {
-    if (m_variables.back().size() < id)
+    if (m_frame.localCount <= id)
     {
         return nullptr;
     }
-    return &m_variables.back()[id];
+    return &m_stack[m_frame.base + id];
 }
 
 void GobLang::Machine::shrinkLocalVariableStackBy(size_t size)
 {
-    size_t i = 0;
-    for (std::vector<Value>::reverse_iterator it = m_variables.back().rbegin(); it != m_variables.back().rend() && i < size; it++, i++)
-    {
-        if ((Type)it->index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>((*it))->decreaseRefCount();
-        }
-    }
-    m_variables.back().resize(m_variables.back().size() - size);
+    // values stay reserved for the variables created later, but must not keep objects alive
+    size_t end = m_frame.base + m_frame.localCount;
+    size = std::min(size, m_frame.localCount);
+    std::fill(m_stack.begin() + (end - size), m_stack.begin() + end, Value());
+    m_frame.localCount -= size;
 }
 
 void GobLang::Machine::removeFunctionFrame()
 {
-    if (m_variables.size() == 1)
+    if (m_callFrames.empty())
     {
         throw RuntimeException("Attempted to remove root variable stack frame");
     }
-    std::vector<Value> &frame = m_variables.back();
-    for (std::vector<Value>::const_iterator it = frame.begin(); it != frame.end(); it++)
-    {
-        if ((Type)it->index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>((*it))->decreaseRefCount();
-        }
-    }
-    m_variables.pop_back();
-    std::vector<Value> &stackFrame = m_operationStack.back();
-    for (std::vector<Value>::const_iterator it = stackFrame.begin(); it != stackFrame.end(); it++)
+    m_stack.resize(m_frame.base);
+    m_frame = m_callFrames.back();
+    m_callFrames.pop_back();
+}
+
+void GobLang::Machine::_reserveFrame(size_t size)
+{
+    size_t end = m_frame.base + size;
+    if (end > m_stack.capacity())
     {
-        if ((Type)it->index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>((*it))->decreaseRefCount();
-        }
+        // stack still grows at least twice at a time, otherwise every level of recursion would copy the whole stack
+        m_stack.reserve(std::max(end, m_stack.capacity() * 2));
     }
-    m_operationStack.pop_back();
 }
 
 void GobLang::Machine::callLocalFunction(size_t funcId)
 {
-    if (funcId > m_functions.size())
+    if (funcId >= m_functions.size())
     {
         throw RuntimeException(std::string("Attempted to call function with id ") + std::to_string(funcId) + " but no function uses that id");
     }
-    m_callStack.push_back(m_programCounter);
-    m_programCounter = m_functions[funcId].start - 1;
-    std::vector<Value> args = std::vector<Value>(m_functions[funcId].arguments.size());
+    size_t argCount = m_functions[funcId].arguments.size();
+    if (m_stack.size() < _getOperandBase() + argCount)
+    {
+        throw RuntimeException("Can not pop from stack because stack is empty");
+    }
+    m_callFrames.push_back(m_frame);
+    // arguments are already on top of the stack, so they become the first local variables of the new frame
+    size_t localCapacity = std::max(argCount, m_functions[funcId].maxLocalCount);
+    m_frame = CallFrame{.returnAddress = m_programCounter, .base = m_stack.size() - argCount, .localCount = argCount, .localCapacity = localCapacity};
+    _reserveFrame(localCapacity + m_functions[funcId].maxStackDepth);
+    // there are no operands yet, so values for the rest of the variables are added at the end of the stack
+    m_stack.resize(m_frame.base + localCapacity);
+    // counter is advanced after the call, so it has to point to the instruction before the start of the function
+    m_programCounter = m_addressInstructions[m_functions[funcId].start] - 1;
+}
 
-    std::vector<Value> &variableFrame = m_variables.back();
+void GobLang::Machine::createVariable(std::string const &name, Value const &value)
+{
+    m_globals[getGlobalSlot(name)] = GlobalVariable{.value = value, .defined = true};
+}
 
-    for (std::vector<Value>::reverse_iterator it = args.rbegin(); it != args.rend(); it++)
+GobLang::Value GobLang::Machine::getVariableValue(std::string const &name)
+{
+    std::map<std::string, size_t>::const_iterator it = m_globalSlots.find(name);
+    if (it == m_globalSlots.end())
     {
-        *it = _getFromTopAndPop();
-        // for the entirety of the value being in the function we assume that it is in use so we can not delete it
-        if ((Type)it->index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>((*it))->increaseRefCount();
-        }
+        return Value(nullptr);
     }
-    m_variables.push_back(args);
-    m_operationStack.push_back({});
+    return m_globals[it->second].value;
 }
 
-void GobLang::Machine::createVariable(std::string const &name, Value const &value)
+size_t GobLang::Machine::getGlobalSlot(std::string const &name)
 {
-    m_globals[name] = value;
+    std::map<std::string, size_t>::const_iterator it = m_globalSlots.find(name);
+    if (it != m_globalSlots.end())
+    {
+        return it->second;
+    }
+    m_globals.push_back(GlobalVariable{});
+    m_globalNames.push_back(name);
+    m_globalSlots[name] = m_globals.size() - 1;
+    return m_globals.size() - 1;
 }
 
 void GobLang::Machine::createType(std::string const &name, FunctionValue const &constructor, std::map<std::string, FunctionValue> const &methods)
@@ -423,146 +897,379 @@ NativeStructureInfo const *GobLang::Machine::getNativeStructure(std::string cons
     return nullptr;
 }
 
-void GobLang::Machine::collectGarbage()
+void GobLang::Machine::collectGarbage(bool full)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    _finishGarbageCollection();
+    m_gc.startCollection(full);
+    _markRoots();
+    m_gc.collect();
+    m_gc.recordPause(std::chrono::steady_clock::now() - start);
+}
+
+void GobLang::Machine::setGarbageCollectionThreshold(size_t allocations)
+{
+    m_gc.setThreshold(allocations);
+}
+
+GobLang::Machine::~Machine()
+{
+}
+
+void GobLang::Machine::_markRoots()
 {
-    MemoryNode *prev = &m_memoryRoot;
-    MemoryNode *curr = m_memoryRoot.getNext();
-    while (curr != nullptr)
+    for (Value const &val : m_stack)
+    {
+        m_gc.markValue(val);
+    }
+    for (FunctionRef *ref : m_localFunctionRefs)
     {
-        if (!curr->isDead())
+        m_gc.markObject(ref);
+    }
+    for (GlobalVariable const &global : m_globals)
+    {
+        m_gc.markValue(global.value);
+    }
+    for (MemoryNode *obj : m_nativeRoots)
+    {
+        m_gc.markObject(obj);
+    }
+}
+
+void GobLang::Machine::_collectGarbageSlice()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = m_gcPauseBudget.count() > 0 ? start + m_gcPauseBudget : std::chrono::steady_clock::time_point::max();
+    switch (m_gc.getPhase())
+    {
+    case CollectionPhase::Idle:
+        if (!m_gc.isFullCollectionDue())
         {
-            prev = curr;
-            curr = curr->getNext();
-            continue;
+            m_gc.startCollection(false);
+            _markRoots();
+            m_gc.collect();
+            break;
+        }
+        m_gc.startIncrementalCollection();
+        _markRoots();
+        [[fallthrough]];
+    case CollectionPhase::Marking:
+        if (!m_gc.traceUntil(deadline))
+        {
+            break;
         }
-        // if we are deleting then prev should stay the same while
-        // curr gets deleted
-        MemoryNode *del = curr;
-        prev->eraseNext();
-        curr = prev->getNext();
+        // stack and variables are not covered by the write barrier so they might hold objects that were not marked yet
+        _markRoots();
+        m_gc.finishMarking();
+        [[fallthrough]];
+    case CollectionPhase::Sweeping:
+        m_gc.sweepUntil(deadline);
+        break;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    m_gc.recordPause(end - start);
+    m_nextGcSlice = end + (end - start);
+}
 
-        delete del;
+void GobLang::Machine::_finishGarbageCollection()
+{
+    if (m_gc.getPhase() == CollectionPhase::Marking)
+    {
+        _markRoots();
+        m_gc.finishMarking();
+    }
+    if (m_gc.getPhase() == CollectionPhase::Sweeping)
+    {
+        m_gc.sweepUntil(std::chrono::steady_clock::time_point::max());
     }
 }
 
-GobLang::Machine::~Machine()
+void GobLang::Machine::_callNative(FunctionValue func)
 {
-    MemoryNode *root = m_memoryRoot.getNext();
-    while (root != nullptr)
+    m_nativeCallDepth++;
+    func(this);
+    m_nativeCallDepth--;
+    if (m_nativeCallDepth == 0)
     {
-        MemoryNode *del = root;
-        root = root->getNext();
-        delete del;
+        m_nativeRoots.clear();
     }
 }
 
-GobLang::ProgramAddressType GobLang::Machine::_getAddressFromByteCode(size_t start)
+// superinstructions handle the most common case of integers directly and use the operations they replaced for everything else,
+// so that results and errors are the same as for the original operations
+template <bool Checked>
+inline void GobLang::Machine::_incLocalByConst(size_t id, int32_t value)
 {
-    ProgramAddressType reconAddr = 0x0;
-    for (int32_t i = 0; i < sizeof(ProgramAddressType); i++)
+    if (Value *local = _getLocalValue<Checked>(id); local != nullptr && local->is<int32_t>())
     {
-        ProgramAddressType offset = (sizeof(ProgramAddressType) - i - 1) * 8;
-        reconAddr |= (ProgramAddressType)(m_operations[start + i]) << offset;
+        *local = local->as<int32_t>() + value;
+        return;
     }
-    return reconAddr;
+    _getLocal(id);
+    pushToStack(Value(value));
+    _add();
+    _setLocal(id);
 }
 
-void GobLang::Machine::_jump()
+template <bool Checked>
+inline void GobLang::Machine::_pushLocalAddConst(size_t id, int32_t value)
 {
-    ProgramAddressType dest = _getAddressFromByteCode(m_programCounter + 1);
-    m_programCounter += dest;
+    if (Value *local = _getLocalValue<Checked>(id); local != nullptr && local->is<int32_t>())
+    {
+        pushToStack(Value(local->as<int32_t>() + value));
+        return;
+    }
+    _getLocal(id);
+    pushToStack(Value(value));
+    _add();
 }
 
-void GobLang::Machine::_jumpIfNot()
+template <bool Checked>
+inline void GobLang::Machine::_pushLocalSubConst(size_t id, int32_t value)
 {
-    ProgramAddressType dest = _getAddressFromByteCode(m_programCounter + 1);
+    if (Value *local = _getLocalValue<Checked>(id); local != nullptr && local->is<int32_t>())
+    {
+        pushToStack(Value(local->as<int32_t>() - value));
+        return;
+    }
+    _getLocal(id);
+    pushToStack(Value(value));
+    _sub();
+}
 
-    Value a = _getFromTopAndPop();
-    if ((Type)a.index() == Type::Bool)
+template <bool Checked>
+inline bool GobLang::Machine::_isLocalLessThanConst(size_t id, int32_t value)
+{
+    if (Value *local = _getLocalValue<Checked>(id); local != nullptr && local->is<int32_t>())
     {
-        if (!std::get<bool>(a))
-        {
-            m_programCounter = dest + m_programCounter;
-        }
-        else
-        {
-            m_programCounter += sizeof(ProgramAddressType) + 1;
-        }
+        return local->as<int32_t>() < value;
     }
-    else
+    _getLocal(id);
+    pushToStack(Value(value));
+    _less();
+    return _popCondition();
+}
+
+template <bool Checked>
+inline bool GobLang::Machine::_isLocalLessOrEqConst(size_t id, int32_t value)
+{
+    if (Value *local = _getLocalValue<Checked>(id); local != nullptr && local->is<int32_t>())
     {
-        throw RuntimeException(std::string("Invalid data type passed to condition check. Expected bool got: ") + typeToString((Type)a.index()));
+        return local->as<int32_t>() <= value;
     }
+    _getLocal(id);
+    pushToStack(Value(value));
+    _lessOrEq();
+    return _popCondition();
 }
 
-inline void GobLang::Machine::_jumpIf()
+template <bool Checked>
+inline bool GobLang::Machine::_isLocalLessThanLocal(size_t a, size_t b)
 {
-    ProgramAddressType dest = _getAddressFromByteCode(m_programCounter + 1);
+    Value *localA = _getLocalValue<Checked>(a);
+    Value *localB = _getLocalValue<Checked>(b);
+    if (localA != nullptr && localB != nullptr && localA->is<int32_t>() && localB->is<int32_t>())
+    {
+        return localA->as<int32_t>() < localB->as<int32_t>();
+    }
+    _getLocal(a);
+    _getLocal(b);
+    _less();
+    return _popCondition();
+}
 
-    Value a = _getFromTopAndPop();
-    if ((Type)a.index() == Type::Bool)
+inline GobLang::Operation GobLang::Machine::_getQuickenedOperation(Instruction const &instruction)
+{
+    // generic operations have no arguments, so the argument marks operations that were already deoptimized and must stay generic
+    ValueStack const &stack = m_stack;
+    if (instruction.arg != 0 || stack.size() < _getOperandBase() + 2 || stack[stack.size() - 1].getType() != stack[stack.size() - 2].getType())
     {
-        if (std::get<bool>(a))
+        return instruction.op;
+    }
+    switch (stack.back().getType())
+    {
+    case Type::Int:
+        switch (instruction.op)
         {
-            m_programCounter = dest + m_programCounter;
+        case Operation::Add:
+            return Operation::AddInt;
+        case Operation::Sub:
+            return Operation::SubInt;
+        case Operation::Mul:
+            return Operation::MulInt;
+        case Operation::Div:
+            return Operation::DivInt;
+        case Operation::Less:
+            return Operation::LessInt;
+        case Operation::More:
+            return Operation::MoreInt;
+        case Operation::LessOrEq:
+            return Operation::LessOrEqInt;
+        case Operation::MoreOrEq:
+            return Operation::MoreOrEqInt;
+        default:
+            return instruction.op;
         }
-        else
+    case Type::UnsignedInt:
+        switch (instruction.op)
         {
-            m_programCounter += sizeof(ProgramAddressType) + 1;
+        case Operation::Add:
+            return Operation::AddUnsignedInt;
+        case Operation::Sub:
+            return Operation::SubUnsignedInt;
+        case Operation::Mul:
+            return Operation::MulUnsignedInt;
+        case Operation::Div:
+            return Operation::DivUnsignedInt;
+        default:
+            return instruction.op;
         }
+    case Type::Float:
+        switch (instruction.op)
+        {
+        case Operation::Add:
+            return Operation::AddFloat;
+        case Operation::Sub:
+            return Operation::SubFloat;
+        case Operation::Mul:
+            return Operation::MulFloat;
+        case Operation::Div:
+            return Operation::DivFloat;
+        case Operation::Less:
+            return Operation::LessFloat;
+        case Operation::More:
+            return Operation::MoreFloat;
+        case Operation::LessOrEq:
+            return Operation::LessOrEqFloat;
+        case Operation::MoreOrEq:
+            return Operation::MoreOrEqFloat;
+        default:
+            return instruction.op;
+        }
+    case Type::MemoryObj:
+        if (instruction.op == Operation::Add &&
+            node_cast<StringNode>(stack[stack.size() - 1].as<MemoryNode *>()) != nullptr &&
+            node_cast<StringNode>(stack[stack.size() - 2].as<MemoryNode *>()) != nullptr)
+        {
+            return Operation::AddString;
+        }
+        return instruction.op;
+    default:
+        return instruction.op;
     }
-    else
+}
+
+inline void GobLang::Machine::_deoptimize(Instruction &instruction, Operation generic)
+{
+    instruction.op = generic;
+    instruction.arg = 1;
+    m_deoptimizationCount++;
+}
+
+inline bool GobLang::Machine::_tryAddStrings()
+{
+    ValueStack &stack = m_stack;
+    size_t size = stack.size();
+    if (size < _getOperandBase() + 2 || !stack[size - 2].is<MemoryNode *>() || !stack[size - 1].is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Invalid data type passed to condition check. Expected bool got: ") + typeToString((Type)a.index()));
+        return false;
     }
+    StringNode *str1 = node_cast<StringNode>(stack[size - 2].as<MemoryNode *>());
+    StringNode *str2 = node_cast<StringNode>(stack[size - 1].as<MemoryNode *>());
+    if (str1 == nullptr || str2 == nullptr)
+    {
+        return false;
+    }
+    // both strings stay on the stack while the new one is created, so they can't be collected
+    Value result = createString(str1->getString() + str2->getString());
+    stack.pop();
+    stack.back() = result;
+    return true;
+}
+
+GobLang::QuickeningStats GobLang::Machine::getQuickeningStats() const
+{
+    QuickeningStats stats;
+    stats.deoptimizations = m_deoptimizationCount;
+    for (Instruction const &instruction : m_instructions)
+    {
+        switch (instruction.op)
+        {
+        case Operation::Add:
+        case Operation::Sub:
+        case Operation::Mul:
+        case Operation::Div:
+        case Operation::Less:
+        case Operation::More:
+        case Operation::LessOrEq:
+        case Operation::MoreOrEq:
+            if (instruction.arg != 0)
+            {
+                stats.polymorphicSites++;
+            }
+            else
+            {
+                stats.genericSites++;
+            }
+            break;
+        default:
+            if (instruction.op >= Operation::AddInt && instruction.op <= Operation::MoreOrEqFloat)
+            {
+                stats.monomorphicSites++;
+            }
+            break;
+        }
+    }
+    return stats;
 }
 
-inline void GobLang::Machine::_jumpBack()
+template <bool Checked>
+inline bool GobLang::Machine::_popCondition()
 {
-    ProgramAddressType dest = _getAddressFromByteCode(m_programCounter + 1);
-    if (dest > m_programCounter)
+    Value a = _getFromTopAndPop<Checked>();
+    if (a.getType() != Type::Bool)
     {
-        throw RuntimeException("Jump back offset is larger than the PC");
+        throw RuntimeException(std::string("Invalid data type passed to condition check. Expected bool got: ") + typeToString(a.getType()));
     }
-    m_programCounter -= dest;
+    return a.as<bool>();
 }
 
 void GobLang::Machine::_add()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
-        throw RuntimeException(std::string("Attempted to add values of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to add values of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
     Value c;
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        c = std::get<int32_t>(a) + std::get<int32_t>(b);
+        c = a.as<int32_t>() + b.as<int32_t>();
         break;
     case Type::UnsignedInt:
-        c = std::get<uint32_t>(a) + std::get<uint32_t>(b);
+        c = a.as<uint32_t>() + b.as<uint32_t>();
         break;
     case Type::Float:
-        c = std::get<float>(a) + std::get<float>(b);
+        c = a.as<float>() + b.as<float>();
         break;
     case Type::MemoryObj:
     {
-        StringNode *str1 = dynamic_cast<StringNode *>(std::get<MemoryNode *>(a));
-        StringNode *str2 = dynamic_cast<StringNode *>(std::get<MemoryNode *>(b));
+        StringNode *str1 = node_cast<StringNode>(a.as<MemoryNode *>());
+        StringNode *str2 = node_cast<StringNode>(b.as<MemoryNode *>());
         if (str1 != nullptr && str2 != nullptr)
         {
             c = createString(str1->getString() + str2->getString());
         }
         else
         {
-            throw RuntimeException(std::string("Invalid type used for math operation: ") + typeToString((Type)a.index()));
+            throw RuntimeException(std::string("Invalid type used for math operation: ") + typeToString(a.getType()));
         }
     }
     break;
     default:
-        throw RuntimeException(std::string("Invalid type used for math operation: ") + typeToString((Type)a.index()));
+        throw RuntimeException(std::string("Invalid type used for math operation: ") + typeToString(a.getType()));
     }
     pushToStack(c);
 }
@@ -571,24 +1278,24 @@ void GobLang::Machine::_sub()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
-        throw RuntimeException(std::string("Attempted to add values of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to add values of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
     Value c;
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        c = std::get<int32_t>(b) - std::get<int32_t>(a);
+        c = b.as<int32_t>() - a.as<int32_t>();
         break;
     case Type::UnsignedInt:
-        c = std::get<uint32_t>(b) - std::get<uint32_t>(a);
+        c = b.as<uint32_t>() - a.as<uint32_t>();
         break;
     case Type::Float:
-        c = std::get<float>(b) - std::get<float>(a);
+        c = b.as<float>() - a.as<float>();
         break;
     default:
-        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString((Type)a.index()));
+        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString(a.getType()));
     }
     pushToStack(c);
 }
@@ -597,24 +1304,24 @@ void GobLang::Machine::_mul()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
-        throw RuntimeException(std::string("Attempted to add values of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to add values of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
     Value c;
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        c = std::get<int32_t>(b) * std::get<int32_t>(a);
+        c = b.as<int32_t>() * a.as<int32_t>();
         break;
     case Type::UnsignedInt:
-        c = std::get<uint32_t>(b) * std::get<uint32_t>(a);
+        c = b.as<uint32_t>() * a.as<uint32_t>();
         break;
     case Type::Float:
-        c = std::get<float>(b) * std::get<float>(a);
+        c = b.as<float>() * a.as<float>();
         break;
     default:
-        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString((Type)a.index()));
+        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString(a.getType()));
     }
     pushToStack(c);
 }
@@ -623,24 +1330,24 @@ void GobLang::Machine::_div()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
-        throw RuntimeException(std::string("Attempted to add values of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to add values of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
     Value c;
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        c = std::get<int32_t>(b) / std::get<int32_t>(a);
+        c = b.as<int32_t>() / a.as<int32_t>();
         break;
     case Type::UnsignedInt:
-        c = std::get<uint32_t>(b) / std::get<uint32_t>(a);
+        c = b.as<uint32_t>() / a.as<uint32_t>();
         break;
     case Type::Float:
-        c = std::get<float>(b) / std::get<float>(a);
+        c = b.as<float>() / a.as<float>();
         break;
     default:
-        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString((Type)a.index()));
+        throw RuntimeException(std::string("Invalid type used for math operation") + typeToString(a.getType()));
     }
     pushToStack(c);
 }
@@ -649,17 +1356,17 @@ inline void GobLang::Machine::_mod()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
         throw RuntimeException("Type mismatch in modulo operation");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) % std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() % a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) % std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() % a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
@@ -671,55 +1378,268 @@ void GobLang::Machine::_set()
     // (name val =)
     Value name = _getFromTopAndPop();
     Value val = _getFromTopAndPop();
-    StringNode *memStr = dynamic_cast<StringNode *>(std::get<MemoryNode *>(name));
+    StringNode *memStr = name.is<MemoryNode *>() ? node_cast<StringNode>(name.as<MemoryNode *>()) : nullptr;
     if (memStr != nullptr)
     {
-        if ((Type)val.index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>(val)->increaseRefCount();
-        }
-        if (m_globals.count(memStr->getString()) > 0 && (Type)m_globals[memStr->getString()].index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>(m_globals[memStr->getString()])->decreaseRefCount();
-        }
-        m_globals[memStr->getString()] = val;
+        m_globals[getGlobalSlot(memStr->getString())] = GlobalVariable{.value = val, .defined = true};
     }
 }
 
 void GobLang::Machine::_get()
 {
     Value name = _getFromTopAndPop();
-    assert(std::holds_alternative<MemoryNode *>(name));
-    StringNode *memStr = dynamic_cast<StringNode *>(std::get<MemoryNode *>(name));
+    StringNode *memStr = name.is<MemoryNode *>() ? node_cast<StringNode>(name.as<MemoryNode *>()) : nullptr;
     if (memStr != nullptr)
     {
-        if (m_globals.count(memStr->getString()) < 1)
+        std::map<std::string, size_t>::const_iterator it = m_globalSlots.find(memStr->getString());
+        if (it == m_globalSlots.end() || !m_globals[it->second].defined)
         {
             throw RuntimeException(std::string("Attempted to get variable '" + memStr->getString() + "', which doesn't exist"));
         }
-        pushToStack(m_globals[memStr->getString()]);
+        pushToStack(m_globals[it->second].value);
+    }
+}
+
+inline void GobLang::Machine::_setGlobalSlot(size_t slot)
+{
+    GlobalVariable &global = m_globals[slot];
+    global.value = _getFromTopAndPop();
+    global.defined = true;
+}
+
+inline void GobLang::Machine::_getGlobalSlot(size_t slot)
+{
+    if (!m_globals[slot].defined)
+    {
+        throw RuntimeException(std::string("Attempted to get variable '" + m_globalNames[slot] + "', which doesn't exist"));
+    }
+    pushToStack(m_globals[slot].value);
+}
+
+void GobLang::Machine::_decodeOperations()
+{
+    // code is verified first, as decoding already uses ids of the constants
+    std::optional<VerifiedCode> verified;
+    if (m_uncheckedExecution)
+    {
+        verified = Verifier(m_operations, m_functions, m_constStrings.size(), m_structures.size(), m_fieldSlotCaches.size()).verify();
+    }
+    std::vector<Instruction> decoded;
+    std::vector<size_t> addresses;
+    for (size_t address = 0; address < m_operations.size();)
+    {
+        EncodedOperation operation = decodeOperation(m_operations, address);
+        Instruction instruction{.op = operation.op, .arg = operation.arg, .arg2 = operation.arg2};
+        switch (instruction.op)
+        {
+        case Operation::GetGlobalSlot:
+        case Operation::SetGlobalSlot:
+            if (instruction.arg >= m_constStrings.size())
+            {
+                throw RuntimeException("Operation at " + std::to_string(address) + " uses name " + std::to_string(instruction.arg) + " but no constant uses that id");
+            }
+            instruction.arg = getGlobalSlot(m_constStrings[instruction.arg]);
+            break;
+        // jump offsets are converted into addresses for now and into instruction indices once the final instructions are known
+        case Operation::Jump:
+        case Operation::JumpIf:
+        case Operation::JumpIfNot:
+            instruction.arg += address;
+            break;
+        case Operation::JumpBack:
+            if (instruction.arg > address)
+            {
+                throw RuntimeException("Jump back offset is larger than the PC");
+            }
+            instruction.arg = address - instruction.arg;
+            break;
+        default:
+            break;
+        }
+        addresses.push_back(address);
+        decoded.push_back(instruction);
+        address += 1 + operation.argSize;
+    }
+
+    // superinstructions can only start at these addresses, because jumping into the middle of a superinstruction is impossible
+    std::vector<bool> jumpTargets(m_operations.size() + 1, false);
+    for (Instruction &instruction : decoded)
+    {
+        if (uint32_t *target = _getJumpTarget(instruction); target != nullptr && *target < jumpTargets.size())
+        {
+            jumpTargets[*target] = true;
+        }
+    }
+    for (Function const &func : m_functions)
+    {
+        if (func.start < jumpTargets.size())
+        {
+            jumpTargets[func.start] = true;
+        }
+    }
+
+    m_instructions.clear();
+    m_instructionAddresses.clear();
+    // addresses that are not at the start of an instruction stay invalid
+    m_addressInstructions.assign(m_operations.size() + 1, SIZE_MAX);
+    for (size_t i = 0; i < decoded.size();)
+    {
+        Instruction instruction = decoded[i];
+        size_t length = _fuseInstructions(decoded, addresses, jumpTargets, i, instruction);
+        // superinstruction uses address of the first operation it replaced, so errors still point to the right place in the code
+        m_addressInstructions[addresses[i]] = m_instructions.size();
+        m_instructionAddresses.push_back(addresses[i]);
+        m_instructions.push_back(instruction);
+        i += length;
+    }
+    m_addressInstructions[m_operations.size()] = m_instructions.size();
+
+    for (size_t i = 0; i < m_instructions.size(); i++)
+    {
+        if (uint32_t *target = _getJumpTarget(m_instructions[i]); target != nullptr)
+        {
+            if (*target >= m_addressInstructions.size() || m_addressInstructions[*target] == SIZE_MAX)
+            {
+                throw RuntimeException("Jump at " + std::to_string(m_instructionAddresses[i]) + " does not lead to the start of an operation");
+            }
+            *target = m_addressInstructions[*target];
+        }
+    }
+    // jumps that lead to another unconditional jump can go to its destination straight away
+    for (Instruction &instruction : m_instructions)
+    {
+        uint32_t *target = _getJumpTarget(instruction);
+        for (size_t jumps = 0; target != nullptr && jumps < m_instructions.size(); jumps++)
+        {
+            if (*target >= m_instructions.size() || m_instructions[*target].op != Operation::Jump || m_instructions[*target].arg == *target)
+            {
+                break;
+            }
+            *target = m_instructions[*target].arg;
+        }
+    }
+    m_verifiedStates.clear();
+    if (verified.has_value())
+    {
+        // superinstructions start where the operations they replace start, so they get the state of the first operation
+        for (size_t address : m_instructionAddresses)
+        {
+            m_verifiedStates.push_back(verified->states[address]);
+        }
+        m_verifiedStates.push_back(verified->states[m_operations.size()]);
+    }
+    m_instructionsOutdated = false;
+    _resetJit();
+}
+
+uint32_t *GobLang::Machine::_getJumpTarget(Instruction &instruction)
+{
+    switch (instruction.op)
+    {
+    case Operation::Jump:
+    case Operation::JumpBack:
+    case Operation::JumpIf:
+    case Operation::JumpIfNot:
+        return &instruction.arg;
+    case Operation::JumpIfNotLessLocalConst:
+    case Operation::JumpIfNotLessOrEqLocalConst:
+    case Operation::JumpIfNotLessLocals:
+        return &instruction.arg3;
+    default:
+        return nullptr;
+    }
+}
+
+size_t GobLang::Machine::_fuseInstructions(
+    std::vector<Instruction> const &code,
+    std::vector<size_t> const &addresses,
+    std::vector<bool> const &jumpTargets,
+    size_t start,
+    Instruction &result)
+{
+    // sequence matches if it has the same operations and nothing jumps into the middle of it
+    auto matches = [&](std::initializer_list<Operation> ops)
+    {
+        if (start + ops.size() > code.size())
+        {
+            return false;
+        }
+        size_t i = start;
+        for (Operation op : ops)
+        {
+            if (code[i].op != op || (i != start && jumpTargets[addresses[i]]))
+            {
+                return false;
+            }
+            i++;
+        }
+        return true;
+    };
+    // sequences were picked based on how often operation pairs are executed in the examples,
+    // longer sequences are checked first because they start with the same operations as the shorter ones
+    Instruction const &first = code[start];
+    if (matches({Operation::GetLocal, Operation::PushConstInt, Operation::Add, Operation::SetLocal}) && code[start + 3].arg == first.arg)
+    {
+        result = Instruction{.op = Operation::IncLocalByConst, .arg = code[start + 1].arg, .arg2 = first.arg};
+        return 4;
+    }
+    if (matches({Operation::GetLocal, Operation::PushConstInt, Operation::Less, Operation::JumpIfNot}))
+    {
+        result = Instruction{.op = Operation::JumpIfNotLessLocalConst, .arg = code[start + 1].arg, .arg2 = first.arg, .arg3 = code[start + 3].arg};
+        return 4;
+    }
+    if (matches({Operation::GetLocal, Operation::PushConstInt, Operation::LessOrEq, Operation::JumpIfNot}))
+    {
+        result = Instruction{.op = Operation::JumpIfNotLessOrEqLocalConst, .arg = code[start + 1].arg, .arg2 = first.arg, .arg3 = code[start + 3].arg};
+        return 4;
+    }
+    if (matches({Operation::GetLocal, Operation::GetLocal, Operation::Less, Operation::JumpIfNot}))
+    {
+        result = Instruction{.op = Operation::JumpIfNotLessLocals, .arg = first.arg, .arg2 = code[start + 1].arg, .arg3 = code[start + 3].arg};
+        return 4;
     }
+    if (matches({Operation::GetLocal, Operation::PushConstInt, Operation::Add}))
+    {
+        result = Instruction{.op = Operation::PushLocalAddConst, .arg = code[start + 1].arg, .arg2 = first.arg};
+        return 3;
+    }
+    if (matches({Operation::GetLocal, Operation::PushConstInt, Operation::Sub}))
+    {
+        result = Instruction{.op = Operation::PushLocalSubConst, .arg = code[start + 1].arg, .arg2 = first.arg};
+        return 3;
+    }
+    if (matches({Operation::GetLocal, Operation::GetFieldSlot}))
+    {
+        result = Instruction{.op = Operation::GetLocalField, .arg = code[start + 1].arg, .arg2 = code[start + 1].arg2, .arg3 = first.arg};
+        return 2;
+    }
+    if (matches({Operation::GetLocal, Operation::SetFieldSlot}))
+    {
+        result = Instruction{.op = Operation::SetLocalField, .arg = code[start + 1].arg, .arg2 = code[start + 1].arg2, .arg3 = first.arg};
+        return 2;
+    }
+    return 1;
 }
 
 inline void GobLang::Machine::_bitAnd()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index() || ((Type)a.index() != Type::Int && (Type)a.index() != Type::UnsignedInt))
+    if (a.getType() != b.getType() || (a.getType() != Type::Int && a.getType() != Type::UnsignedInt))
     {
         throw RuntimeException(std::string("Attempted to bit AND values of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()) +
+                               typeToString(b.getType()) +
                                ". Only int or unsigned int is allowed");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) & std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() & a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) & std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() & a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
@@ -730,21 +1650,21 @@ inline void GobLang::Machine::_bitOr()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index() || ((Type)a.index() != Type::Int && (Type)a.index() != Type::UnsignedInt))
+    if (a.getType() != b.getType() || (a.getType() != Type::Int && a.getType() != Type::UnsignedInt))
     {
         throw RuntimeException(std::string("Attempted to bit OR values of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()) +
+                               typeToString(b.getType()) +
                                ". Only int or unsigned int is allowed");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) | std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() | a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) | std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() | a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
@@ -755,21 +1675,21 @@ inline void GobLang::Machine::_bitXor()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index() || ((Type)a.index() != Type::Int && (Type)a.index() != Type::UnsignedInt))
+    if (a.getType() != b.getType() || (a.getType() != Type::Int && a.getType() != Type::UnsignedInt))
     {
         throw RuntimeException(std::string("Attempted to bit XOR values of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()) +
+                               typeToString(b.getType()) +
                                ". Only int or unsigned int is allowed");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) ^ std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() ^ a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) ^ std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() ^ a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
@@ -779,16 +1699,16 @@ inline void GobLang::Machine::_bitXor()
 inline void GobLang::Machine::_bitNot()
 {
     Value a = _getFromTopAndPop();
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(~std::get<int32_t>(a)));
+        pushToStack(Value(~a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(~std::get<uint32_t>(a)));
+        pushToStack(Value(~a.as<uint32_t>()));
         break;
     default:
-        throw RuntimeException(std::string("Attempted to bit NOT value of  ") + typeToString((Type)a.index()) + ". Only int or unsigned int is allowed");
+        throw RuntimeException(std::string("Attempted to bit NOT value of  ") + typeToString(a.getType()) + ". Only int or unsigned int is allowed");
     }
 }
 
@@ -796,21 +1716,21 @@ inline void GobLang::Machine::_shiftLeft()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index() || ((Type)a.index() != Type::Int && (Type)a.index() != Type::UnsignedInt))
+    if (a.getType() != b.getType() || (a.getType() != Type::Int && a.getType() != Type::UnsignedInt))
     {
         throw RuntimeException(std::string("Attempted to bit  bit shift leftvalues of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()) +
+                               typeToString(b.getType()) +
                                ". Only int or unsigned int is allowed");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) << std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() << a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) << std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() << a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
@@ -821,40 +1741,38 @@ inline void GobLang::Machine::_shiftRight()
 {
     Value a = _getFromTopAndPop();
     Value b = _getFromTopAndPop();
-    if (a.index() != b.index() || ((Type)a.index() != Type::Int && (Type)a.index() != Type::UnsignedInt))
+    if (a.getType() != b.getType() || (a.getType() != Type::Int && a.getType() != Type::UnsignedInt))
     {
         throw RuntimeException(std::string("Attempted to bit  bit right leftvalues of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()) +
+                               typeToString(b.getType()) +
                                ". Only int or unsigned int is allowed");
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Int:
-        pushToStack(Value(std::get<int32_t>(b) >> std::get<int32_t>(a)));
+        pushToStack(Value(b.as<int32_t>() >> a.as<int32_t>()));
         break;
     case Type::UnsignedInt:
-        pushToStack(Value(std::get<uint32_t>(b) >> std::get<uint32_t>(a)));
+        pushToStack(Value(b.as<uint32_t>() >> a.as<uint32_t>()));
         break;
     default:
         throw RuntimeException("Modulo can only be used on int or unsigned int");
     }
 }
 
-void GobLang::Machine::_setLocal()
+template <bool Checked>
+void GobLang::Machine::_setLocal(size_t id)
 {
-    Value val = _getFromTopAndPop();
-    m_programCounter++;
-    uint8_t id = m_operations[m_programCounter];
+    Value val = _getFromTopAndPop<Checked>();
     setLocalVariableValue(id, val);
 }
 
-void GobLang::Machine::_getLocal()
+template <bool Checked>
+void GobLang::Machine::_getLocal(size_t id)
 {
-    m_programCounter++;
-    uint8_t id = m_operations[m_programCounter];
-    if (Value *val = getLocalVariableValue(id); val != nullptr)
+    if (Value *val = _getLocalValue<Checked>(id); val != nullptr)
     {
         pushToStack(*val);
     }
@@ -867,13 +1785,13 @@ void GobLang::Machine::_getLocal()
 void GobLang::Machine::_call()
 {
     Value func = _getFromTopAndPop();
-    switch ((Type)func.index())
+    switch (func.getType())
     {
     case Type::NativeFunction:
-        std::get<FunctionValue>(func)(this);
+        _callNative(func.as<FunctionValue>());
         break;
     case Type::MemoryObj:
-        if (FunctionRef *f = dynamic_cast<FunctionRef *>(std::get<MemoryNode *>(func)); f != nullptr)
+        if (FunctionRef *f = node_cast<FunctionRef>(func.as<MemoryNode *>()); f != nullptr)
         {
             if (f->isLocal())
             {
@@ -885,86 +1803,65 @@ void GobLang::Machine::_call()
                 if (f->hasOwner())
                 {
                     pushToStack(Value(f->getOwner()));
-                    (*f->getFunction())(this);
-                }
-                else
-                {
-                    (*f->getFunction())(this);
                 }
+                _callNative(*f->getFunction());
             }
         }
         else
         {
-            throw RuntimeException(std::string("Attempted to call a non-function object of type: ") + typeToString((Type)func.index()));
+            throw RuntimeException(std::string("Attempted to call a non-function object of type: ") + typeToString(func.getType()));
         }
         break;
     default:
-        throw RuntimeException(std::string("Attempted to call a non-function object of type: ") + typeToString((Type)func.index()));
+        throw RuntimeException(std::string("Attempted to call a non-function object of type: ") + typeToString(func.getType()));
+    }
+}
+
+void GobLang::Machine::_getLocalFunc(size_t funcId)
+{
+    if (funcId >= m_localFunctionRefs.size())
+    {
+        throw RuntimeException(std::string("Attempted to get function with id ") + std::to_string(funcId) + " but no function uses that id");
     }
+    pushObjectToStack(m_localFunctionRefs[funcId]);
 }
 
-void GobLang::Machine::_getLocalFunc()
+inline void GobLang::Machine::_callLocal(size_t funcId, size_t argCount)
 {
-    m_programCounter++;
-    size_t funcId = (size_t)m_operations[m_programCounter];
-    FunctionRef *f = new FunctionRef(funcId);
-    addObject(f);
-    pushObjectToStack(f);
+    if (funcId < m_functions.size() && m_functions[funcId].arguments.size() != argCount)
+    {
+        throw RuntimeException(std::string("Function expects ") +
+                               std::to_string(m_functions[funcId].arguments.size()) +
+                               " arguments, but " +
+                               std::to_string(argCount) +
+                               " were passed");
+    }
+    callLocalFunction(funcId);
 }
 
 void GobLang::Machine::_return()
 {
-    size_t pos = m_callStack.back();
-    m_callStack.pop_back();
-    m_programCounter = pos;
+    size_t pos = m_frame.returnAddress;
     removeFunctionFrame();
+    m_programCounter = pos;
 }
 
 void GobLang::Machine::_returnWithValue()
 {
-    size_t pos = m_callStack.back();
-    m_callStack.pop_back();
-    m_programCounter = pos;
+    size_t pos = m_frame.returnAddress;
     // we have to remove it manually to avoid it getting grabbed by the garbage collector
     Value returnVal = _getFromTopAndPop();
     removeFunctionFrame();
+    m_programCounter = pos;
     pushToStack(returnVal);
 }
 
-void GobLang::Machine::_pushConstInt()
-{
-    int32_t val = _parseOperationConstant<int32_t>(m_programCounter + 1);
-    m_programCounter += sizeof(int32_t);
-    pushToStack(Value(val));
-}
-
-inline void GobLang::Machine::_pushConstUnsignedInt()
-{
-    uint32_t val = _parseOperationConstant<uint32_t>(m_programCounter + 1);
-    m_programCounter += sizeof(uint32_t);
-    pushToStack(Value(val));
-}
-
-void GobLang::Machine::_pushConstFloat()
-{
-    float val = _parseOperationConstant<float>(m_programCounter + 1);
-    m_programCounter += sizeof(float);
-    pushToStack(Value(val));
-}
-
-void GobLang::Machine::_pushConstChar()
-{
-    pushToStack(Value((char)m_operations[m_programCounter + 1]));
-    m_programCounter++;
-}
-
-void GobLang::Machine::_pushConstString()
+void GobLang::Machine::_pushConstString(size_t id)
 {
-    std::string &str = m_constStrings[(size_t)m_operations[m_programCounter + 1]];
+    std::string &str = m_constStrings[id];
     // we always create a new string object because otherwise each variable will share same pointer to constant string which can be altered
     StringNode *node = createString(str, true);
 
-    m_programCounter++;
     pushToStack(Value(node));
 }
 
@@ -977,95 +1874,188 @@ void GobLang::Machine::_getArray()
 {
     Value array = _getFromTopAndPop();
     Value index = _getFromTopAndPop();
-    if (!std::holds_alternative<MemoryNode *>(array))
+    if (!array.is<MemoryNode *>())
+    {
+        throw RuntimeException(std::string("Attempted to get array value, but array has instead type: ") + typeToString(array.getType()));
+    }
+    if (!index.is<int32_t>())
+    {
+        throw RuntimeException(std::string("Attempted to get array value, but index has instead type: ") + typeToString(array.getType()));
+    }
+    if (ArrayNode *arrNode = node_cast<ArrayNode>(array.as<MemoryNode *>()); arrNode != nullptr)
+    {
+        pushToStack(arrNode->getItem(index.as<int32_t>()));
+    }
+    else if (StringNode *strNode = node_cast<StringNode>(array.as<MemoryNode *>()); strNode != nullptr)
     {
-        throw RuntimeException(std::string("Attempted to get array value, but array has instead type: ") + typeToString((Type)array.index()));
+        pushToStack(Value(strNode->getCharAt(index.as<int32_t>())));
     }
-    if (!std::holds_alternative<int32_t>(index))
+}
+
+void GobLang::Machine::_setArray()
+{
+    Value array = _getFromTopAndPop();
+    Value index = _getFromTopAndPop();
+    Value value = _getFromTopAndPop();
+
+    if (!array.is<MemoryNode *>())
+    {
+        throw RuntimeException(std::string("Attempted to set array value, but array has instead type: ") + typeToString(array.getType()));
+    }
+    if (!index.is<int32_t>())
+    {
+        throw RuntimeException(std::string("Attempted to set array value, but index has instead type: ") + typeToString(array.getType()));
+    }
+    MemoryNode *m = array.as<MemoryNode *>();
+    if (ArrayNode *arrNode = node_cast<ArrayNode>(m); arrNode != nullptr)
+    {
+        arrNode->setItem(index.as<int32_t>(), value);
+    }
+    else if (StringNode *strNode = node_cast<StringNode>(m); strNode != nullptr && value.getType() == Type::Char)
+    {
+        strNode->setCharAt(value.as<char>(), index.as<int32_t>());
+    }
+}
+
+inline void GobLang::Machine::_getField()
+{
+    Value object = _getFromTopAndPop();
+    Value field = _getFromTopAndPop();
+    if (!object.is<MemoryNode *>())
+    {
+        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString(object.getType()));
+    }
+    if (!field.is<MemoryNode *>())
+    {
+        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString(field.getType()));
+    }
+    MemoryNode *memObj = object.as<MemoryNode *>();
+    if (StringNode *strNode = node_cast<StringNode>(field.as<MemoryNode *>()); strNode != nullptr)
+    {
+        Value v = memObj->getField(strNode->getString());
+        if (v.is<MemoryNode *>())
+        {
+            addObject(v.as<MemoryNode *>());
+        }
+        pushToStack(v);
+    }
+    else
+    {
+        throw RuntimeException("Attempted to get field on a but field name is not a string");
+    }
+}
+
+inline void GobLang::Machine::_setField()
+{
+    Value object = _getFromTopAndPop();
+    Value field = _getFromTopAndPop();
+    Value value = _getFromTopAndPop();
+
+    if (!object.is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Attempted to get array value, but index has instead type: ") + typeToString((Type)array.index()));
+        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString(object.getType()));
     }
-    if (ArrayNode *arrNode = dynamic_cast<ArrayNode *>(std::get<MemoryNode *>(array)); arrNode != nullptr)
+    if (!field.is<MemoryNode *>())
     {
-        pushToStack(*arrNode->getItem(std::get<int32_t>(index)));
+        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString(field.getType()));
     }
-    else if (StringNode *strNode = dynamic_cast<StringNode *>(std::get<MemoryNode *>(array)); strNode != nullptr)
+    if (StringNode *strNode = node_cast<StringNode>(field.as<MemoryNode *>()); strNode != nullptr)
     {
-        pushToStack(Value(strNode->getCharAt(std::get<int32_t>(index))));
+        object.as<MemoryNode *>()->setField(strNode->getString(), value);
     }
 }
 
-void GobLang::Machine::_setArray()
+inline void GobLang::Machine::_getFieldSlot(size_t fieldNameId, size_t cacheId)
 {
-    Value array = _getFromTopAndPop();
-    Value index = _getFromTopAndPop();
-    Value value = _getFromTopAndPop();
-
-    if (!std::holds_alternative<MemoryNode *>(array))
-    {
-        throw RuntimeException(std::string("Attempted to set array value, but array has instead type: ") + typeToString((Type)array.index()));
-    }
-    if (!std::holds_alternative<int32_t>(index))
+    Value object = _getFromTopAndPop();
+    if (!object.is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Attempted to set array value, but index has instead type: ") + typeToString((Type)array.index()));
+        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString(object.getType()));
     }
-    MemoryNode *m = std::get<MemoryNode *>(array);
-    if (ArrayNode *arrNode = dynamic_cast<ArrayNode *>(m); arrNode != nullptr)
+    MemoryNode *memObj = object.as<MemoryNode *>();
+    size_t slot = _resolveFieldSlot(memObj, fieldNameId, cacheId);
+    if (slot != NoFieldSlot)
     {
-        arrNode->setItem(std::get<int32_t>(index), value);
+        pushToStack(static_cast<Struct::StructureObjectNode *>(memObj)->getFieldById(slot));
+        return;
     }
-    else if (StringNode *strNode = dynamic_cast<StringNode *>(m); strNode != nullptr && (Type)value.index() == Type::Char)
+    Value v = memObj->getField(m_constStrings[fieldNameId]);
+    if (v.is<MemoryNode *>())
     {
-        strNode->setCharAt(std::get<char>(value), std::get<int32_t>(index));
+        addObject(v.as<MemoryNode *>());
     }
+    pushToStack(v);
 }
 
-inline void GobLang::Machine::_getField()
+inline void GobLang::Machine::_setFieldSlot(size_t fieldNameId, size_t cacheId)
 {
     Value object = _getFromTopAndPop();
-    Value field = _getFromTopAndPop();
-    if (!std::holds_alternative<MemoryNode *>(object))
-    {
-        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString((Type)object.index()));
-    }
-    if (!std::holds_alternative<MemoryNode *>(field))
+    Value value = _getFromTopAndPop();
+    if (!object.is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString((Type)field.index()));
+        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString(object.getType()));
     }
-    MemoryNode *memObj = std::get<MemoryNode *>(object);
-    if (StringNode *strNode = dynamic_cast<StringNode *>(std::get<MemoryNode *>(field)); strNode != nullptr)
+    MemoryNode *memObj = object.as<MemoryNode *>();
+    size_t slot = _resolveFieldSlot(memObj, fieldNameId, cacheId);
+    if (slot != NoFieldSlot)
     {
-        Value v = memObj->getField(strNode->getString());
-        if (std::holds_alternative<MemoryNode *>(v))
-        {
-            addObject(std::get<MemoryNode *>(v));
-        }
-        pushToStack(v);
+        static_cast<Struct::StructureObjectNode *>(memObj)->setFieldById(slot, value);
     }
     else
     {
-        throw RuntimeException("Attempted to get field on a but field name is not a string");
+        memObj->setField(m_constStrings[fieldNameId], value);
     }
 }
 
-inline void GobLang::Machine::_setField()
+inline size_t GobLang::Machine::_resolveFieldSlot(MemoryNode *object, size_t fieldNameId, size_t cacheId)
 {
-    Value object = _getFromTopAndPop();
-    Value field = _getFromTopAndPop();
-    Value value = _getFromTopAndPop();
-
-    if (!std::holds_alternative<MemoryNode *>(object))
+    Struct::StructureObjectNode *structObj = node_cast<Struct::StructureObjectNode>(object);
+    if (structObj == nullptr)
     {
-        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString((Type)object.index()));
+        return NoFieldSlot;
     }
-    if (!std::holds_alternative<MemoryNode *>(field))
+    Struct::Structure const *type = structObj->getType();
+    FieldSlotCache &cache = m_fieldSlotCaches[cacheId];
+    if (cache.type != type)
     {
-        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString((Type)field.index()));
+        std::map<std::string, size_t>::const_iterator it = type->fieldIds.find(m_constStrings[fieldNameId]);
+        if (it == type->fieldIds.end())
+        {
+            throw RuntimeException(std::string("Invalid field name ") + m_constStrings[fieldNameId]);
+        }
+        cache.type = type;
+        cache.slot = it->second;
     }
-    if (StringNode *strNode = dynamic_cast<StringNode *>(std::get<MemoryNode *>(field)); strNode != nullptr)
+    return cache.slot;
+}
+
+inline void GobLang::Machine::_callMethodSlot(size_t methodNameId, size_t cacheId)
+{
+    if (m_stack.size() > _getOperandBase() && m_stack.back().is<MemoryNode *>())
     {
-        std::get<MemoryNode *>(object)->setField(strNode->getString(), value);
+        if (NativeStructureObjectNode *native = node_cast<NativeStructureObjectNode>(m_stack.back().as<MemoryNode *>()); native != nullptr)
+        {
+            NativeStructureInfo const *info = native->getNativeStructure();
+            FieldSlotCache &cache = m_fieldSlotCaches[cacheId];
+            if (cache.nativeType != info)
+            {
+                std::map<std::string, FunctionValue>::const_iterator it = info->methods.find(m_constStrings[methodNameId]);
+                if (it != info->methods.end())
+                {
+                    cache.nativeType = info;
+                    cache.method = it->second;
+                }
+            }
+            if (cache.nativeType == info)
+            {
+                // object stays on the stack as the "self" argument, same as when bound method is called
+                _callNative(cache.method);
+                return;
+            }
+        }
     }
+    _getFieldSlot(methodNameId, cacheId);
+    _call();
 }
 
 inline void GobLang::Machine::_callMethod()
@@ -1073,36 +2063,36 @@ inline void GobLang::Machine::_callMethod()
     Value methodName = _getFromTopAndPop();
     Value object = _getFromTopAndPop();
 
-    if (!std::holds_alternative<MemoryNode *>(object))
+    if (!object.is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString((Type)object.index()));
+        throw RuntimeException(std::string("Attempted to getfield, but object has instead type: ") + typeToString(object.getType()));
     }
-    if (!std::holds_alternative<MemoryNode *>(methodName))
+    if (!methodName.is<MemoryNode *>())
     {
-        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString((Type)methodName.index()));
+        throw RuntimeException(std::string("Attempted to get field, but field name has instead type: ") + typeToString(methodName.getType()));
     }
 
     std::string name;
 
-    if (StringNode *strNode = dynamic_cast<StringNode *>(std::get<MemoryNode *>(methodName)); strNode != nullptr)
+    if (StringNode *strNode = node_cast<StringNode>(methodName.as<MemoryNode *>()); strNode != nullptr)
     {
         name = strNode->getString();
     }
 
-    MemoryNode *objNode = std::get<MemoryNode *>(object);
+    MemoryNode *objNode = object.as<MemoryNode *>();
     // this is to simulate "this" argument
     // or if comparing to python, passing "self" argument
     pushToStack(object);
     Value funcVal = objNode->getField(name);
-    if (!std::holds_alternative<MemoryNode *>(funcVal))
+    if (!funcVal.is<MemoryNode *>())
     {
         throw RuntimeException("Attempted to call non-callable object");
     }
-    if (FunctionRef *func = dynamic_cast<FunctionRef *>(std::get<MemoryNode *>(funcVal)); func != nullptr)
+    if (FunctionRef *func = node_cast<FunctionRef>(funcVal.as<MemoryNode *>()); func != nullptr)
     {
         if (!func->isLocal())
         {
-            (*func->getFunction())(this);
+            _callNative(*func->getFunction());
         }
     }
     else
@@ -1115,13 +2105,13 @@ void GobLang::Machine::_eq()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() == b.index() || (Type)a.index() == Type::Null || (Type)b.index() == Type::Null)
+    if (a.getType() == b.getType() || a.getType() == Type::Null || b.getType() == Type::Null)
     {
         pushToStack(Value(areEqual(a, b)));
     }
     else
     {
-        throw RuntimeException(std::string("Attempted to compare value of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to compare value of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
 }
 
@@ -1129,12 +2119,12 @@ void GobLang::Machine::_neq()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index() && !((Type)a.index() == Type::Null || (Type)b.index() == Type::Null))
+    if (a.getType() != b.getType() && !(a.getType() == Type::Null || b.getType() == Type::Null))
     {
         throw RuntimeException(std::string("Attempted to compare value of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
@@ -1146,16 +2136,16 @@ void GobLang::Machine::_and()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index() && (Type)a.index() != Type::Bool)
+    if (a.getType() != Type::Bool || b.getType() != Type::Bool)
     {
         throw RuntimeException(std::string("Attempted to 'and' values of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
-        pushToStack(Value(std::get<bool>(a) && std::get<bool>(b)));
+        pushToStack(Value(a.as<bool>() && b.as<bool>()));
     }
 }
 
@@ -1163,16 +2153,16 @@ void GobLang::Machine::_or()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index() && (Type)a.index() != Type::Bool)
+    if (a.getType() != Type::Bool || b.getType() != Type::Bool)
     {
         throw RuntimeException(std::string("Attempted to 'or' values of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
-        pushToStack(Value(std::get<bool>(a) || std::get<bool>(b)));
+        pushToStack(Value(a.as<bool>() || b.as<bool>()));
     }
 }
 
@@ -1180,26 +2170,26 @@ void GobLang::Machine::_less()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
         throw RuntimeException(std::string("Attempted to compare value of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
-        switch ((Type)a.index())
+        switch (a.getType())
         {
         case Type::Int:
-            pushToStack(Value(std::get<int32_t>(a) < std::get<int32_t>(b)));
+            pushToStack(Value(a.as<int32_t>() < b.as<int32_t>()));
             break;
         case Type::Float:
-            pushToStack(Value(std::get<float>(a) < std::get<float>(b)));
+            pushToStack(Value(a.as<float>() < b.as<float>()));
             break;
         default:
             throw RuntimeException(std::string("Attempted to compare value of type ") +
-                                   typeToString((Type)a.index()) +
+                                   typeToString(a.getType()) +
                                    ". Only numeric types can be compared using >,<, <=, >=");
         }
     }
@@ -1209,26 +2199,26 @@ void GobLang::Machine::_more()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
         throw RuntimeException(std::string("Attempted to compare value of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
-        switch ((Type)a.index())
+        switch (a.getType())
         {
         case Type::Int:
-            pushToStack(Value(std::get<int32_t>(a) > std::get<int32_t>(b)));
+            pushToStack(Value(a.as<int32_t>() > b.as<int32_t>()));
             break;
         case Type::Float:
-            pushToStack(Value(std::get<float>(a) > std::get<float>(b)));
+            pushToStack(Value(a.as<float>() > b.as<float>()));
             break;
         default:
             throw RuntimeException(std::string("Attempted to compare value of type ") +
-                                   typeToString((Type)a.index()) +
+                                   typeToString(a.getType()) +
                                    ". Only numeric types can be compared using >,<, <=, >=");
         }
     }
@@ -1238,23 +2228,23 @@ void GobLang::Machine::_lessOrEq()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
-        throw RuntimeException(std::string("Attempted to compare value of ") + typeToString((Type)a.index()) + " and " + typeToString((Type)b.index()));
+        throw RuntimeException(std::string("Attempted to compare value of ") + typeToString(a.getType()) + " and " + typeToString(b.getType()));
     }
     else
     {
-        switch ((Type)a.index())
+        switch (a.getType())
         {
         case Type::Int:
-            pushToStack(Value(std::get<int32_t>(a) <= std::get<int32_t>(b)));
+            pushToStack(Value(a.as<int32_t>() <= b.as<int32_t>()));
             break;
         case Type::Float:
-            pushToStack(Value(std::get<float>(a) <= std::get<float>(b)));
+            pushToStack(Value(a.as<float>() <= b.as<float>()));
             break;
         default:
             throw RuntimeException(std::string("Attempted to compare value of type ") +
-                                   typeToString((Type)a.index()) +
+                                   typeToString(a.getType()) +
                                    ". Only numeric types can be compared using >,<, <=, >=");
         }
     }
@@ -1264,26 +2254,26 @@ void GobLang::Machine::_moreOrEq()
 {
     Value b = _getFromTopAndPop();
     Value a = _getFromTopAndPop();
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
         throw RuntimeException(std::string("Attempted to compare value of ") +
-                               typeToString((Type)a.index()) +
+                               typeToString(a.getType()) +
                                " and " +
-                               typeToString((Type)b.index()));
+                               typeToString(b.getType()));
     }
     else
     {
-        switch ((Type)a.index())
+        switch (a.getType())
         {
         case Type::Int:
-            pushToStack(Value(std::get<int32_t>(a) >= std::get<int32_t>(b)));
+            pushToStack(Value(a.as<int32_t>() >= b.as<int32_t>()));
             break;
         case Type::Float:
-            pushToStack(Value(std::get<float>(a) >= std::get<float>(b)));
+            pushToStack(Value(a.as<float>() >= b.as<float>()));
             break;
         default:
             throw RuntimeException(std::string("Attempted to compare value of type ") +
-                                   typeToString((Type)a.index()) +
+                                   typeToString(a.getType()) +
                                    ". Only numeric types can be compared using >,<, <=, >=");
         }
     }
@@ -1292,13 +2282,13 @@ void GobLang::Machine::_moreOrEq()
 void GobLang::Machine::_negate()
 {
     Value val = _getFromTopAndPop();
-    switch ((Type)val.index())
+    switch (val.getType())
     {
     case Type::Int:
-        pushToStack(Value(-std::get<int32_t>(val)));
+        pushToStack(Value(-val.as<int32_t>()));
         break;
     case Type::Float:
-        pushToStack(Value(-std::get<float>(val)));
+        pushToStack(Value(-val.as<float>()));
         break;
     default:
         throw RuntimeException("Attempted to apply negate operation on a non numeric value");
@@ -1308,25 +2298,44 @@ void GobLang::Machine::_negate()
 void GobLang::Machine::_not()
 {
     Value val = _getFromTopAndPop();
-    if ((Type)val.index() != Type::Bool)
+    if (val.getType() != Type::Bool)
     {
         throw RuntimeException("Attempted to negate non boolean value");
     }
-    pushToStack(Value(!std::get<bool>(val)));
+    pushToStack(Value(!val.as<bool>()));
 }
 
-void GobLang::Machine::_shrink()
+void GobLang::Machine::_shrink(size_t amount)
 {
-    m_programCounter++;
-    size_t amount = (size_t)m_operations[m_programCounter];
     shrinkLocalVariableStackBy(amount);
 }
 
-void GobLang::Machine::_createArray()
+void GobLang::Machine::_discard()
+{
+    m_stack.resize(_getOperandBase());
+}
+
+void GobLang::Machine::_createArray(int32_t arraySize)
 {
-    m_programCounter++;
-    int32_t arraySize = m_operations[m_programCounter];
-    ArrayNode *array = createArrayOfSize(arraySize);
+    // literals that only contain values of the same primitive type create packed arrays
+    ArrayElementType type = ArrayElementType::Generic;
+    if (m_stack.size() < _getOperandBase() + (size_t)arraySize)
+    {
+        throw RuntimeException("Can not pop from stack because stack is empty");
+    }
+    if (arraySize > 0)
+    {
+        size_t first = m_stack.size() - arraySize;
+        type = ArrayNode::getElementTypeOf(m_stack[first]);
+        for (size_t i = first + 1; i < m_stack.size() && type != ArrayElementType::Generic; i++)
+        {
+            if (ArrayNode::getElementTypeOf(m_stack[i]) != type)
+            {
+                type = ArrayElementType::Generic;
+            }
+        }
+    }
+    ArrayNode *array = createArrayOfSize(arraySize, type);
     for (int32_t i = arraySize - 1; i >= 0; i--)
     {
         array->setItem(i, _getFromTopAndPop());
@@ -1334,12 +2343,690 @@ void GobLang::Machine::_createArray()
     pushToStack(Value(array));
 }
 
-inline void GobLang::Machine::_new()
+inline void GobLang::Machine::_new(size_t structId)
 {
-    m_programCounter++;
-    size_t structId = m_operations[m_programCounter];
-
-    MemoryNode *obj = new MemoryNode(m_structures[structId].get());
-    addObject(obj);
+    Structure const *type = m_structures[structId].get();
+    StructureObjectNode *obj = allocateWithExtraSize<StructureObjectNode>(StructureObjectNode::getFieldStorageSize(type), type);
     pushToStack(Value(obj));
 }
+
+GobLang::JitStats GobLang::Machine::getJitStats() const
+{
+    JitStats stats;
+    for (JitFunction const &func : m_jitFunctions)
+    {
+        if (func.code != nullptr)
+        {
+            stats.compiledFunctions++;
+            stats.codeSize += func.code->getSize();
+        }
+        else if (func.failed)
+        {
+            stats.failedFunctions++;
+        }
+    }
+    for (LoopTrace const &trace : m_loopTraces)
+    {
+        if (trace.code != nullptr)
+        {
+            stats.compiledTraces++;
+            stats.registerLocals += trace.registerLocals.size();
+            stats.codeSize += trace.code->getSize();
+        }
+        else if (trace.failed)
+        {
+            stats.failedTraces++;
+        }
+    }
+    stats.bailouts = m_jitBailouts;
+    return stats;
+}
+
+void GobLang::Machine::setUncheckedExecutionEnabled(bool enabled)
+{
+    m_uncheckedExecution = enabled;
+    if (!enabled)
+    {
+        m_verifiedStates.clear();
+        return;
+    }
+    try
+    {
+        _decodeOperations();
+    }
+    catch (...)
+    {
+        m_uncheckedExecution = false;
+        throw;
+    }
+}
+
+void GobLang::Machine::setJitBackend(Jit::Backend backend)
+{
+    m_jitBackend = Jit::areStencilsSupported() ? backend : Jit::Backend::Assembler;
+    _resetJit();
+}
+
+void GobLang::Machine::_resetJit()
+{
+    m_jitFunctions.clear();
+    m_jitFunctions.resize(m_functions.size());
+    m_jitEntries.clear();
+    m_loopTraces.clear();
+    m_loopTraces.resize(m_instructions.size());
+    for (size_t i = 0; i < m_functions.size(); i++)
+    {
+        if (m_functions[i].start < m_addressInstructions.size())
+        {
+            m_jitEntries[m_addressInstructions[m_functions[i].start]] = i;
+        }
+    }
+}
+
+GobLang::Machine::JitExit GobLang::Machine::_enterCompiledFunction()
+{
+    // frame of the function is already created and the counter points to the instruction before the start of the function
+    std::unordered_map<size_t, size_t>::const_iterator it = m_jitEntries.find(m_programCounter + 1);
+    if (it == m_jitEntries.end())
+    {
+        return JitExit::NotCompiled;
+    }
+    return _enterCompiledFunction(it->second);
+}
+
+GobLang::Machine::JitExit GobLang::Machine::_enterCompiledFunction(size_t funcId)
+{
+    if (funcId >= m_jitFunctions.size())
+    {
+        return JitExit::NotCompiled;
+    }
+    JitFunction &func = m_jitFunctions[funcId];
+    if (func.code == nullptr)
+    {
+        if (func.failed || ++func.callCount < m_jitThreshold || !_compileFunction(funcId))
+        {
+            return JitExit::NotCompiled;
+        }
+    }
+    // calls between compiled functions use the native stack, so deep recursion continues in the interpreter
+    if (m_jitDepth >= MAX_JIT_NATIVE_DEPTH)
+    {
+        return JitExit::NotCompiled;
+    }
+    m_jitDepth++;
+    func.code->run(this);
+    m_jitDepth--;
+    return m_jitExit;
+}
+
+bool GobLang::Machine::_compileFunction(size_t funcId)
+{
+    JitFunction &func = m_jitFunctions[funcId];
+    size_t entry = m_addressInstructions[m_functions[funcId].start];
+    // compile every instruction that can be reached from the start of the function without returning
+    std::vector<bool> reachable(m_instructions.size(), false);
+    std::vector<size_t> pending = {entry};
+    while (!pending.empty())
+    {
+        size_t i = pending.back();
+        pending.pop_back();
+        if (i >= m_instructions.size() || reachable[i])
+        {
+            continue;
+        }
+        reachable[i] = true;
+        Instruction &instruction = m_instructions[i];
+        if (uint32_t *target = _getJumpTarget(instruction); target != nullptr)
+        {
+            pending.push_back(*target);
+        }
+        switch (instruction.op)
+        {
+        case Operation::Jump:
+        case Operation::JumpBack:
+        case Operation::Return:
+        case Operation::ReturnValue:
+        case Operation::End:
+            break;
+        default:
+            pending.push_back(i + 1);
+            break;
+        }
+    }
+    std::vector<Jit::JitInstruction> instructions;
+    for (size_t i = 0; i < m_instructions.size(); i++)
+    {
+        if (reachable[i])
+        {
+            instructions.push_back(_getJitInstruction(i));
+        }
+    }
+    func.code = _compileJitCode(instructions, entry);
+    func.failed = func.code == nullptr;
+    return !func.failed;
+}
+
+GobLang::Jit::JitInstruction GobLang::Machine::_getJitInstruction(size_t i)
+{
+    Instruction &instruction = m_instructions[i];
+    Jit::JitInstruction compiled{
+        .index = i,
+        .op = instruction.op,
+        .helper = _getJitHelper(instruction.op),
+        .arg = instruction.arg,
+        .arg2 = instruction.arg2,
+        .arg3 = instruction.arg3};
+    if (uint32_t *target = _getJumpTarget(instruction); target != nullptr)
+    {
+        compiled.target = *target;
+    }
+    if (compiled.helper == nullptr && instruction.op != Operation::Jump)
+    {
+        // operations that can't be compiled are left to the interpreter
+        compiled.helper = _jitBailout;
+        compiled.target.reset();
+    }
+    return compiled;
+}
+
+std::unique_ptr<GobLang::Jit::CompiledCode> GobLang::Machine::_compileJitCode(
+    std::vector<Jit::JitInstruction> const &instructions,
+    size_t entry,
+    std::vector<uint32_t> const &registerLocals) const
+{
+    if (m_jitBackend == Jit::Backend::Stencils)
+    {
+        return Jit::CompiledCode::compileWithStencils(instructions, entry, _jitBailout, _getJitLayout());
+    }
+    return Jit::CompiledCode::compile(instructions, entry, _jitBailout, _getJitLayout(), registerLocals);
+}
+
+GobLang::Machine::JitExit GobLang::Machine::_enterLoopTrace(size_t jumpBack)
+{
+    size_t start = m_programCounter;
+    if (start >= m_loopTraces.size())
+    {
+        return JitExit::NotCompiled;
+    }
+    // the iteration that just ended left the trace of this loop, which means that it took a path that wasn't recorded
+    bool sideExit = m_lastTraceExit == start;
+    m_lastTraceExit = SIZE_MAX;
+    if (m_loopTraces[start].failed)
+    {
+        return JitExit::NotCompiled;
+    }
+    bool record = m_loopTraces[start].code == nullptr
+                      ? ++m_loopTraces[start].iterations >= m_jitLoopThreshold
+                      : sideExit && ++m_loopTraces[start].sideExits >= m_jitLoopThreshold;
+    if (record && m_loopTraces[start].recordings < MAX_JIT_TRACE_RECORDINGS)
+    {
+        std::set<uint32_t> nonIntegerLocals;
+        std::optional<std::vector<size_t>> path = _recordLoopTrace(start, jumpBack, nonIntegerLocals);
+        LoopTrace &trace = m_loopTraces[start];
+        // recording can fail because of the iteration that was picked, for example if it was the last one,
+        // so the loop is recorded again on the next iteration a few more times
+        trace.recordings++;
+        trace.sideExits = 0;
+        if (path.has_value())
+        {
+            std::vector<size_t> merged;
+            std::set_union(trace.path.begin(), trace.path.end(), path->begin(), path->end(), std::back_inserter(merged));
+            trace.nonIntegerLocals.insert(nonIntegerLocals.begin(), nonIntegerLocals.end());
+            std::vector<size_t> previousPath = std::move(trace.path);
+            trace.path = std::move(merged);
+            std::vector<uint32_t> registerLocals = _getRegisterLocals(trace);
+            if (trace.code == nullptr || trace.path != previousPath || registerLocals != trace.registerLocals)
+            {
+                std::vector<Jit::JitInstruction> instructions;
+                for (size_t i : trace.path)
+                {
+                    instructions.push_back(_getJitInstruction(i));
+                }
+                trace.registerLocals = std::move(registerLocals);
+                trace.code = _compileJitCode(instructions, start, trace.registerLocals);
+            }
+        }
+        trace.failed = trace.code == nullptr && trace.recordings >= MAX_JIT_TRACE_RECORDINGS;
+        // recording executed an iteration of the loop, which doesn't have to end at the start of the loop
+        return JitExit::Bailout;
+    }
+    if (m_loopTraces[start].code == nullptr)
+    {
+        return JitExit::NotCompiled;
+    }
+    m_loopTraces[start].code->run(this);
+    if (m_jitExit == JitExit::Bailout)
+    {
+        m_lastTraceExit = start;
+    }
+    return m_jitExit;
+}
+
+std::optional<std::vector<size_t>> GobLang::Machine::_recordLoopTrace(size_t start, size_t jumpBack, std::set<uint32_t> &nonIntegerLocals)
+{
+    // types of the local variables are checked before and after every instruction of the loop that uses them,
+    // so variables that store only integers can be kept in registers by the compiled code
+    auto recordLocalTypes = [this, &nonIntegerLocals](std::vector<uint32_t> const &locals)
+    {
+        for (uint32_t id : locals)
+        {
+            if (Value const *value = getLocalVariableValue(id); value == nullptr || !value->is<int32_t>())
+            {
+                nonIntegerLocals.insert(id);
+            }
+        }
+    };
+    // a single iteration that doesn't leave the loop only moves forward until it jumps back, so instructions of the trace are sorted
+    // and branches that go the other way leave the trace
+    std::vector<size_t> path;
+    size_t depth = m_callFrames.size();
+    for (size_t steps = 0; steps < MAX_JIT_TRACE_LENGTH; steps++)
+    {
+        size_t i = m_programCounter;
+        if (m_callFrames.size() < depth)
+        {
+            return std::nullopt;
+        }
+        bool inLoop = m_callFrames.size() == depth;
+        std::vector<uint32_t> locals;
+        if (inLoop)
+        {
+            if (i < start || i > jumpBack || (!path.empty() && i <= path.back()))
+            {
+                return std::nullopt;
+            }
+            path.push_back(i);
+            locals = Jit::getAccessedLocals(_getJitInstruction(i));
+            recordLocalTypes(locals);
+        }
+        if (_execute<true, true>(1) == 0)
+        {
+            return std::nullopt;
+        }
+        if (inLoop && m_callFrames.size() == depth)
+        {
+            recordLocalTypes(locals);
+        }
+        if (inLoop && i == jumpBack && m_programCounter == start)
+        {
+            return path;
+        }
+    }
+    return std::nullopt;
+}
+
+std::vector<uint32_t> GobLang::Machine::_getRegisterLocals(LoopTrace const &trace)
+{
+    std::map<uint32_t, size_t> uses;
+    std::set<uint32_t> excluded = trace.nonIntegerLocals;
+    for (size_t i : trace.path)
+    {
+        Jit::JitInstruction instruction = _getJitInstruction(i);
+        for (uint32_t id : Jit::getAccessedLocals(instruction))
+        {
+            uses[id]++;
+            if (!Jit::canAccessRegisterLocals(instruction.op) || instruction.helper == _jitBailout)
+            {
+                excluded.insert(id);
+            }
+        }
+    }
+    std::vector<std::pair<size_t, uint32_t>> candidates;
+    for (std::pair<uint32_t const, size_t> const &use : uses)
+    {
+        if (!excluded.contains(use.first))
+        {
+            candidates.push_back({use.second, use.first});
+        }
+    }
+    // most used variables first, and variables with lower ids first if they are used the same amount of times
+    std::sort(candidates.begin(), candidates.end(), [](std::pair<size_t, uint32_t> const &a, std::pair<size_t, uint32_t> const &b)
+              { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+    std::vector<uint32_t> locals;
+    for (size_t i = 0; i < candidates.size() && i < Jit::MaxRegisterLocals; i++)
+    {
+        locals.push_back(candidates[i].second);
+    }
+    return locals;
+}
+
+GobLang::Jit::MachineLayout GobLang::Machine::_getJitLayout() const
+{
+    Jit::MachineLayout layout;
+    Value zero(int32_t(0));
+    Value minusOne(int32_t(-1));
+    Value falseValue(false);
+    Value trueValue(true);
+    std::memcpy(&layout.intBits, &zero, sizeof(layout.intBits));
+    std::memcpy(&layout.falseBits, &falseValue, sizeof(layout.falseBits));
+    std::memcpy(&layout.trueBits, &trueValue, sizeof(layout.trueBits));
+    uint64_t minusOneBits;
+    std::memcpy(&minusOneBits, &minusOne, sizeof(minusOneBits));
+    if ((layout.intBits & UINT32_MAX) != 0 || (minusOneBits ^ layout.intBits) != UINT32_MAX || (layout.falseBits | 1) != layout.trueBits)
+    {
+        return layout;
+    }
+    char const *machine = reinterpret_cast<char const *>(this);
+    // native operations push and pop values by moving the end pointer of the stack
+    int32_t stack = (int32_t)(reinterpret_cast<char const *>(&m_stack) - machine);
+    layout.stackBegin = stack + (int32_t)ValueStack::getBeginOffset();
+    layout.stackEnd = stack + (int32_t)ValueStack::getEndOffset();
+    layout.stackCapacity = stack + (int32_t)ValueStack::getCapacityOffset();
+    layout.frameBase = (int32_t)(reinterpret_cast<char const *>(&m_frame.base) - machine);
+    layout.frameLocalCount = (int32_t)(reinterpret_cast<char const *>(&m_frame.localCount) - machine);
+    layout.frameLocalCapacity = (int32_t)(reinterpret_cast<char const *>(&m_frame.localCapacity) - machine);
+    layout.valid = sizeof(Value) == sizeof(uint64_t) && sizeof(size_t) == sizeof(uint64_t);
+    return layout;
+}
+
+uint32_t GobLang::Machine::_jitBailout(Machine *machine, uint32_t pc, [[maybe_unused]] uint32_t arg, [[maybe_unused]] uint32_t arg2, [[maybe_unused]] uint32_t arg3)
+{
+    machine->m_programCounter = pc;
+    machine->m_jitExit = JitExit::Bailout;
+    machine->m_jitBailouts++;
+    return Jit::Leave;
+}
+
+uint32_t GobLang::Machine::_jitCall(JitExit exit)
+{
+    switch (exit)
+    {
+    case JitExit::Returned:
+        return Jit::Continue;
+    case JitExit::NotCompiled:
+        // function that was called has to be interpreted, so the interpreter also finishes the calling function once it returns
+        m_programCounter++;
+        m_jitExit = JitExit::Bailout;
+        m_jitBailouts++;
+        return Jit::Leave;
+    default:
+        return Jit::Leave;
+    }
+}
+
+// Perform the operation using the same handler as the interpreter
+#define GOB_LANG_JIT_OPERATION(name, handler) \
+    else if constexpr (Op == Operation::name) \
+    {                                         \
+        machine->handler;                     \
+    }
+
+// Perform the operation specialized for the types of the operands, using generic handler if types don't match
+#define GOB_LANG_JIT_QUICKENED_OPERATION(name, handler, type, op)     \
+    else if constexpr (Op == Operation::name)                         \
+    {                                                                 \
+        if (!machine->_tryBinaryOperation<type>(op))                  \
+        {                                                             \
+            machine->handler();                                       \
+        }                                                             \
+    }
+
+template <GobLang::Operation Op>
+uint32_t GobLang::Machine::_jitOperation(Machine *machine, uint32_t pc, uint32_t arg, uint32_t arg2, uint32_t arg3)
+{
+    try
+    {
+        if constexpr (Op == Operation::Call || Op == Operation::CallMethodSlot)
+        {
+            machine->m_programCounter = pc;
+            machine->_collectGarbageIfNeeded();
+            size_t depth = machine->m_callFrames.size();
+            if constexpr (Op == Operation::Call)
+            {
+                machine->_call();
+            }
+            else
+            {
+                machine->_callMethodSlot(arg, arg2);
+            }
+            return machine->m_callFrames.size() > depth ? machine->_jitCall(machine->_enterCompiledFunction()) : Jit::Continue;
+        }
+        else if constexpr (Op == Operation::CallLocal)
+        {
+            machine->m_programCounter = pc;
+            machine->_collectGarbageIfNeeded();
+            machine->_callLocal(arg, arg2);
+            return machine->_jitCall(machine->_enterCompiledFunction(arg));
+        }
+        else if constexpr (Op == Operation::CallMethod)
+        {
+            machine->m_programCounter = pc;
+            machine->_collectGarbageIfNeeded();
+            machine->_callMethod();
+        }
+        else if constexpr (Op == Operation::Return || Op == Operation::ReturnValue)
+        {
+            machine->m_programCounter = pc;
+            if constexpr (Op == Operation::Return)
+            {
+                machine->_return();
+            }
+            else
+            {
+                machine->_returnWithValue();
+            }
+            machine->m_jitExit = JitExit::Returned;
+            return Jit::Leave;
+        }
+        else if constexpr (Op == Operation::JumpBack)
+        {
+            machine->m_programCounter = pc;
+            machine->_collectGarbageIfNeeded();
+            return Jit::Branch;
+        }
+        else if constexpr (Op == Operation::JumpIfNot)
+        {
+            return machine->_popCondition() ? Jit::Continue : Jit::Branch;
+        }
+        else if constexpr (Op == Operation::JumpIf)
+        {
+            return machine->_popCondition() ? Jit::Branch : Jit::Continue;
+        }
+        else if constexpr (Op == Operation::JumpIfNotLessLocalConst)
+        {
+            return machine->_isLocalLessThanConst(arg2, std::bit_cast<int32_t>(arg)) ? Jit::Continue : Jit::Branch;
+        }
+        else if constexpr (Op == Operation::JumpIfNotLessOrEqLocalConst)
+        {
+            return machine->_isLocalLessOrEqConst(arg2, std::bit_cast<int32_t>(arg)) ? Jit::Continue : Jit::Branch;
+        }
+        else if constexpr (Op == Operation::JumpIfNotLessLocals)
+        {
+            return machine->_isLocalLessThanLocal(arg, arg2) ? Jit::Continue : Jit::Branch;
+        }
+        else if constexpr (Op == Operation::AddString)
+        {
+            if (!machine->_tryAddStrings())
+            {
+                machine->_add();
+            }
+        }
+        GOB_LANG_JIT_OPERATION(Add, _add())
+        GOB_LANG_JIT_OPERATION(Sub, _sub())
+        GOB_LANG_JIT_OPERATION(Mul, _mul())
+        GOB_LANG_JIT_OPERATION(Div, _div())
+        GOB_LANG_JIT_OPERATION(Modulo, _mod())
+        GOB_LANG_JIT_OPERATION(GetLocalFunction, _getLocalFunc(arg))
+        GOB_LANG_JIT_OPERATION(Set, _set())
+        GOB_LANG_JIT_OPERATION(Get, _get())
+        GOB_LANG_JIT_OPERATION(SetGlobalSlot, _setGlobalSlot(arg))
+        GOB_LANG_JIT_OPERATION(GetGlobalSlot, _getGlobalSlot(arg))
+        GOB_LANG_JIT_OPERATION(GetLocal, _getLocal(arg))
+        GOB_LANG_JIT_OPERATION(SetLocal, _setLocal(arg))
+        GOB_LANG_JIT_OPERATION(GetArray, _getArray())
+        GOB_LANG_JIT_OPERATION(SetArray, _setArray())
+        GOB_LANG_JIT_OPERATION(GetField, _getField())
+        GOB_LANG_JIT_OPERATION(SetField, _setField())
+        GOB_LANG_JIT_OPERATION(GetFieldSlot, _getFieldSlot(arg, arg2))
+        GOB_LANG_JIT_OPERATION(SetFieldSlot, _setFieldSlot(arg, arg2))
+        GOB_LANG_JIT_OPERATION(PushConstInt, pushToStack(Value(std::bit_cast<int32_t>(arg))))
+        GOB_LANG_JIT_OPERATION(PushConstUnsignedInt, pushToStack(Value(arg)))
+        GOB_LANG_JIT_OPERATION(PushConstFloat, pushToStack(Value(std::bit_cast<float>(arg))))
+        GOB_LANG_JIT_OPERATION(PushConstChar, pushToStack(Value((char)arg)))
+        GOB_LANG_JIT_OPERATION(PushConstString, _pushConstString(arg))
+        GOB_LANG_JIT_OPERATION(PushTrue, pushToStack(Value(true)))
+        GOB_LANG_JIT_OPERATION(PushFalse, pushToStack(Value(false)))
+        GOB_LANG_JIT_OPERATION(PushNull, _pushConstNull())
+        GOB_LANG_JIT_OPERATION(Equals, _eq())
+        GOB_LANG_JIT_OPERATION(NotEq, _neq())
+        GOB_LANG_JIT_OPERATION(Less, _less())
+        GOB_LANG_JIT_OPERATION(More, _more())
+        GOB_LANG_JIT_OPERATION(LessOrEq, _lessOrEq())
+        GOB_LANG_JIT_OPERATION(MoreOrEq, _moreOrEq())
+        GOB_LANG_JIT_OPERATION(Not, _not())
+        GOB_LANG_JIT_OPERATION(And, _and())
+        GOB_LANG_JIT_OPERATION(Or, _or())
+        GOB_LANG_JIT_OPERATION(Negate, _negate())
+        GOB_LANG_JIT_OPERATION(BitAnd, _bitAnd())
+        GOB_LANG_JIT_OPERATION(BitOr, _bitOr())
+        GOB_LANG_JIT_OPERATION(BitXor, _bitXor())
+        GOB_LANG_JIT_OPERATION(BitNot, _bitNot())
+        GOB_LANG_JIT_OPERATION(ShiftLeft, _shiftLeft())
+        GOB_LANG_JIT_OPERATION(ShiftRight, _shiftRight())
+        GOB_LANG_JIT_OPERATION(ShrinkLocal, _shrink(arg))
+        GOB_LANG_JIT_OPERATION(CreateArray, _createArray(arg))
+        GOB_LANG_JIT_OPERATION(New, _new(arg))
+        GOB_LANG_JIT_OPERATION(Discard, _discard())
+        GOB_LANG_JIT_OPERATION(IncLocalByConst, _incLocalByConst(arg2, std::bit_cast<int32_t>(arg)))
+        GOB_LANG_JIT_OPERATION(PushLocalAddConst, _pushLocalAddConst(arg2, std::bit_cast<int32_t>(arg)))
+        GOB_LANG_JIT_OPERATION(PushLocalSubConst, _pushLocalSubConst(arg2, std::bit_cast<int32_t>(arg)))
+        GOB_LANG_JIT_OPERATION(GetLocalField, _getLocal(arg3); machine->_getFieldSlot(arg, arg2))
+        GOB_LANG_JIT_OPERATION(SetLocalField, _getLocal(arg3); machine->_setFieldSlot(arg, arg2))
+        GOB_LANG_JIT_QUICKENED_OPERATION(AddInt, _add, int32_t, std::plus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(AddUnsignedInt, _add, uint32_t, std::plus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(AddFloat, _add, float, std::plus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(SubInt, _sub, int32_t, std::minus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(SubUnsignedInt, _sub, uint32_t, std::minus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(SubFloat, _sub, float, std::minus<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MulInt, _mul, int32_t, std::multiplies<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MulUnsignedInt, _mul, uint32_t, std::multiplies<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MulFloat, _mul, float, std::multiplies<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(DivInt, _div, int32_t, std::divides<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(DivUnsignedInt, _div, uint32_t, std::divides<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(DivFloat, _div, float, std::divides<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(LessInt, _less, int32_t, std::less<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(LessFloat, _less, float, std::less<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MoreInt, _more, int32_t, std::greater<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MoreFloat, _more, float, std::greater<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(LessOrEqInt, _lessOrEq, int32_t, std::less_equal<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(LessOrEqFloat, _lessOrEq, float, std::less_equal<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MoreOrEqInt, _moreOrEq, int32_t, std::greater_equal<>())
+        GOB_LANG_JIT_QUICKENED_OPERATION(MoreOrEqFloat, _moreOrEq, float, std::greater_equal<>())
+        else
+        {
+            static_assert(Op != Op, "Operation has no version for the compiled code");
+        }
+    }
+    catch (...)
+    {
+        machine->m_programCounter = pc;
+        machine->m_jitException = std::current_exception();
+        machine->m_jitExit = JitExit::Exception;
+        return Jit::Leave;
+    }
+    return Jit::Continue;
+}
+
+#undef GOB_LANG_JIT_QUICKENED_OPERATION
+#undef GOB_LANG_JIT_OPERATION
+
+// Operations that are performed by the compiled code, while every other operation returns to the interpreter
+#define GOB_LANG_JIT_HELPER(name) \
+    case Operation::name:         \
+        return &Machine::_jitOperation<Operation::name>;
+
+GobLang::Jit::OperationHelper GobLang::Machine::_getJitHelper(Operation op)
+{
+    switch (op)
+    {
+        GOB_LANG_JIT_HELPER(Add)
+        GOB_LANG_JIT_HELPER(Sub)
+        GOB_LANG_JIT_HELPER(Mul)
+        GOB_LANG_JIT_HELPER(Div)
+        GOB_LANG_JIT_HELPER(Modulo)
+        GOB_LANG_JIT_HELPER(Call)
+        GOB_LANG_JIT_HELPER(GetLocalFunction)
+        GOB_LANG_JIT_HELPER(CallLocal)
+        GOB_LANG_JIT_HELPER(Set)
+        GOB_LANG_JIT_HELPER(Get)
+        GOB_LANG_JIT_HELPER(SetGlobalSlot)
+        GOB_LANG_JIT_HELPER(GetGlobalSlot)
+        GOB_LANG_JIT_HELPER(GetLocal)
+        GOB_LANG_JIT_HELPER(SetLocal)
+        GOB_LANG_JIT_HELPER(GetArray)
+        GOB_LANG_JIT_HELPER(SetArray)
+        GOB_LANG_JIT_HELPER(GetField)
+        GOB_LANG_JIT_HELPER(SetField)
+        GOB_LANG_JIT_HELPER(GetFieldSlot)
+        GOB_LANG_JIT_HELPER(SetFieldSlot)
+        GOB_LANG_JIT_HELPER(CallMethod)
+        GOB_LANG_JIT_HELPER(CallMethodSlot)
+        GOB_LANG_JIT_HELPER(PushConstInt)
+        GOB_LANG_JIT_HELPER(PushConstUnsignedInt)
+        GOB_LANG_JIT_HELPER(PushConstFloat)
+        GOB_LANG_JIT_HELPER(PushConstChar)
+        GOB_LANG_JIT_HELPER(PushConstString)
+        GOB_LANG_JIT_HELPER(PushTrue)
+        GOB_LANG_JIT_HELPER(PushFalse)
+        GOB_LANG_JIT_HELPER(PushNull)
+        GOB_LANG_JIT_HELPER(Equals)
+        GOB_LANG_JIT_HELPER(Less)
+        GOB_LANG_JIT_HELPER(More)
+        GOB_LANG_JIT_HELPER(LessOrEq)
+        GOB_LANG_JIT_HELPER(MoreOrEq)
+        GOB_LANG_JIT_HELPER(NotEq)
+        GOB_LANG_JIT_HELPER(And)
+        GOB_LANG_JIT_HELPER(Or)
+        GOB_LANG_JIT_HELPER(Not)
+        GOB_LANG_JIT_HELPER(BitAnd)
+        GOB_LANG_JIT_HELPER(BitOr)
+        GOB_LANG_JIT_HELPER(BitXor)
+        GOB_LANG_JIT_HELPER(BitNot)
+        GOB_LANG_JIT_HELPER(ShiftLeft)
+        GOB_LANG_JIT_HELPER(ShiftRight)
+        GOB_LANG_JIT_HELPER(Negate)
+        GOB_LANG_JIT_HELPER(JumpBack)
+        GOB_LANG_JIT_HELPER(JumpIfNot)
+        GOB_LANG_JIT_HELPER(JumpIf)
+        GOB_LANG_JIT_HELPER(ShrinkLocal)
+        GOB_LANG_JIT_HELPER(Return)
+        GOB_LANG_JIT_HELPER(ReturnValue)
+        GOB_LANG_JIT_HELPER(CreateArray)
+        GOB_LANG_JIT_HELPER(New)
+        GOB_LANG_JIT_HELPER(Discard)
+        GOB_LANG_JIT_HELPER(IncLocalByConst)
+        GOB_LANG_JIT_HELPER(PushLocalAddConst)
+        GOB_LANG_JIT_HELPER(PushLocalSubConst)
+        GOB_LANG_JIT_HELPER(JumpIfNotLessLocalConst)
+        GOB_LANG_JIT_HELPER(JumpIfNotLessOrEqLocalConst)
+        GOB_LANG_JIT_HELPER(JumpIfNotLessLocals)
+        GOB_LANG_JIT_HELPER(GetLocalField)
+        GOB_LANG_JIT_HELPER(SetLocalField)
+        GOB_LANG_JIT_HELPER(AddInt)
+        GOB_LANG_JIT_HELPER(AddUnsignedInt)
+        GOB_LANG_JIT_HELPER(AddFloat)
+        GOB_LANG_JIT_HELPER(AddString)
+        GOB_LANG_JIT_HELPER(SubInt)
+        GOB_LANG_JIT_HELPER(SubUnsignedInt)
+        GOB_LANG_JIT_HELPER(SubFloat)
+        GOB_LANG_JIT_HELPER(MulInt)
+        GOB_LANG_JIT_HELPER(MulUnsignedInt)
+        GOB_LANG_JIT_HELPER(MulFloat)
+        GOB_LANG_JIT_HELPER(DivInt)
+        GOB_LANG_JIT_HELPER(DivUnsignedInt)
+        GOB_LANG_JIT_HELPER(DivFloat)
+        GOB_LANG_JIT_HELPER(LessInt)
+        GOB_LANG_JIT_HELPER(LessFloat)
+        GOB_LANG_JIT_HELPER(MoreInt)
+        GOB_LANG_JIT_HELPER(MoreFloat)
+        GOB_LANG_JIT_HELPER(LessOrEqInt)
+        GOB_LANG_JIT_HELPER(LessOrEqFloat)
+        GOB_LANG_JIT_HELPER(MoreOrEqInt)
+        GOB_LANG_JIT_HELPER(MoreOrEqFloat)
+    default:
+        // jumps are compiled into native jumps, while the end of the program and invalid operations are left to the interpreter
+        return nullptr;
+    }
+}
+
+#undef GOB_LANG_JIT_HELPER
@@ -1,11 +1,15 @@
 #pragma once
 #include <map>
+#include <set>
 #include <vector>
 #include <cstdint>
 #include <string>
 #include <cassert>
 #include <exception>
 #include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <optional>
 #include "Type.hpp"
 #include "Memory.hpp"
 #include "Operations.hpp"
@@ -16,25 +20,72 @@
 #include "Structure.hpp"
 #include "../codegen/ByteCode.hpp"
 #include "NativeStructure.hpp"
+#include "GarbageCollector.hpp"
+#include "Instruction.hpp"
+#include "StructureObject.hpp"
+#include "FunctionRef.hpp"
+#include "Jit.hpp"
+#include "Verifier.hpp"
+#include "ValueStack.hpp"
 
 using namespace GobLang::Struct;
 namespace GobLang
 {
+    /**
+     * @brief Information about how well arithmetic and comparison operations were specialized for the types of their operands
+     *
+     */
+    struct QuickeningStats
+    {
+        /// @brief Operations that were specialized for the types of their operands and only received those types since
+        size_t monomorphicSites = 0;
+        /// @brief Operations that received operands of a different type after being specialized and were returned to the generic version for good
+        size_t polymorphicSites = 0;
+        /// @brief Operations that can be specialized but were not executed yet or only received operands that have no specialized version
+        size_t genericSites = 0;
+        /// @brief How many times specialized operations were returned to the generic version
+        size_t deoptimizations = 0;
+    };
+
+    /**
+     * @brief Information about functions that were compiled into native code
+     *
+     */
+    struct JitStats
+    {
+        /// @brief Functions that were compiled into native code
+        size_t compiledFunctions = 0;
+        /// @brief Functions that were called often enough, but could not be compiled
+        size_t failedFunctions = 0;
+        /// @brief Loops whose traces were compiled into native code
+        size_t compiledTraces = 0;
+        /// @brief Loops that ran often enough, but leave the loop or run nested loops, so no trace could be recorded
+        size_t failedTraces = 0;
+        /// @brief Local variables that compiled loops keep unboxed in registers, because they only stored integers while the loops were recorded
+        size_t registerLocals = 0;
+        /// @brief How many times compiled code returned to the interpreter before the function returned
+        size_t bailouts = 0;
+        /// @brief Total size of the native code in bytes
+        size_t codeSize = 0;
+    };
+
     class Machine
     {
     public:
-        explicit Machine() = default;
+        explicit Machine();
 
         explicit Machine(Codegen::ByteCode const &code);
 
         void addOperation(Operation op)
         {
             m_operations.push_back((uint8_t)op);
+            m_instructionsOutdated = true;
         }
 
         void addUInt8(uint8_t val)
         {
             m_operations.push_back(val);
+            m_instructionsOutdated = true;
         }
 
         void addStringConst(std::string const &str)
@@ -42,18 +93,34 @@ namespace GobLang
             m_constStrings.push_back(str);
         }
 
+        /// @brief Get address of the operation in the byte code that will be executed next
         size_t getProgramCounter() const
         {
-            return m_programCounter;
+            return m_programCounter < m_instructionAddresses.size() ? m_instructionAddresses[m_programCounter] : m_operations.size();
         }
 
         bool isAtTheEnd() const
         {
-            return m_programCounter >= m_operations.size() || m_forcedEnd;
+            // operations added after the code was decoded are always after the current instruction
+            return m_forcedEnd || (!m_instructionsOutdated && m_programCounter >= m_instructions.size());
         }
         void addFunction(FunctionValue const &func, std::string const &name);
         void step();
 
+        /**
+         * @brief Execute the code until the end is reached. This is faster than calling `step` in a loop
+         *
+         */
+        void run();
+
+        /**
+         * @brief Execute at most the given amount of operations, stopping early if the end of the code is reached
+         *
+         * @param maxInstructions Max amount of operations to execute
+         * @return size_t How many operations were executed
+         */
+        size_t run(size_t maxInstructions);
+
         void printGlobalsInfo();
 
         void printVariablesInfo();
@@ -64,25 +131,87 @@ namespace GobLang
 
         Value getStackTopAndPop();
 
-        ArrayNode *createArrayOfSize(int32_t size);
+        /**
+         * @brief Create a new array object in memory
+         *
+         * @param size Size of the array
+         * @param type Type of the elements. Arrays of primitive types store elements without the type
+         * and are converted into generic arrays once a value of a different type is stored
+         * @return ArrayNode* Created array
+         */
+        ArrayNode *createArrayOfSize(int32_t size, ArrayElementType type = ArrayElementType::Generic);
 
         /**
          * @brief Create a new string object in memory
          *
+         * Strings created without `alwaysNew` are interned: equal strings share the same object, which is looked up by hash
+         *
          * @param str Base string to store in memory
-         * @param alwaysNew If true that means that it will skip search and always create new memory object.
-         * This is useful to avoid messing variables that were set from constants
+         * @param alwaysNew If true that means that it will skip search and always create new memory object that is not interned.
+         * This is useful for strings that are going to be modified to avoid messing variables that were set from constants
          * @return StringNode* Pointer to new string object or other string object that was found in memory
          */
         StringNode *createString(std::string const &str, bool alwaysNew = false);
 
         /**
-         * @brief Register object to be handled by the garbage collector. This object will be ref counted and deleted once it is no longer in use
+         * @brief Register object to be handled by the garbage collector. This object will be deleted once it can no longer be reached
+         * from the stack, variables or objects created by the native function that is currently running
          *
          * @param obj Object to register
          */
         void addObject(MemoryNode *obj);
 
+        /**
+         * @brief Create a new object using memory from the slab allocator of this interpreter and register it with the garbage collector.
+         * Objects created this way must not be deleted manually
+         *
+         * @tparam T Type of the object to create
+         * @tparam Args Types of the constructor arguments
+         * @param args Arguments passed to the constructor
+         * @return T* Created object
+         */
+        template <class T, class... Args>
+        T *allocate(Args &&...args)
+        {
+            return allocateWithExtraSize<T>(0, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Create a new object the same way as `allocate` does, but reserve additional memory right after the object.
+         * This is used by objects that store variable amount of data inline, like structure fields
+         *
+         * @tparam T Type of the object to create
+         * @tparam Args Types of the constructor arguments
+         * @param extraSize How many bytes to reserve after the object
+         * @param args Arguments passed to the constructor
+         * @return T* Created object
+         */
+        template <class T, class... Args>
+        T *allocateWithExtraSize(size_t extraSize, Args &&...args)
+        {
+            static_assert(std::is_base_of_v<MemoryNode, T>, "Only memory objects can be allocated by the interpreter");
+            static_assert(alignof(T) <= SlabAllocator::Alignment, "Object alignment is larger than what slab allocator provides");
+            SlabAllocator &allocator = m_gc.getAllocator();
+            size_t size = sizeof(T) + extraSize;
+            void *block = allocator.allocate(size);
+            T *obj = nullptr;
+            try
+            {
+                obj = new (block) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                allocator.deallocate(block, size);
+                throw;
+            }
+            obj->setAllocationSize(size);
+            addObject(obj);
+            return obj;
+        }
+
+        /// @brief Get allocator that provides memory for objects of this interpreter, which can be used to view allocation statistics
+        SlabAllocator const &getAllocator() const { return m_gc.getAllocator(); }
+
         void popStack();
 
         void pushToStack(Value const &val);
@@ -94,24 +223,38 @@ namespace GobLang
         template <class T>
         T popFromStack()
         {
-            Value top = _getFromTopAndPop();
-            if (!std::holds_alternative<T>(top))
+            Value top = getStackTopAndPop();
+            if (!top.is<T>())
             {
                 return 0;
             }
-            return std::get<T>(top);
+            return top.as<T>();
         }
 
         template <class T>
         T *popObjectFromStack()
         {
-            return dynamic_cast<T*>(popFromStack<MemoryNode *>());
+            return node_cast<T>(popFromStack<MemoryNode *>());
         }
 
-        Value getVariableValue(std::string const &name) { return m_globals[name]; }
+        /**
+         * @brief Get value of the global variable
+         *
+         * @param name Name of the variable
+         * @return Value Value of the variable or null if variable doesn't exist
+         */
+        Value getVariableValue(std::string const &name);
+
+        /**
+         * @brief Get id of the slot that stores the global variable with the given name. Slot is created if no variable with that name was used before
+         *
+         * @param name Name of the variable
+         * @return size_t Id of the slot
+         */
+        size_t getGlobalSlot(std::string const &name);
 
         /**
-         * @brief Set local variable value using id. If id is larger than current amount of variables the array will be expanded to match the id
+         * @brief Set local variable value using id. If id is larger than current amount of variables the frame will be expanded to match the id
          *
          * @param id id of the variable
          * @param val Value of the variable
@@ -128,6 +271,7 @@ namespace GobLang
 
         void shrinkLocalVariableStackBy(size_t size);
 
+        /// @brief Remove values of the current function from the stack and return to the frame of the caller
         void removeFunctionFrame();
 
         /// @brief Call local function that is stored under id funcId
@@ -146,16 +290,257 @@ namespace GobLang
 
         NativeStructureInfo const *getNativeStructure(std::string const &name);
 
-        void collectGarbage();
+        /**
+         * @brief Delete all objects that can not be reached from the stack, variables or the native function frames.
+         * This is called automatically once enough objects were allocated, but can also be called by the host at any point
+         *
+         * @param full If true objects from both generations are collected, otherwise only objects allocated since the last collection are checked
+         */
+        void collectGarbage(bool full = true);
+
+        /**
+         * @brief Set how many objects have to be allocated since the last collection before garbage collector runs again.
+         * Old generation is collected once it doubles in size since the last full collection, but never before it reaches this amount of objects
+         *
+         * @param allocations Amount of allocations between collections
+         */
+        void setGarbageCollectionThreshold(size_t allocations);
+
+        size_t getGarbageCollectionThreshold() const { return m_gc.getThreshold(); }
+
+        /**
+         * @brief Set how long a single garbage collection pause can take. If budget is not 0 full collections are performed incrementally,
+         * by marking and sweeping objects in slices that are interleaved with the execution. Collections of objects allocated since the last collection are always done at once
+         * and their duration depends on the collection threshold
+         *
+         * @param microseconds Max duration of a single slice or 0 to perform every collection at once
+         */
+        void setGcPauseBudget(size_t microseconds) { m_gcPauseBudget = std::chrono::microseconds(microseconds); }
+
+        size_t getGcPauseBudget() const { return m_gcPauseBudget.count(); }
+
+        /// @brief Get distribution of the time spent in the garbage collector per pause
+        GcPauseHistogram const &getGcPauseHistogram() const { return m_gc.getPauseHistogram(); }
+
+        /// @brief Remove all recorded garbage collector pauses
+        void resetGcPauseHistogram() { m_gc.resetPauseHistogram(); }
+
+        /// @brief Amount of objects currently tracked by the garbage collector
+        size_t getObjectCount() const { return m_gc.getObjectCount(); }
+
+        /// @brief Count how many arithmetic and comparison operations in the code stayed specialized for a single type of operands
+        QuickeningStats getQuickeningStats() const;
+
+        /**
+         * @brief Compile functions into native code once they were called enough times. Compiled code is only used by `run()`,
+         * while `step` and `run(maxInstructions)` always interpret the code. Has no effect on platforms where native code can not be generated
+         *
+         * @param enabled Whether functions should be compiled
+         */
+        void setJitEnabled(bool enabled) { m_jitEnabled = enabled && Jit::isSupported(); }
+
+        bool isJitEnabled() const { return m_jitEnabled; }
+
+        /// @brief Set how many times function has to be called before it is compiled into native code
+        /// @param calls Amount of calls
+        void setJitThreshold(size_t calls) { m_jitThreshold = calls; }
+
+        size_t getJitThreshold() const { return m_jitThreshold; }
+
+        /// @brief Set how many times the loop has to jump back to its start before the path through the loop is compiled into native code
+        /// @param iterations Amount of iterations
+        void setJitLoopThreshold(size_t iterations) { m_jitLoopThreshold = iterations; }
+
+        size_t getJitLoopThreshold() const { return m_jitLoopThreshold; }
+
+        /**
+         * @brief Set how native code is generated. Code that was already compiled is discarded, so this must not be called while the code runs.
+         * Stencils are only available if they were built together with the interpreter, otherwise the assembler is used
+         *
+         * @param backend Backend used for functions and loops compiled from now on
+         */
+        void setJitBackend(Jit::Backend backend);
+
+        Jit::Backend getJitBackend() const { return m_jitBackend; }
+
+        /// @brief Get information about functions that were compiled into native code
+        JitStats getJitStats() const;
+
+        /**
+         * @brief Verify the code and let `run()` execute it without checking that operations have enough operands on the stack
+         * and that local variables they use exist. Calls can leave any amount of values on the stack, so once the frame no longer has
+         * what the verifier expects after a call, the rest of the code is executed with every check. Code added later is verified before it runs.
+         * Like compiled code this is only used by `run()`, and checked execution stays the default for code that can't be trusted
+         *
+         * @param enabled Whether verified code is executed without checks
+         * @throws RuntimeException If code is malformed, in which case unchecked execution stays disabled
+         */
+        void setUncheckedExecutionEnabled(bool enabled);
+
+        bool isUncheckedExecutionEnabled() const { return m_uncheckedExecution; }
 
         ~Machine();
 
     private:
-        inline Value _operationTop() { return m_operationStack.back().back(); }
+        /**
+         * @brief Function call that is currently executing. Its local variables start at `base` in the value stack
+         * and are followed by the operands of the function
+         *
+         */
+        struct CallFrame
+        {
+            /// @brief Index of the instruction that called the function, execution continues after it once the function returns
+            size_t returnAddress = 0;
+            /// @brief Position of the first local variable in the value stack
+            size_t base = 0;
+            /// @brief Amount of local variables
+            size_t localCount = 0;
+            /// @brief Amount of values reserved for the local variables, the operands start after them. Variables are created in these values without moving the operands
+            size_t localCapacity = 0;
+        };
+
+        /// @brief How execution of the compiled function ended
+        enum class JitExit
+        {
+            /// @brief Function was not compiled, so it has to be interpreted
+            NotCompiled,
+            /// @brief Function returned and execution continues after the call
+            Returned,
+            /// @brief Interpreter has to continue execution from the program counter, with the frame of the function still in place
+            Bailout,
+            /// @brief Exception was thrown by the operation at the program counter
+            Exception,
+        };
+
+        /// @brief Native code and call count of a function defined by the user
+        struct JitFunction
+        {
+            size_t callCount = 0;
+            /// @brief Whether compilation was attempted and failed, in which case the function is always interpreted
+            bool failed = false;
+            std::unique_ptr<Jit::CompiledCode> code;
+        };
+
+        /// @brief Native code of the paths through the loop that were taken while the trace was recorded
+        struct LoopTrace
+        {
+            size_t iterations = 0;
+            /// @brief How many iterations left the compiled code before reaching the end of the loop since the trace was last recorded
+            size_t sideExits = 0;
+            /// @brief How many times iterations of the loop were recorded, which is limited by `MAX_JIT_TRACE_RECORDINGS`
+            size_t recordings = 0;
+            /// @brief Whether every recording failed, in which case the loop is always interpreted
+            bool failed = false;
+            /// @brief Sorted indices of all instructions that were executed in the recorded iterations
+            std::vector<size_t> path;
+            /// @brief Local variables used by the recorded iterations that stored anything except integers
+            std::set<uint32_t> nonIntegerLocals;
+            /// @brief Local variables that the compiled code keeps in registers
+            std::vector<uint32_t> registerLocals;
+            std::unique_ptr<Jit::CompiledCode> code;
+        };
+
+        /**
+         * @brief Run the function whose frame was just created as native code, compiling it first if it was called enough times
+         *
+         * @return JitExit How execution ended
+         */
+        JitExit _enterCompiledFunction();
+
+        /**
+         * @brief Run the function whose frame was just created as native code, when id of the function is already known
+         *
+         * @param funcId Id of the function
+         * @return JitExit How execution ended
+         */
+        JitExit _enterCompiledFunction(size_t funcId);
+
+        /**
+         * @brief Compile the function into native code
+         *
+         * @param funcId Id of the function
+         * @return true If function was compiled
+         */
+        bool _compileFunction(size_t funcId);
+
+        /// @brief Remove all compiled code, which must be done whenever the instructions are decoded again
+        void _resetJit();
+
+        /**
+         * @brief Run the trace of the loop that starts at the program counter, recording and compiling it first if the loop ran enough iterations.
+         * Loops whose iterations often leave the trace are recorded again and the new path is added to the trace
+         *
+         * @param jumpBack Index of the instruction that jumped back to the start of the loop
+         * @return JitExit How execution ended. `Bailout` means that the interpreter continues from the program counter,
+         * which is also the case after recording, as recording executes one iteration of the loop
+         */
+        JitExit _enterLoopTrace(size_t jumpBack);
 
+        /**
+         * @brief Execute one iteration of the loop one instruction at a time and record which instructions were executed.
+         * Other functions that are called are executed as well, but are not part of the trace
+         *
+         * @param start Index of the first instruction of the loop
+         * @param jumpBack Index of the instruction that jumps back to the start of the loop
+         * @param nonIntegerLocals Output for the local variables that the loop used while they stored anything except integers
+         * @return std::optional<std::vector<size_t>> Sorted indices of the instructions or nothing if iteration left the loop,
+         * ran a nested loop or was too long
+         */
+        std::optional<std::vector<size_t>> _recordLoopTrace(size_t start, size_t jumpBack, std::set<uint32_t> &nonIntegerLocals);
+
+        /**
+         * @brief Pick local variables of the trace that are kept in registers, which are the most used ones that only stored integers
+         * and are only accessed by operations that can use registers
+         *
+         */
+        std::vector<uint32_t> _getRegisterLocals(LoopTrace const &trace);
+
+        /// @brief Prepare instruction for compilation, instructions that can't be compiled make compiled code return to the interpreter
+        Jit::JitInstruction _getJitInstruction(size_t i);
+
+        /// @brief Generate native code for the instructions using the selected backend. Only the assembler keeps local variables in registers
+        std::unique_ptr<Jit::CompiledCode> _compileJitCode(
+            std::vector<Jit::JitInstruction> const &instructions,
+            size_t entry,
+            std::vector<uint32_t> const &registerLocals = {}) const;
+
+        /// @brief Find where the values used by native operations are stored in this machine
+        /// @return Jit::MachineLayout Layout that is not valid if the standard library stores the stack in an unexpected way
+        Jit::MachineLayout _getJitLayout() const;
+
+        /// @brief Get operation that performs given instruction for the compiled code or nullptr if instruction can't be compiled
+        static Jit::OperationHelper _getJitHelper(Operation op);
+
+        /// @brief Perform operation of the instruction for the compiled code. Exceptions are stored, as they can't be thrown through the native code
+        template <Operation Op>
+        static uint32_t _jitOperation(Machine *machine, uint32_t pc, uint32_t arg, uint32_t arg2, uint32_t arg3);
+
+        /// @brief Leave compiled code and let the interpreter continue from the instruction at pc. Takes arguments of an operation only to be usable as a helper
+        static uint32_t _jitBailout(Machine *machine, uint32_t pc, uint32_t arg, uint32_t arg2, uint32_t arg3);
+
+        /// @brief Continue execution of the function that was called from the compiled code using its native code
+        /// @param exit Result of entering the called function
+        /// @return uint32_t `Continue` if function returned or `Leave` if interpreter has to continue execution
+        uint32_t _jitCall(JitExit exit);
+
+        /// @brief Position of the first operand of the current frame in the value stack
+        size_t _getOperandBase() const { return m_frame.base + m_frame.localCapacity; }
+
+        /**
+         * @brief Make sure that the value stack has memory for the whole current frame, so pushing operands and creating local variables doesn't reallocate it
+         *
+         * @param size Max amount of local variables and operands of the frame
+         */
+        void _reserveFrame(size_t size);
+
+        inline Value _operationTop() { return m_stack.back(); }
+
+        /// @brief Pop operand of the current frame
+        /// @tparam Checked If false the stack is assumed to have an operand, which verified code guarantees
+        template <bool Checked = true>
         Value _getFromTopAndPop()
         {
-            if (m_operationStack.back().empty())
+            if (Checked && m_stack.size() <= _getOperandBase())
             {
                 throw RuntimeException("Can not pop from stack because stack is empty");
             }
@@ -163,32 +548,50 @@ namespace GobLang
             popStack();
             return v;
         }
-        ProgramAddressType _getAddressFromByteCode(size_t start);
-
-        /// @brief Parse next `sizeof(T)` bytes into a T value using bitshifts and reinterpret cast
-        /// @tparam T Type of the value to convert into
-        /// @param start Where in the byte code to start from
-        /// @return Parsed value
-        template <typename T>
-        T _parseOperationConstant(size_t start)
+
+        /// @brief Mark every value that is directly accessible by the interpreter
+        void _markRoots();
+
+        /// @brief Perform garbage collection work limited by the pause budget, starting incremental collection if necessary
+        void _collectGarbageSlice();
+
+        /// @brief Finish incremental collection that is currently in progress without any time limit
+        void _finishGarbageCollection();
+
+        /// @brief Call native function while keeping every object it receives or creates alive until it returns
+        /// @param func Function to call
+        void _callNative(FunctionValue func);
+
+        /**
+         * @brief Execute operations until the end of the code is reached
+         *
+         * @tparam Limited If true execution also stops after `maxInstructions` operations
+         * @tparam Checked If false operations don't check the operands and local variables that the verifier proved to exist,
+         * and execution stops once the frame doesn't have what the verifier expects
+         * @param maxInstructions Max amount of operations to execute, only used if `Limited` is true
+         * @return size_t How many operations were executed, only counted if `Limited` is true
+         */
+        template <bool Limited, bool Checked>
+        size_t _execute(size_t maxInstructions);
+
+        /// @brief Check that the current frame has the operands and local variables that the verifier expects at the instruction
+        bool _isInVerifiedState(size_t pc) const
         {
-            uint64_t res = 0;
-            for (uint64_t i = 0; i < sizeof(T); i++)
+            if (pc >= m_verifiedStates.size())
             {
-                uint64_t offset = (sizeof(T) - i - 1) * 8;
-                res |= (uint64_t)(m_operations[start + i]) << offset;
+                return false;
             }
-            T *f = reinterpret_cast<T *>(&res);
-            return *f;
+            VerifiedState const &state = m_verifiedStates[pc];
+            return m_frame.localCount >= state.localCount && m_stack.size() >= _getOperandBase() + state.requiredOperands;
         }
 
-        inline void _jump();
+        /// @brief Run garbage collection or incremental collection slice if enough objects were allocated or slice is due
+        inline void _collectGarbageIfNeeded();
 
-        inline void _jumpIfNot();
-
-         inline void _jumpIf();
-
-        inline void _jumpBack();
+        /// @brief Pop condition of a conditional jump from the stack
+        /// @return Value of the condition
+        template <bool Checked = true>
+        inline bool _popCondition();
 
         inline void _add();
 
@@ -204,6 +607,115 @@ namespace GobLang
 
         inline void _get();
 
+        inline void _setGlobalSlot(size_t slot);
+
+        inline void _getGlobalSlot(size_t slot);
+
+        /**
+         * @brief Convert byte code into instructions that have their arguments parsed, global variables resolved into slots and jump targets converted into instruction indices
+         *
+         */
+        void _decodeOperations();
+
+        /**
+         * @brief Get the argument of the instruction that stores where it jumps to
+         *
+         * @param instruction Instruction to check
+         * @return uint32_t* Pointer to the argument or nullptr if the instruction doesn't jump
+         */
+        static uint32_t *_getJumpTarget(Instruction &instruction);
+
+        /**
+         * @brief Check if the instructions starting at the given position can be replaced by a superinstruction
+         *
+         * @param code Decoded instructions
+         * @param addresses Address of every instruction in the byte code
+         * @param jumpTargets Which addresses in the byte code are targets of jumps or start of functions
+         * @param start Index of the first instruction to check
+         * @param result Output for the superinstruction, left unchanged if instructions can't be replaced
+         * @return size_t How many instructions were replaced, with 1 meaning that nothing was replaced
+         */
+        static size_t _fuseInstructions(
+            std::vector<Instruction> const &code,
+            std::vector<size_t> const &addresses,
+            std::vector<bool> const &jumpTargets,
+            size_t start,
+            Instruction &result);
+
+        /// @brief Get local variable of the current frame
+        /// @tparam Checked If false the variable is assumed to exist, which verified code guarantees
+        /// @return Value* Value of the variable or nullptr if it doesn't exist
+        template <bool Checked>
+        Value *_getLocalValue(size_t id)
+        {
+            if constexpr (Checked)
+            {
+                return getLocalVariableValue(id);
+            }
+            return &m_stack[m_frame.base + id];
+        }
+
+        template <bool Checked = true>
+        inline void _incLocalByConst(size_t id, int32_t value);
+
+        template <bool Checked = true>
+        inline void _pushLocalAddConst(size_t id, int32_t value);
+
+        template <bool Checked = true>
+        inline void _pushLocalSubConst(size_t id, int32_t value);
+
+        template <bool Checked = true>
+        inline bool _isLocalLessThanConst(size_t id, int32_t value);
+
+        template <bool Checked = true>
+        inline bool _isLocalLessOrEqConst(size_t id, int32_t value);
+
+        template <bool Checked = true>
+        inline bool _isLocalLessThanLocal(size_t a, size_t b);
+
+        /**
+         * @brief Get operation that the generic operation should be replaced with based on the types of the operands on the stack
+         *
+         * @param instruction Instruction that is about to be executed
+         * @return Operation Specialized operation or the same operation if it can't be specialized
+         */
+        inline Operation _getQuickenedOperation(Instruction const &instruction);
+
+        /**
+         * @brief Return specialized instruction to the generic version, which won't be specialized again
+         *
+         * @param instruction Instruction that received operands of unexpected types
+         * @param generic Generic version of the operation
+         */
+        inline void _deoptimize(Instruction &instruction, Operation generic);
+
+        /**
+         * @brief Replace two values on top of the stack with the result of the operation if both of them have the expected type.
+         * This is both the type check and the implementation of the specialized operations
+         *
+         * @tparam T Expected type of the operands
+         * @tparam Checked If false the stack is assumed to have both operands, which verified code guarantees
+         * @tparam Operator Type of the operation
+         * @param op Operation that receives the value below the top of the stack and the value on top of it
+         * @return true If values had the expected type and the operation was done
+         */
+        template <typename T, bool Checked = true, typename Operator>
+        bool _tryBinaryOperation(Operator op)
+        {
+            size_t size = m_stack.size();
+            if ((Checked && size < _getOperandBase() + 2) || !m_stack[size - 2].is<T>() || !m_stack[size - 1].is<T>())
+            {
+                return false;
+            }
+            m_stack[size - 2] = Value(op(m_stack[size - 2].as<T>(), m_stack[size - 1].as<T>()));
+            m_stack.pop();
+            return true;
+        }
+
+        /// @brief Concatenate two strings on top of the stack if both values are strings
+        /// @return true If both values were strings
+        inline bool _tryAddStrings();
+
         inline void _bitAnd();
 
         inline void _bitOr();
@@ -216,27 +728,29 @@ namespace GobLang
 
         inline void _shiftRight();
 
-        inline void _setLocal();
+        template <bool Checked = true>
+        inline void _setLocal(size_t id);
 
-        inline void _getLocal();
+        template <bool Checked = true>
+        inline void _getLocal(size_t id);
 
         inline void _call();
 
-        inline void _getLocalFunc();
+        inline void _getLocalFunc(size_t funcId);
+
+        /**
+         * @brief Call function defined by the user, checking that it receives the expected amount of arguments
+         *
+         * @param funcId Id of the function
+         * @param argCount Amount of arguments that were pushed by the caller
+         */
+        inline void _callLocal(size_t funcId, size_t argCount);
 
         inline void _return();
 
         inline void _returnWithValue();
 
-        inline void _pushConstInt();
-
-        inline void _pushConstUnsignedInt();
-
-        inline void _pushConstFloat();
-
-        inline void _pushConstChar();
-
-        inline void _pushConstString();
+        inline void _pushConstString(size_t id);
 
         inline void _pushConstNull();
 
@@ -248,8 +762,31 @@ namespace GobLang
 
         inline void _setField();
 
+        inline void _getFieldSlot(size_t fieldNameId, size_t cacheId);
+
+        inline void _setFieldSlot(size_t fieldNameId, size_t cacheId);
+
+        /**
+         * @brief Find slot of the field using the inline cache if object is a structure
+         *
+         * @param object Object which field is accessed
+         * @param fieldNameId Id of the field name
+         * @param cacheId Id of the inline cache of the operation
+         * @return size_t Id of the field in the structure or `NoFieldSlot` if object has no structure
+         */
+        inline size_t _resolveFieldSlot(MemoryNode *object, size_t fieldNameId, size_t cacheId);
+
         inline void _callMethod();
 
+        /**
+         * @brief Call method of the object on top of the stack. Methods of native types are found using the inline cache and called directly,
+         * while other objects get the field and call it
+         *
+         * @param methodNameId Id of the method name
+         * @param cacheId Id of the inline cache of the operation
+         */
+        inline void _callMethodSlot(size_t methodNameId, size_t cacheId);
+
         inline void _eq();
 
         inline void _neq();
@@ -270,40 +807,114 @@ namespace GobLang
 
         inline void _not();
 
-        inline void _shrink();
+        inline void _shrink(size_t amount);
 
-        inline void _createArray();
+        inline void _createArray(int32_t size);
 
-        inline void _new();
+        inline void _new(size_t structId);
+
+        /// @brief Remove every operand of the current frame
+        inline void _discard();
 
         bool m_forcedEnd = false;
 
-        MemoryNode m_memoryRoot;
+        /// @brief Max duration of a single incremental garbage collection slice
+        std::chrono::microseconds m_gcPauseBudget = std::chrono::microseconds(DEFAULT_GC_PAUSE_BUDGET);
+        /// @brief Earliest time when next incremental collection slice can start, so that program gets at least as much time as the collector
+        std::chrono::steady_clock::time_point m_nextGcSlice;
+        /// @brief How many native functions are currently being executed
+        size_t m_nativeCallDepth = 0;
+        /**
+         * @brief Objects that were popped from the stack or created while a native function is running.
+         * These are roots for the garbage collector because native function can hold them in local variables
+         *
+         */
+        std::vector<MemoryNode *> m_nativeRoots;
+        /// @brief Index of the instruction that will be executed next
         size_t m_programCounter = 0;
+        /// @brief Byte code of the program, which is decoded into instructions before execution
         std::vector<uint8_t> m_operations;
-        std::vector<std::vector<Value>> m_operationStack = {{}};
+        std::vector<Instruction> m_instructions;
+        /// @brief Address of each instruction in the byte code
+        std::vector<size_t> m_instructionAddresses;
+        /// @brief Index of the instruction that starts at the given address in the byte code, used for converting function addresses
+        std::vector<size_t> m_addressInstructions;
+        /// @brief If true operations were added after the code was decoded, so it has to be decoded again before execution
+        bool m_instructionsOutdated = true;
+        size_t m_deoptimizationCount = 0;
         /**
-         * @brief Special dictionary that can be written externally and internally which uses strings to identify variables.
+         * @brief Local variables and operands of every function call, stored one frame after another.
+         * Arguments pushed by the caller become the first local variables of the callee without being copied
          *
-         * Any variable that doesn't have a valid local variable attached will attempt to read a global variable value
          */
-        std::map<std::string, Value> m_globals;
+        ValueStack m_stack;
+        /// @brief Frame of the function that is currently executing
+        CallFrame m_frame;
+        /// @brief Frames of the functions that are waiting for the current function to return
+        std::vector<CallFrame> m_callFrames;
+        struct GlobalVariable
+        {
+            Value value;
+            /// @brief Whether any value was assigned to the variable, as reading variables that were never assigned is an error
+            bool defined = false;
+        };
         /**
-         * @brief Array of currently present local variables.
-         *  These variables can only be addressed by their index and will be overriden once the id is used in a different block
+         * @brief Global variables that can be written externally and internally, stored in slots that are assigned once per name.
          *
+         * Any variable that doesn't have a valid local variable attached will attempt to read a global variable value
          */
-        std::vector<std::vector<Value>> m_variables = {{}};
+        std::vector<GlobalVariable> m_globals;
+        /// @brief Name of the global variable stored in each slot
+        std::vector<std::string> m_globalNames;
+        /// @brief Ids of the global variable slots by the name of the variable
+        std::map<std::string, size_t> m_globalSlots;
         std::vector<std::string> m_constStrings;
         std::vector<Function> m_functions;
+        /// @brief Reference object for every function defined by the user, created once so that using functions as values doesn't allocate
+        std::vector<FunctionRef *> m_localFunctionRefs;
         std::vector<std::unique_ptr<Struct::Structure>> m_structures;
 
-        std::map<std::string, std::unique_ptr<Struct::NativeStructureInfo>> m_nativeStructures;
-
         /**
-         * @brief Return locations for all of the call operations. This points to where the jump happened from
+         * @brief Inline cache of a single field access operation which remembers field id from the last structure that was accessed
+         * or, for method calls, the method of the last native type that was called
          *
          */
-        std::vector<size_t> m_callStack;
+        struct FieldSlotCache
+        {
+            Struct::Structure const *type = nullptr;
+            size_t slot = 0;
+            Struct::NativeStructureInfo const *nativeType = nullptr;
+            FunctionValue method = nullptr;
+        };
+        static constexpr size_t NoFieldSlot = SIZE_MAX;
+        std::vector<FieldSlotCache> m_fieldSlotCaches;
+
+        std::map<std::string, std::unique_ptr<Struct::NativeStructureInfo>> m_nativeStructures;
+
+        bool m_jitEnabled = false;
+        size_t m_jitThreshold = DEFAULT_JIT_CALL_THRESHOLD;
+        /// @brief Compiled code of every function defined by the user
+        std::vector<JitFunction> m_jitFunctions;
+        /// @brief Ids of the functions by the index of their first instruction
+        std::unordered_map<size_t, size_t> m_jitEntries;
+        size_t m_jitLoopThreshold = DEFAULT_JIT_LOOP_THRESHOLD;
+        Jit::Backend m_jitBackend = Jit::Backend::Assembler;
+        /// @brief Traces of the loops by the index of the first instruction of the loop
+        std::vector<LoopTrace> m_loopTraces;
+        /// @brief Start of the loop whose trace returned to the interpreter last or `SIZE_MAX` if the last trace reached its end
+        size_t m_lastTraceExit = SIZE_MAX;
+        /// @brief How many compiled functions are currently running inside of each other
+        size_t m_jitDepth = 0;
+        JitExit m_jitExit = JitExit::NotCompiled;
+        /// @brief Exception thrown by the operation called from the compiled code
+        std::exception_ptr m_jitException;
+        size_t m_jitBailouts = 0;
+
+        bool m_uncheckedExecution = false;
+        /// @brief What the verifier proved about the frame at every instruction, with one extra state for the end of the code. Only set if unchecked execution is enabled
+        std::vector<VerifiedState> m_verifiedStates;
+
+        /// @brief Declared last so that objects are destroyed while structures that describe them are still alive
+        GarbageCollector m_gc;
     };
 }
\ No newline at end of file
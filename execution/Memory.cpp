@@ -1,45 +1,18 @@
 #include "Memory.hpp"
 #include "Machine.hpp"
-GobLang::MemoryNode::MemoryNode(Struct::Structure const *base) : m_struct(base)
-{
-    if (base == nullptr)
-    {
-        return;
-    }
-    for (Field const &field : base->fields)
-    {
-        m_fieldNames[field.name] = m_fields.size();
-        m_fields.push_back(Value(nullptr));
-        // switch (field.type)
-        // {
-        // case StructureFieldType::Char:
-        //     m_fields.push_back(Value{.type = Type::Char, .value = '\0'});
-        //     break;
-        // case StructureFieldType::Bool:
-        //     m_fields.push_back(Value{.type = Type::Char, .value = false});
-        //     break;
-        // case StructureFieldType::Float:
-        //     m_fields.push_back(Value{.type = Type::Float, .value = 0.f});
-        //     break;
-        // case StructureFieldType::Int:
-        //     m_fields.push_back(Value{.type = Type::Int, .value = 0});
-        //     break;
-        // case StructureFieldType::UnsignedInt:
-        //     m_fields.push_back(Value{.type = Type::Int, .value = 0u});
-        //     break;
-        // default:
-        //     m_fields.push_back(Value{.type = Type::Null, .value = 0});
-        //     break;
-        // }
-    }
-}
+#include "GarbageCollector.hpp"
 void GobLang::MemoryNode::insert(MemoryNode *node)
 {
     if (node != nullptr)
     {
         MemoryNode *prevNext = m_next;
         m_next = node;
+        node->m_prev = this;
         node->m_next = prevNext;
+        if (prevNext != nullptr)
+        {
+            prevNext->m_prev = node;
+        }
     }
 }
 
@@ -48,7 +21,25 @@ void GobLang::MemoryNode::eraseNext()
     if (m_next != nullptr)
     {
         m_next = m_next->m_next;
+        if (m_next != nullptr)
+        {
+            m_next->m_prev = this;
+        }
+    }
+}
+
+void GobLang::MemoryNode::unlink()
+{
+    if (m_prev != nullptr)
+    {
+        m_prev->m_next = m_next;
     }
+    if (m_next != nullptr)
+    {
+        m_next->m_prev = m_prev;
+    }
+    m_prev = nullptr;
+    m_next = nullptr;
 }
 
 void GobLang::MemoryNode::pushBack(MemoryNode *node)
@@ -63,45 +54,47 @@ void GobLang::MemoryNode::pushBack(MemoryNode *node)
     {
         curr = curr->m_next;
     }
-    curr->m_next = node;
-}
-
-void GobLang::MemoryNode::increaseRefCount()
-{
-    m_refCount++;
+    curr->insert(node);
 }
 
-void GobLang::MemoryNode::decreaseRefCount()
+void GobLang::MemoryNode::trace([[maybe_unused]] GarbageCollector &gc)
 {
-    m_refCount--;
 }
 
-void GobLang::MemoryNode::setField(std::string const &field, Value const &value)
+void GobLang::MemoryNode::_writeBarrierSlow(Value const &value)
 {
-    if (m_fieldNames.count(field) == 0)
+    if (!value.is<MemoryNode *>())
+    {
+        return;
+    }
+    MemoryNode *obj = value.as<MemoryNode *>();
+    if (obj == nullptr)
     {
-        throw RuntimeException(std::string("Invalid field name ") + field);
+        return;
     }
-    size_t id = m_fieldNames[field];
-    // check if object that we are setting is itself to avoid creating a ref cycle
-    if ((Type)value.index() == Type::MemoryObj && std::get<MemoryNode *>(value) != this)
+    // every young object that survives incremental collection is promoted, so there is no need to remember anything while marking
+    if (m_collector->isMarking())
     {
-        std::get<MemoryNode *>(value)->increaseRefCount();
+        if (m_marked)
+        {
+            m_collector->markObject(obj);
+        }
     }
-    if ((Type)m_fields[id].index() == Type::MemoryObj && std::get<MemoryNode *>(m_fields[id]) != this)
+    // unregistered objects will become young once registered
+    else if (m_old && !m_remembered && !obj->isOld())
     {
-        std::get<MemoryNode *>(m_fields[id])->decreaseRefCount();
+        m_collector->rememberObject(this);
     }
-    m_fields[id] = value;
+}
+
+void GobLang::MemoryNode::setField(std::string const &field, [[maybe_unused]] Value const &value)
+{
+    throw RuntimeException(std::string("Invalid field name ") + field);
 }
 
 GobLang::Value GobLang::MemoryNode::getField(std::string const &field)
 {
-    if (m_fieldNames.count(field) == 0)
-    {
-        throw RuntimeException(std::string("Invalid field name ") + field);
-    }
-    return m_fields[m_fieldNames[field]];
+    throw RuntimeException(std::string("Invalid field name ") + field);
 }
 
 size_t GobLang::MemoryNode::length()
@@ -122,23 +115,9 @@ bool GobLang::MemoryNode::equalsTo(MemoryNode *other)
 
 std::string GobLang::MemoryNode::toString(bool pretty, size_t depth)
 {
-    std::string start = "{";
-    for (std::vector<Value>::const_iterator it = m_fields.begin(); it != m_fields.end(); it++)
-    {
-        start += m_struct->fields[it - m_fields.begin()].name + "=" + valueToString(*it, pretty, depth);
-
-        start += (it + 1 == m_fields.end()) ? "}" : ",";
-    }
-    return start;
+    return "{}";
 }
 
 GobLang::MemoryNode::~MemoryNode()
 {
-    for (std::vector<Value>::iterator it = m_fields.begin(); it != m_fields.end(); it++)
-    {
-        if ((Type)it->index() == Type::MemoryObj)
-        {
-            std::get<MemoryNode *>((*it))->decreaseRefCount();
-        }
-    }
 }
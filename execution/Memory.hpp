@@ -3,10 +3,35 @@
 #include <vector>
 #include <iostream>
 #include <cstdint>
+#include <type_traits>
 #include "Type.hpp"
 #include "Structure.hpp"
 namespace GobLang
 {
+    namespace Struct
+    {
+        struct NativeStructureInfo;
+    }
+    class GarbageCollector;
+
+    /**
+     * @brief Kind of the object, which is stored in every object so that the interpreter could find out the type of the object
+     * without using RTTI
+     *
+     */
+    enum class MemoryNodeKind : uint8_t
+    {
+        /// @brief Object that is not any of the other kinds
+        Other,
+        String,
+        Array,
+        /// @brief Instance of a structure declared in code
+        Struct,
+        FunctionRef,
+        /// @brief Instance of a native type, including every type derived from the native structure object
+        Native,
+    };
+
     /**
      * @brief Represents a complex data object that is stored in the memory via a linked list.
      *
@@ -17,20 +42,70 @@ namespace GobLang
     {
     public:
         explicit MemoryNode() = default;
-        explicit MemoryNode(Struct::Structure const* baseStruct);
+
+        /// @brief Get the kind of the object, which is set once by the constructor of the object
+        MemoryNodeKind getKind() const { return m_kind; }
         /**
-         * @brief Should be deleted by the garbage collector or not
+         * @brief Was this object reached by the garbage collector during current collection
          *
          * @return true
          * @return false
          */
-        bool isDead() const { return m_dead || m_refCount <= 0; }
+        bool isMarked() const { return m_marked; }
+
+        /// @brief Mark object as reachable
+        void mark() { m_marked = true; }
+
+        /// @brief Reset the reachability mark after the collection
+        void unmark() { m_marked = false; }
+
+        /**
+         * @brief Did this object survive a garbage collection and got moved to the old generation
+         *
+         * @return true
+         * @return false
+         */
+        bool isOld() const { return m_old; }
+
+        /// @brief Move object to the old generation
+        void promote() { m_old = true; }
+
+        /// @brief Is this object in the remembered set of the garbage collector
+        bool isRemembered() const { return m_remembered; }
+
+        /// @brief Mark object as being in the remembered set of the garbage collector
+        void remember() { m_remembered = true; }
+
+        /// @brief Remove object from the remembered set. Objects that track which references were written while remembered should reset that here
+        virtual void forget() { m_remembered = false; }
+
+        /**
+         * @brief Mark every object that this object references. This should be overriden by every object that stores values
+         *
+         * @param gc Garbage collector that performs the collection
+         */
+        virtual void trace(GarbageCollector &gc);
+
+        /**
+         * @brief Mark objects that might have been stored in this object since it was added to the remembered set.
+         * Objects with a lot of references can override this to avoid marking every reference during minor collection
+         *
+         * @param gc Garbage collector that performs the collection
+         */
+        virtual void traceRemembered(GarbageCollector &gc) { trace(gc); }
         /**
          * @brief Get the next node in the list
          *
          * @return MemoryNode*
          */
         MemoryNode *getNext() { return m_next; }
+
+        /**
+         * @brief Get the previous node in the list
+         *
+         * @return MemoryNode*
+         */
+        MemoryNode *getPrev() { return m_prev; }
         /**
          * @brief Insert a new memory node after this one. Current child node will become child of the inserted node
          *
@@ -44,6 +119,12 @@ namespace GobLang
          */
         void eraseNext();
 
+        /**
+         * @brief Remove this node from the list it is in by connecting previous and next nodes together. Does not call any memory freeing functions
+         *
+         */
+        void unlink();
+
         /**
          * @brief Insert a node at the end of the chain
          *
@@ -51,18 +132,20 @@ namespace GobLang
          */
         void pushBack(MemoryNode *node);
 
-        void increaseRefCount();
-
-        void decreaseRefCount();
-
-        int32_t getRefCount() const { return m_refCount; }
-
         /// @brief Whether this object has been added to garbage collector
         /// @return true if  this object is being tracked by the garbage collector
-        bool isRegistered() const { return m_registered; }
+        bool isRegistered() const { return m_collector != nullptr; }
 
         /// @brief Mark object as registered with garbage collector
-        void registerGC() { m_registered = true; }
+        /// @param collector Garbage collector that handles this object
+        void registerGC(GarbageCollector *collector) { m_collector = collector; }
+
+        /// @brief Size of the memory block allocated for this object by the slab allocator or 0 if object was allocated using new
+        uint32_t getAllocationSize() const { return m_allocationSize; }
+
+        /// @brief Record that this object was placed in a memory block given by the slab allocator
+        /// @param size Size of the memory block
+        void setAllocationSize(uint32_t size) { m_allocationSize = size; }
 
         /// @brief Set value of the field if that field exists
         /// @param field Name of the field
@@ -74,6 +157,14 @@ namespace GobLang
         /// @return
         virtual Value getField(std::string const &field);
 
+        /// @brief Get structure that describes field layout of the object. Only structure objects declared in code have one
+        /// @return Structure that fields belong to or nullptr if fields are resolved by name
+        virtual Struct::Structure const *getStructure() const { return nullptr; }
+
+        /// @brief Get description of the native type that provides methods of the object
+        /// @return Native type or nullptr if object is not an instance of a native type
+        virtual Struct::NativeStructureInfo const *getNativeStructure() const { return nullptr; }
+
         /**
          * @brief Size of the memory chain
          *
@@ -100,25 +191,74 @@ namespace GobLang
 
         virtual ~MemoryNode();
 
+    protected:
+        /// @brief Create object of a given kind. Should be used by every object type that can be checked using node_cast
+        /// @param kind Kind of the object
+        explicit MemoryNode(MemoryNodeKind kind) : m_kind(kind) {}
+
+        /**
+         * @brief Write barrier that must be called whenever a value is stored in the object.
+         * Old objects that start referencing young objects are added to the remembered set so that minor collections would not have to scan the old generation.
+         * Objects stored in already marked objects are marked during incremental marking to avoid losing them
+         *
+         * @param value Value that is being stored
+         */
+        void _writeBarrier(Value const &value)
+        {
+            if ((m_old && !m_remembered) || m_marked)
+            {
+                _writeBarrierSlow(value);
+            }
+        }
+
     private:
+        /// @brief Part of the write barrier that notifies the garbage collector about the stored value
+        /// @param value Value that is being stored
+        void _writeBarrierSlow(Value const &value);
+
         /// @brief Next value in memory
         MemoryNode *m_next = nullptr;
-        /// @brief Is marked for deletion by garbage collector?
-        bool m_dead = false;
+        /// @brief Previous value in memory
+        MemoryNode *m_prev = nullptr;
+        /// @brief Was this object reached by the garbage collector during current collection
+        bool m_marked = false;
 
-        /// @brief How many references to this object exist. Once it zero object should be deleted
-        int32_t m_refCount = 0;
+        /// @brief Did this object survive a garbage collection
+        bool m_old = false;
+        /// @brief Is this object in the remembered set of the garbage collector
+        bool m_remembered = false;
+        /// @brief Kind of the object
+        MemoryNodeKind m_kind = MemoryNodeKind::Other;
+        /// @brief Size of the memory block allocated for this object by the slab allocator or 0 if object was allocated using new
+        uint32_t m_allocationSize = 0;
 
-        /// @brief if true then this object is handled by garbage collector, otherwise it has not yet been added to the list
-        bool m_registered = false;
-
-        /// @brief Descriptor of the fields that the object has
-        Struct::Structure const *m_struct = nullptr;
-
-        /// @brief Storage for the values that an object might have
-        std::vector<Value> m_fields;
-        /// @brief Name to id mapping of the fields used for access
-        std::map<std::string, size_t> m_fieldNames;
+        /// @brief Garbage collector that handles this object or nullptr if it has not yet been added to the list
+        GarbageCollector *m_collector = nullptr;
     };
 
-}
\ No newline at end of file
+
+    /**
+     * @brief Cast object to a given object type by comparing kind of the object, which is a replacement for dynamic_cast.
+     * Types derived from native structure object share the same kind so only they have to use dynamic_cast after the kind matches
+     *
+     * @tparam T Object type, which must declare the static `Kind` member
+     * @param node Object to cast
+     * @return T* Object or nullptr if object is null or is of a different type
+     */
+    template <class T>
+    T *node_cast(MemoryNode *node)
+    {
+        if (node == nullptr || node->getKind() != T::Kind)
+        {
+            return nullptr;
+        }
+        if constexpr (T::Kind == MemoryNodeKind::Native)
+        {
+            if constexpr (!std::is_same_v<T, typename T::NativeBase>)
+            {
+                return dynamic_cast<T *>(node);
+            }
+        }
+        return static_cast<T *>(node);
+    }
+}
@@ -17,12 +17,15 @@ namespace GobLang::Struct
     class NativeStructureObjectNode : public MemoryNode
     {
     public:
-        explicit NativeStructureObjectNode(
-            NativeStructureInfo const *info,
-            Structure const *baseInfo = nullptr) : MemoryNode(baseInfo), m_nativeStruct(info) {}
+        static constexpr MemoryNodeKind Kind = MemoryNodeKind::Native;
+        /// @brief Base of every native type, which can be cast to without checking the actual type
+        using NativeBase = NativeStructureObjectNode;
+
+        explicit NativeStructureObjectNode(NativeStructureInfo const *info) : MemoryNode(Kind), m_nativeStruct(info) {}
 
         Value getField(std::string const &field) override;
 
+        NativeStructureInfo const *getNativeStructure() const override { return m_nativeStruct; }
 
     private:
         NativeStructureInfo const *m_nativeStruct;
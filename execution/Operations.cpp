@@ -0,0 +1,144 @@
+#include "Operations.hpp"
+#include <algorithm>
+#include <string>
+#include "Exception.hpp"
+#include "Value.hpp"
+
+size_t GobLang::getArgumentSize(OperatorArgType type)
+{
+    switch (type)
+    {
+    case OperatorArgType::Char:
+    case OperatorArgType::Byte:
+        return 1;
+    case OperatorArgType::Address:
+        return sizeof(ProgramAddressType);
+    case OperatorArgType::Int:
+    case OperatorArgType::UnsignedInt:
+    case OperatorArgType::Float:
+        return sizeof(int32_t);
+    case OperatorArgType::FieldSlot:
+        return 1 + sizeof(uint16_t);
+    case OperatorArgType::LocalCall:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+GobLang::EncodedOperation GobLang::decodeOperation(std::vector<uint8_t> const &operations, size_t address)
+{
+    std::vector<OperationData>::const_iterator opIt = std::find_if(
+        Operations.begin(),
+        Operations.end(),
+        [&operations, address](OperationData const &a)
+        { return (uint8_t)a.op == operations[address]; });
+    if (opIt == Operations.end())
+    {
+        throw RuntimeException("Unknown operation at " + std::to_string(address));
+    }
+    EncodedOperation result{.op = opIt->op, .argSize = getArgumentSize(opIt->argType)};
+    if (address + result.argSize >= operations.size())
+    {
+        throw RuntimeException("Operation at " + std::to_string(address) + " is missing its arguments");
+    }
+    // arguments are stored in big endian, with the first byte of the two argument operations being an argument by itself
+    auto read = [&operations](size_t start, size_t size)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            value = (value << 8) | operations[start + i];
+        }
+        return value;
+    };
+    switch (opIt->argType)
+    {
+    case OperatorArgType::FieldSlot:
+    case OperatorArgType::LocalCall:
+        result.arg = operations[address + 1];
+        result.arg2 = read(address + 2, result.argSize - 1);
+        break;
+    default:
+        result.arg = read(address + 1, result.argSize);
+        break;
+    }
+    return result;
+}
+
+GobLang::StackEffect GobLang::getStackEffect(Operation op, uint32_t arg, uint32_t arg2)
+{
+    switch (op)
+    {
+    case Operation::Add:
+    case Operation::Sub:
+    case Operation::Mul:
+    case Operation::Div:
+    case Operation::Modulo:
+    case Operation::Equals:
+    case Operation::NotEq:
+    case Operation::Less:
+    case Operation::More:
+    case Operation::LessOrEq:
+    case Operation::MoreOrEq:
+    case Operation::And:
+    case Operation::Or:
+    case Operation::BitAnd:
+    case Operation::BitOr:
+    case Operation::BitXor:
+    case Operation::ShiftLeft:
+    case Operation::ShiftRight:
+    case Operation::GetField:
+        return StackEffect{.pops = 2, .minPushes = 1, .maxPushes = 1};
+    case Operation::Not:
+    case Operation::Negate:
+    case Operation::BitNot:
+    case Operation::GetFieldSlot:
+        return StackEffect{.pops = 1, .minPushes = 1, .maxPushes = 1};
+    // values that are not variable names or arrays are silently ignored, so unchecked execution checks the stack after them
+    case Operation::Get:
+        return StackEffect{.pops = 1, .minPushes = 1, .maxPushes = 1};
+    case Operation::GetArray:
+        return StackEffect{.pops = 2, .minPushes = 1, .maxPushes = 1};
+    case Operation::GetLocalFunction:
+    case Operation::GetGlobalSlot:
+    case Operation::GetLocal:
+    case Operation::PushConstInt:
+    case Operation::PushConstUnsignedInt:
+    case Operation::PushConstFloat:
+    case Operation::PushConstChar:
+    case Operation::PushConstString:
+    case Operation::PushTrue:
+    case Operation::PushFalse:
+    case Operation::PushNull:
+    case Operation::New:
+        return StackEffect{.pops = 0, .minPushes = 1, .maxPushes = 1};
+    case Operation::Set:
+    case Operation::SetFieldSlot:
+        return StackEffect{.pops = 2};
+    case Operation::SetArray:
+    case Operation::SetField:
+        return StackEffect{.pops = 3};
+    case Operation::SetGlobalSlot:
+    case Operation::SetLocal:
+    case Operation::JumpIf:
+    case Operation::JumpIfNot:
+    case Operation::ReturnValue:
+        return StackEffect{.pops = 1};
+    case Operation::CreateArray:
+        return StackEffect{.pops = arg, .minPushes = 1, .maxPushes = 1};
+    // functions pop their own arguments and methods receive the object as the last argument
+    case Operation::Call:
+        return StackEffect{.pops = 1, .maxPushes = 1, .call = true};
+    case Operation::CallLocal:
+        return StackEffect{.pops = arg2, .maxPushes = 1, .call = true};
+    case Operation::CallMethod:
+        return StackEffect{.pops = 2, .maxPushes = 2, .call = true};
+    case Operation::CallMethodSlot:
+        return StackEffect{.pops = 1, .maxPushes = 2, .call = true};
+    case Operation::Discard:
+        return StackEffect{.clear = true};
+    default:
+        return StackEffect{};
+    }
+}
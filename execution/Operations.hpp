@@ -2,9 +2,10 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 namespace GobLang
 {
-    enum class Operation
+    enum class Operation : uint8_t
     {
         None,
         Add,
@@ -17,8 +18,20 @@ namespace GobLang
          * @brief Call a function defined by the user
          */
         GetLocalFunction,
+        /**
+         * @brief Call a function defined by the user that is known at compile time, followed by the id of the function and the amount of arguments
+         */
+        CallLocal,
         Set,
         Get,
+        /**
+         * @brief Set value of the global variable using slot id of the variable
+         */
+        SetGlobalSlot,
+        /**
+         * @brief Get value of the global variable using slot id of the variable
+         */
+        GetGlobalSlot,
         GetLocal,
         SetLocal,
         /**
@@ -31,7 +44,20 @@ namespace GobLang
         SetArray,
         GetField,
         SetField,
+        /**
+         * @brief Get value of the field using field name id known at compile time, followed by the id of the inline cache that remembers the field slot
+         */
+        GetFieldSlot,
+        /**
+         * @brief Set value of the field using field name id known at compile time, followed by the id of the inline cache that remembers the field slot
+         */
+        SetFieldSlot,
         CallMethod,
+        /**
+         * @brief Call method of the object using method name id known at compile time, followed by the id of the inline cache that remembers the method.
+         * Methods of native types are called without getting the method as a value first
+         */
+        CallMethodSlot,
         PushConstInt,
         PushConstUnsignedInt,
         PushConstFloat,
@@ -87,7 +113,69 @@ namespace GobLang
         /**
          * @brief End program execution
          */
-        End
+        End,
+        /**
+         * @brief Remove every operand of the current frame, which discards the value of an expression statement.
+         * Calls leave either a single value or nothing, so the amount of values to remove is only known while running
+         */
+        Discard,
+        // Superinstructions that replace common sequences of operations when the code is decoded. They never appear in the byte code
+        /**
+         * @brief Add constant to the local variable, replaces `get N, push_int K, add, set N`
+         */
+        IncLocalByConst,
+        /**
+         * @brief Push sum of the local variable and a constant, replaces `get N, push_int K, add`
+         */
+        PushLocalAddConst,
+        /**
+         * @brief Push difference of the local variable and a constant, replaces `get N, push_int K, sub`
+         */
+        PushLocalSubConst,
+        /**
+         * @brief Jump unless local variable is less than a constant, replaces `get N, push_int K, less, jmp_by_if_not X`
+         */
+        JumpIfNotLessLocalConst,
+        /**
+         * @brief Jump unless local variable is less or equal to a constant, replaces `get N, push_int K, eqless, jmp_by_if_not X`
+         */
+        JumpIfNotLessOrEqLocalConst,
+        /**
+         * @brief Jump unless first local variable is less than the second one, replaces `get A, get B, less, jmp_by_if_not X`
+         */
+        JumpIfNotLessLocals,
+        /**
+         * @brief Get field of the object stored in the local variable, replaces `get N, get_field_slot`
+         */
+        GetLocalField,
+        /**
+         * @brief Set field of the object stored in the local variable, replaces `get N, set_field_slot`
+         */
+        SetLocalField,
+        // Quickened operations that generic arithmetic and comparison operations are rewritten into after they are executed with operands of the same type.
+        // If operands have any other type they are rewritten back into the generic operation. They never appear in the byte code
+        AddInt,
+        AddUnsignedInt,
+        AddFloat,
+        /// @brief Concatenate two strings
+        AddString,
+        SubInt,
+        SubUnsignedInt,
+        SubFloat,
+        MulInt,
+        MulUnsignedInt,
+        MulFloat,
+        DivInt,
+        DivUnsignedInt,
+        DivFloat,
+        LessInt,
+        LessFloat,
+        MoreInt,
+        MoreFloat,
+        LessOrEqInt,
+        LessOrEqFloat,
+        MoreOrEqInt,
+        MoreOrEqFloat
     };
 
     enum class OperatorArgType
@@ -98,7 +186,11 @@ namespace GobLang
         Address,
         Int,
         UnsignedInt,
-        Float
+        Float,
+        /// @brief Byte sized field name id followed by two byte inline cache id
+        FieldSlot,
+        /// @brief Byte sized function id followed by byte sized amount of arguments
+        LocalCall
     };
 
     struct OperationData
@@ -108,6 +200,63 @@ namespace GobLang
         OperatorArgType argType;
     };
 
+    /**
+     * @brief Operation read from the byte code together with its arguments
+     *
+     */
+    struct EncodedOperation
+    {
+        Operation op;
+        /// @brief Amount of bytes taken by the arguments, which follow the operation byte
+        size_t argSize = 0;
+        /// @brief Whole argument, or field name id and function id for operations with two arguments
+        uint32_t arg = 0;
+        /// @brief Inline cache id or amount of arguments for operations with two arguments
+        uint32_t arg2 = 0;
+    };
+
+    /// @brief How the operation changes the operand stack
+    struct StackEffect
+    {
+        size_t pops = 0;
+        /// @brief Values that are always pushed, unless operation throws
+        size_t minPushes = 0;
+        /// @brief Values that can be pushed at most, with calls assumed to leave at most one value
+        size_t maxPushes = 0;
+        /// @brief Whether the operation calls something that can leave any amount of values, so operands after it are not known
+        bool call = false;
+        /// @brief Whether the operation removes every operand of the frame, so the stack is empty after it
+        bool clear = false;
+    };
+
+    /**
+     * @brief Get how the operation of the byte code changes the operand stack
+     *
+     * @param op Operation
+     * @param arg First argument of the operation
+     * @param arg2 Second argument of the operation
+     * @return StackEffect Values popped and pushed by the operation
+     */
+    StackEffect getStackEffect(Operation op, uint32_t arg, uint32_t arg2);
+
+    /**
+     * @brief Get how many bytes the arguments of the given type take in the byte code
+     *
+     * @param type Type of the arguments
+     * @return size_t Size of the arguments in bytes
+     */
+    size_t getArgumentSize(OperatorArgType type);
+
+    /**
+     * @brief Read the operation at the given address and its big endian arguments.
+     * Throws `RuntimeException` if the byte is not a known operation or the arguments don't fit into the byte code
+     *
+     * @param operations Byte code to read from
+     * @param address Address of the operation
+     * @return EncodedOperation Operation with its arguments
+     */
+    EncodedOperation decodeOperation(std::vector<uint8_t> const &operations, size_t address);
+
     static const std::vector<OperationData> Operations = {
         OperationData{.op = Operation::None, .text = "noop", .argType = OperatorArgType::None},
         OperationData{.op = Operation::BitAnd, .text = "bit_and", .argType = OperatorArgType::None},
@@ -123,16 +272,22 @@ namespace GobLang
         OperationData{.op = Operation::Modulo, .text = "mod", .argType = OperatorArgType::None},
         OperationData{.op = Operation::Call, .text = "call", .argType = OperatorArgType::None},
         OperationData{.op = Operation::GetLocalFunction, .text = "get_local_func", .argType = OperatorArgType::Byte},
+        OperationData{.op = Operation::CallLocal, .text = "call_local", .argType = OperatorArgType::LocalCall},
         OperationData{.op = Operation::CreateArray, .text = "create_array", .argType = OperatorArgType::Byte},
         OperationData{.op = Operation::Set, .text = "set_global", .argType = OperatorArgType::None},
         OperationData{.op = Operation::Get, .text = "get_global", .argType = OperatorArgType::None},
+        OperationData{.op = Operation::SetGlobalSlot, .text = "set_global_slot", .argType = OperatorArgType::Byte},
+        OperationData{.op = Operation::GetGlobalSlot, .text = "get_global_slot", .argType = OperatorArgType::Byte},
         OperationData{.op = Operation::SetLocal, .text = "set", .argType = OperatorArgType::Byte},
         OperationData{.op = Operation::GetLocal, .text = "get", .argType = OperatorArgType::Byte},
         OperationData{.op = Operation::SetArray, .text = "set_arr", .argType = OperatorArgType::None},
         OperationData{.op = Operation::GetArray, .text = "get_arr", .argType = OperatorArgType::None},
         OperationData{.op = Operation::SetField, .text = "set_field", .argType = OperatorArgType::None},
         OperationData{.op = Operation::GetField, .text = "get_field", .argType = OperatorArgType::None},
+        OperationData{.op = Operation::SetFieldSlot, .text = "set_field_slot", .argType = OperatorArgType::FieldSlot},
+        OperationData{.op = Operation::GetFieldSlot, .text = "get_field_slot", .argType = OperatorArgType::FieldSlot},
         OperationData{.op = Operation::CallMethod, .text = "call_method", .argType = OperatorArgType::None},
+        OperationData{.op = Operation::CallMethodSlot, .text = "call_method_slot", .argType = OperatorArgType::FieldSlot},
         OperationData{.op = Operation::PushConstInt, .text = "push_int", .argType = OperatorArgType::Int},
         OperationData{.op = Operation::PushConstUnsignedInt, .text = "push_uint", .argType = OperatorArgType::UnsignedInt},
         OperationData{.op = Operation::PushConstFloat, .text = "push_float", .argType = OperatorArgType::Float},
@@ -160,5 +315,6 @@ namespace GobLang
         OperationData{.op = Operation::ReturnValue, .text = "ret_val", .argType = OperatorArgType::None},
         OperationData{.op = Operation::New, .text = "new", .argType = OperatorArgType::Byte},
         OperationData{.op = Operation::End, .text = "hlt", .argType = OperatorArgType::None},
+        OperationData{.op = Operation::Discard, .text = "discard", .argType = OperatorArgType::None},
     };
 } // namespace SimpleLang
@@ -0,0 +1,72 @@
+#include "SlabAllocator.hpp"
+#include <new>
+#include <algorithm>
+
+GobLang::SlabAllocator::SlabAllocator()
+{
+    for (size_t i = 0; i < SizeClassCount; i++)
+    {
+        m_classes[i].counters.slotSize = (i + 1) * Alignment;
+    }
+}
+
+void *GobLang::SlabAllocator::allocate(size_t size)
+{
+    if (size == 0)
+    {
+        size = 1;
+    }
+    if (!isSlabAllocated(size))
+    {
+        m_largeAllocations++;
+        m_liveLargeObjects++;
+        return ::operator new(size, std::align_val_t(Alignment));
+    }
+    SizeClass &sizeClass = m_classes[_getSizeClass(size)];
+    void *slot = nullptr;
+    if (sizeClass.freeList != nullptr)
+    {
+        slot = sizeClass.freeList;
+        sizeClass.freeList = sizeClass.freeList->next;
+    }
+    else
+    {
+        if (sizeClass.current == nullptr || sizeClass.current + sizeClass.counters.slotSize > sizeClass.end)
+        {
+            _addSlab(sizeClass);
+        }
+        slot = sizeClass.current;
+        sizeClass.current += sizeClass.counters.slotSize;
+    }
+    sizeClass.counters.allocations++;
+    sizeClass.counters.liveObjects++;
+    sizeClass.counters.peakObjects = std::max(sizeClass.counters.peakObjects, sizeClass.counters.liveObjects);
+    return slot;
+}
+
+void GobLang::SlabAllocator::deallocate(void *ptr, size_t size)
+{
+    if (size == 0)
+    {
+        size = 1;
+    }
+    if (!isSlabAllocated(size))
+    {
+        m_liveLargeObjects--;
+        ::operator delete(ptr, std::align_val_t(Alignment));
+        return;
+    }
+    SizeClass &sizeClass = m_classes[_getSizeClass(size)];
+    sizeClass.freeList = new (ptr) FreeSlot{.next = sizeClass.freeList};
+    sizeClass.counters.liveObjects--;
+}
+
+void GobLang::SlabAllocator::_addSlab(SizeClass &sizeClass)
+{
+    // memory returned by new[] is aligned for any fundamental type, which is what Alignment is
+    static_assert(Alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+    m_slabs.push_back(std::make_unique_for_overwrite<std::byte[]>(SLAB_SIZE));
+    sizeClass.current = m_slabs.back().get();
+    sizeClass.end = sizeClass.current + SLAB_SIZE;
+    sizeClass.counters.slabCount++;
+}
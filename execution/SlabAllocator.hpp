@@ -0,0 +1,120 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace GobLang
+{
+    /**
+     * @brief Pool allocator that hands out memory for objects from large slabs, grouped into size classes.
+     *
+     * Every size class has its own slabs and a list of freed slots that are reused before taking more memory from the slab.
+     * Memory is only returned to the system once the allocator is destroyed, which frees every slab at once.
+     * Requests that are larger than the largest size class are forwarded to the global operator new
+     *
+     */
+    class SlabAllocator
+    {
+    public:
+        /// @brief Alignment of every slot, which is also the difference in size between neighbouring size classes
+        static constexpr size_t Alignment = 16;
+        /// @brief Amount of size classes. Largest slot that can be allocated from a slab is `Alignment * SizeClassCount` bytes
+        static constexpr size_t SizeClassCount = 32;
+
+        /**
+         * @brief Allocation statistics of a single size class
+         *
+         */
+        struct SizeClassCounters
+        {
+            /// @brief Size of every slot in this class
+            size_t slotSize = 0;
+            /// @brief How many slabs were allocated for this class
+            size_t slabCount = 0;
+            /// @brief How many slots are currently in use
+            size_t liveObjects = 0;
+            /// @brief Highest amount of slots that were in use at the same time
+            size_t peakObjects = 0;
+            /// @brief How many allocations were done in total
+            size_t allocations = 0;
+        };
+
+        explicit SlabAllocator();
+
+        SlabAllocator(SlabAllocator const &) = delete;
+        SlabAllocator &operator=(SlabAllocator const &) = delete;
+
+        /**
+         * @brief Allocate memory block of the given size
+         *
+         * @param size Size of the block in bytes
+         * @return void* Block aligned to `Alignment`
+         */
+        void *allocate(size_t size);
+
+        /**
+         * @brief Return memory block to the allocator so that it could be reused
+         *
+         * @param ptr Block that was returned by allocate
+         * @param size Size that was used to allocate the block
+         */
+        void deallocate(void *ptr, size_t size);
+
+        /**
+         * @brief Get statistics of the size class
+         *
+         * @param i Id of the size class, where class `i` holds objects of up to `(i + 1) * Alignment` bytes
+         * @return SizeClassCounters const& Statistics
+         */
+        SizeClassCounters const &getSizeClassCounters(size_t i) const { return m_classes[i].counters; }
+
+        /// @brief How many allocations were too large for any size class
+        size_t getLargeAllocationCount() const { return m_largeAllocations; }
+
+        /// @brief How many allocations that were too large for any size class are currently alive
+        size_t getLiveLargeObjectCount() const { return m_liveLargeObjects; }
+
+        /// @brief Whether blocks of the given size are taken from slabs, instead of being allocated using operator new
+        static constexpr bool isSlabAllocated(size_t size) { return size <= SizeClassCount * Alignment; }
+
+        /// @brief Total amount of slabs owned by the allocator
+        size_t getSlabCount() const { return m_slabs.size(); }
+
+        /// @brief Size of every slab in bytes
+        static constexpr size_t getSlabSize() { return SLAB_SIZE; }
+
+        ~SlabAllocator() = default;
+
+    private:
+        /// @brief Freed slot that stores pointer to the next freed slot of the same size class
+        struct FreeSlot
+        {
+            FreeSlot *next;
+        };
+
+        struct SizeClass
+        {
+            /// @brief Slots that were freed and can be reused
+            FreeSlot *freeList = nullptr;
+            /// @brief Start of the unused part of the latest slab
+            std::byte *current = nullptr;
+            /// @brief End of the latest slab
+            std::byte *end = nullptr;
+            SizeClassCounters counters;
+        };
+
+        /// @brief Get id of the size class that can fit objects of given size
+        static constexpr size_t _getSizeClass(size_t size) { return (size + Alignment - 1) / Alignment - 1; }
+
+        /// @brief Allocate a new slab for the size class and make it the current one
+        /// @param sizeClass Size class that needs more memory
+        void _addSlab(SizeClass &sizeClass);
+
+        std::array<SizeClass, SizeClassCount> m_classes;
+        std::vector<std::unique_ptr<std::byte[]>> m_slabs;
+        size_t m_largeAllocations = 0;
+        size_t m_liveLargeObjects = 0;
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Holes of the stencils as pairs of the name of the hole and the symbol that stencils use to read it.
+ * Every hole is a 64 bit value that is written into the code once it is known
+ *
+ */
+#define GOB_LANG_STENCIL_VALUE_HOLES(X)                  \
+    X(Pc, gob_hole_pc)                                   \
+    X(Arg, gob_hole_arg)                                 \
+    X(Arg2, gob_hole_arg2)                               \
+    X(Arg3, gob_hole_arg3)                               \
+    X(Helper, gob_hole_helper)                           \
+    X(StackBegin, gob_hole_stack_begin)                  \
+    X(StackEnd, gob_hole_stack_end)                      \
+    X(StackCapacity, gob_hole_stack_capacity)            \
+    X(FrameBase, gob_hole_frame_base)                    \
+    X(FrameLocalCount, gob_hole_frame_local_count)       \
+    X(FrameLocalCapacity, gob_hole_frame_local_capacity) \
+    X(IntBits, gob_hole_int_bits)                        \
+    X(FalseBits, gob_hole_false_bits)                    \
+    X(TrueBits, gob_hole_true_bits)
+
+/**
+ * @brief Holes of the stencils that are 32 bit offsets of jumps, as pairs of the name of the hole and the function that stencils tail call
+ *
+ */
+#define GOB_LANG_STENCIL_JUMP_HOLES(X) \
+    X(Continue, gob_continue)          \
+    X(Branch, gob_branch)
+
+namespace GobLang::Jit
+{
+    /// @brief What has to be written into the hole of the stencil
+    enum class HoleKind : uint8_t
+    {
+#define GOB_LANG_STENCIL_HOLE_KIND(name, symbol) name,
+        GOB_LANG_STENCIL_VALUE_HOLES(GOB_LANG_STENCIL_HOLE_KIND)
+        GOB_LANG_STENCIL_JUMP_HOLES(GOB_LANG_STENCIL_HOLE_KIND)
+#undef GOB_LANG_STENCIL_HOLE_KIND
+    };
+
+    /// @brief Place in the code of the stencil that has to be patched
+    struct Hole
+    {
+        /// @brief Offset of the hole from the start of the stencil
+        uint32_t offset;
+        HoleKind kind;
+        /// @brief Value added to the value of the hole, for jumps it also accounts for the offset being relative to the end of the instruction
+        int64_t addend;
+    };
+
+    /**
+     * @brief Machine code of a single instruction extracted from the compiled stencils.
+     * Code can be copied anywhere in memory once every hole is patched
+     *
+     */
+    struct Stencil
+    {
+        uint8_t const *code;
+        size_t size;
+        Hole const *holes;
+        size_t holeCount;
+        /// @brief Whether the stencil ends with a jump to the next instruction, which can be left out if the next instruction is placed right after it
+        bool continuesAtEnd;
+    };
+}
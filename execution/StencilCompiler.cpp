@@ -0,0 +1,283 @@
+#include "Jit.hpp"
+#include <map>
+#include <cstring>
+#if defined(GOB_LANG_JIT_AVAILABLE) && defined(GOB_LANG_JIT_STENCILS)
+#include "Stencil.hpp"
+#include "GeneratedStencils.hpp"
+
+namespace
+{
+    /// @brief Size of `jmp rel32`
+    constexpr size_t JumpSize = 5;
+
+    /**
+     * @brief Part of the compiled code, which is either a copy of a stencil or a jump
+     *
+     */
+    struct Piece
+    {
+        /// @brief Stencil to copy or nullptr for a jump to `branch`
+        GobLang::Jit::Stencil const *stencil;
+        GobLang::Jit::OperationHelper helper = nullptr;
+        uint32_t pc = 0;
+        uint32_t arg = 0;
+        uint32_t arg2 = 0;
+        uint32_t arg3 = 0;
+        /// @brief Piece that runs after this one, which is always the piece placed right after it
+        size_t next = 0;
+        /// @brief Index of the instruction to jump to, which is turned into a piece once every instruction has one
+        size_t target = 0;
+        /// @brief Piece to jump to
+        size_t branch = 0;
+        /// @brief Position of the piece in the code
+        size_t position = 0;
+        size_t size = 0;
+    };
+
+    /// @brief Get the stencil that performs the instruction
+    GobLang::Jit::Stencil const *getStencil(
+        GobLang::Jit::JitInstruction const &instruction,
+        GobLang::Jit::OperationHelper bailout,
+        GobLang::Jit::MachineLayout const &layout)
+    {
+        using GobLang::Operation;
+        namespace Stencils = GobLang::Jit::Stencils;
+        bool hasTarget = instruction.target.has_value();
+        if (layout.valid && instruction.helper != bailout)
+        {
+            switch (instruction.op)
+            {
+            case Operation::PushConstInt:
+                return &Stencils::PushConstInt;
+            case Operation::PushTrue:
+                return &Stencils::PushTrue;
+            case Operation::PushFalse:
+                return &Stencils::PushFalse;
+            case Operation::GetLocal:
+                return &Stencils::GetLocal;
+            case Operation::SetLocal:
+                return &Stencils::SetLocal;
+            case Operation::AddInt:
+                return &Stencils::AddInt;
+            case Operation::SubInt:
+                return &Stencils::SubInt;
+            case Operation::MulInt:
+                return &Stencils::MulInt;
+            case Operation::LessInt:
+                return &Stencils::LessInt;
+            case Operation::MoreInt:
+                return &Stencils::MoreInt;
+            case Operation::LessOrEqInt:
+                return &Stencils::LessOrEqInt;
+            case Operation::MoreOrEqInt:
+                return &Stencils::MoreOrEqInt;
+            case Operation::IncLocalByConst:
+                return &Stencils::IncLocalByConst;
+            case Operation::PushLocalAddConst:
+                return &Stencils::PushLocalAddConst;
+            case Operation::PushLocalSubConst:
+                return &Stencils::PushLocalSubConst;
+            case Operation::JumpIfNot:
+                return hasTarget ? &Stencils::JumpIfNot : &Stencils::CallHelper;
+            case Operation::JumpIf:
+                return hasTarget ? &Stencils::JumpIf : &Stencils::CallHelper;
+            case Operation::JumpIfNotLessLocalConst:
+                return hasTarget ? &Stencils::JumpIfNotLessLocalConst : &Stencils::CallHelper;
+            case Operation::JumpIfNotLessOrEqLocalConst:
+                return hasTarget ? &Stencils::JumpIfNotLessOrEqLocalConst : &Stencils::CallHelper;
+            case Operation::JumpIfNotLessLocals:
+                return hasTarget ? &Stencils::JumpIfNotLessLocals : &Stencils::CallHelper;
+            default:
+                break;
+            }
+        }
+        return hasTarget ? &Stencils::CallBranchingHelper : &Stencils::CallHelper;
+    }
+
+    /// @brief Get the value that is written into the hole of the piece
+    uint64_t getHoleValue(Piece const &piece, GobLang::Jit::HoleKind kind, GobLang::Jit::MachineLayout const &layout)
+    {
+        using GobLang::Jit::HoleKind;
+        switch (kind)
+        {
+        case HoleKind::Pc:
+            return piece.pc;
+        case HoleKind::Arg:
+            return piece.arg;
+        case HoleKind::Arg2:
+            return piece.arg2;
+        case HoleKind::Arg3:
+            return piece.arg3;
+        case HoleKind::Helper:
+            return reinterpret_cast<uint64_t>(piece.helper);
+        case HoleKind::StackBegin:
+            return (uint64_t)(int64_t)layout.stackBegin;
+        case HoleKind::StackEnd:
+            return (uint64_t)(int64_t)layout.stackEnd;
+        case HoleKind::StackCapacity:
+            return (uint64_t)(int64_t)layout.stackCapacity;
+        case HoleKind::FrameBase:
+            return (uint64_t)(int64_t)layout.frameBase;
+        case HoleKind::FrameLocalCount:
+            return (uint64_t)(int64_t)layout.frameLocalCount;
+        case HoleKind::FrameLocalCapacity:
+            return (uint64_t)(int64_t)layout.frameLocalCapacity;
+        case HoleKind::IntBits:
+            return layout.intBits;
+        case HoleKind::FalseBits:
+            return layout.falseBits;
+        case HoleKind::TrueBits:
+            return layout.trueBits;
+        default:
+            return 0;
+        }
+    }
+
+    /// @brief Write offset of the jump at `position` that goes to `destination`, which is relative to `position` moved by `addend`
+    bool patchJump(std::vector<uint8_t> &code, size_t position, size_t destination, int64_t addend)
+    {
+        int64_t offset = (int64_t)destination + addend - (int64_t)position;
+        if (offset < INT32_MIN || offset > INT32_MAX)
+        {
+            return false;
+        }
+        int32_t offset32 = (int32_t)offset;
+        std::memcpy(code.data() + position, &offset32, sizeof(offset32));
+        return true;
+    }
+} // namespace
+#endif
+
+std::unique_ptr<GobLang::Jit::CompiledCode> GobLang::Jit::CompiledCode::compileWithStencils(
+    std::vector<JitInstruction> const &instructions,
+    size_t entry,
+    OperationHelper bailout,
+    MachineLayout const &layout)
+{
+#if defined(GOB_LANG_JIT_AVAILABLE) && defined(GOB_LANG_JIT_STENCILS)
+    if (instructions.empty())
+    {
+        return nullptr;
+    }
+    // stencils are plain functions that receive the machine as their argument, so the first piece is the entry point of the code
+    // and there is no need for a prologue
+    std::vector<Piece> pieces;
+    // pieces that jump to instructions, which get their destination once every instruction has a piece
+    std::vector<size_t> jumps;
+    if (instructions.front().index != entry)
+    {
+        jumps.push_back(pieces.size());
+        pieces.push_back(Piece{.stencil = nullptr, .target = entry});
+    }
+    std::map<size_t, size_t> instructionPieces;
+    for (size_t i = 0; i < instructions.size(); i++)
+    {
+        JitInstruction const &instruction = instructions[i];
+        instructionPieces[instruction.index] = pieces.size();
+        if (instruction.helper == nullptr)
+        {
+            if (!instruction.target.has_value())
+            {
+                return nullptr;
+            }
+            jumps.push_back(pieces.size());
+            pieces.push_back(Piece{.stencil = nullptr, .target = instruction.target.value()});
+            continue;
+        }
+        if (instruction.target.has_value())
+        {
+            jumps.push_back(pieces.size());
+        }
+        pieces.push_back(Piece{
+            .stencil = getStencil(instruction, bailout, layout),
+            .helper = instruction.helper,
+            .pc = (uint32_t)instruction.index,
+            .arg = instruction.arg,
+            .arg2 = instruction.arg2,
+            .arg3 = instruction.arg3,
+            .next = pieces.size() + 1,
+            .target = instruction.target.value_or(0)});
+        // instructions are sorted, so if the next instruction is not placed right after this one it was not compiled
+        // and the interpreter has to continue from it
+        size_t next = instruction.index + 1;
+        if (i + 1 == instructions.size() || instructions[i + 1].index != next)
+        {
+            pieces.push_back(Piece{.stencil = &Stencils::CallHelper, .helper = bailout, .pc = (uint32_t)next, .next = pieces.size()});
+        }
+    }
+    // jumps to instructions that were not compiled go to exits that let the interpreter continue from the target
+    std::map<size_t, size_t> exits;
+    for (size_t jump : jumps)
+    {
+        size_t target = pieces[jump].target;
+        if (std::map<size_t, size_t>::iterator it = instructionPieces.find(target); it != instructionPieces.end())
+        {
+            pieces[jump].branch = it->second;
+            continue;
+        }
+        if (!exits.contains(target))
+        {
+            exits[target] = pieces.size();
+            pieces.push_back(Piece{.stencil = &Stencils::CallHelper, .helper = bailout, .pc = (uint32_t)target, .next = pieces.size()});
+        }
+        pieces[jump].branch = exits[target];
+    }
+
+    size_t size = 0;
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        Piece &piece = pieces[i];
+        piece.position = size;
+        if (piece.stencil == nullptr)
+        {
+            piece.size = JumpSize;
+        }
+        else
+        {
+            // jump to the next piece is not needed when the next piece is right after it
+            bool fallsThrough = piece.stencil->continuesAtEnd && piece.next == i + 1;
+            piece.size = piece.stencil->size - (fallsThrough ? JumpSize : 0);
+        }
+        size += piece.size;
+    }
+    std::vector<uint8_t> code(size);
+    for (Piece const &piece : pieces)
+    {
+        if (piece.stencil == nullptr)
+        {
+            // jmp rel32
+            code[piece.position] = 0xE9;
+            if (!patchJump(code, piece.position + 1, pieces[piece.branch].position, -(int64_t)sizeof(int32_t)))
+            {
+                return nullptr;
+            }
+            continue;
+        }
+        std::memcpy(code.data() + piece.position, piece.stencil->code, piece.size);
+        for (size_t i = 0; i < piece.stencil->holeCount; i++)
+        {
+            Hole const &hole = piece.stencil->holes[i];
+            size_t position = piece.position + hole.offset;
+            if (hole.offset >= piece.size)
+            {
+                // jump at the end was left out
+                continue;
+            }
+            if (hole.kind == HoleKind::Continue || hole.kind == HoleKind::Branch)
+            {
+                size_t destination = pieces[hole.kind == HoleKind::Continue ? piece.next : piece.branch].position;
+                if (!patchJump(code, position, destination, hole.addend))
+                {
+                    return nullptr;
+                }
+                continue;
+            }
+            uint64_t value = getHoleValue(piece, hole.kind, layout) + (uint64_t)hole.addend;
+            std::memcpy(code.data() + position, &value, sizeof(value));
+        }
+    }
+    return _createExecutable(code);
+#else
+    return nullptr;
+#endif
+}
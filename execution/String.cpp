@@ -22,7 +22,7 @@ void GobLang::StringNode::setCharAt(char ch, size_t ind)
 
 bool GobLang::StringNode::equalsTo(MemoryNode *other)
 {
-    if (StringNode *otherStr = dynamic_cast<StringNode *>(other); otherStr != nullptr)
+    if (StringNode *otherStr = node_cast<StringNode>(other); otherStr != nullptr)
     {
         return otherStr->getString() == getString();
     }
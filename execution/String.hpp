@@ -8,7 +8,9 @@ namespace GobLang
     class StringNode : public MemoryNode
     {
     public:
-        explicit StringNode(std::string const &str) : m_str(str) {}
+        static constexpr MemoryNodeKind Kind = MemoryNodeKind::String;
+
+        explicit StringNode(std::string const &str) : MemoryNode(Kind), m_str(str) {}
 
         std::string const &getString() { return m_str; }
 
@@ -29,9 +31,28 @@ namespace GobLang
 
         size_t getSize() const { return m_str.size(); }
 
+        /// @brief Strings do not reference any other objects so there is nothing to trace
+        void trace([[maybe_unused]] GarbageCollector &gc) override {}
+
+        /// @brief Whether this string is stored in the interned string table of the machine
+        bool isInterned() const { return m_interned; }
+
+        /// @brief Hash of the string contents at the moment it was interned. Used to find the entry in the intern table
+        size_t getInternHash() const { return m_internHash; }
+
+        /// @brief Mark this string as stored in the intern table under a given hash
+        /// @param hash Hash of the contents
+        void markInterned(size_t hash)
+        {
+            m_interned = true;
+            m_internHash = hash;
+        }
+
         virtual ~StringNode() = default;
 
     private:
         std::string m_str;
+        bool m_interned = false;
+        size_t m_internHash = 0;
     };
 } // namespace GobLang
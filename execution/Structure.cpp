@@ -0,0 +1,10 @@
+#include "Structure.hpp"
+
+void GobLang::Struct::Structure::updateFieldIds()
+{
+    fieldIds.clear();
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        fieldIds[fields[i].name] = i;
+    }
+}
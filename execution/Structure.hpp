@@ -33,5 +33,10 @@ namespace GobLang::Struct
     {
         std::string name;
         std::vector<Field> fields;
+        /// @brief Name to id mapping of the fields, shared by every object of this type. Has to be rebuilt with `updateFieldIds` after fields are changed
+        std::map<std::string, size_t> fieldIds;
+
+        /// @brief Rebuild name to id mapping of the fields
+        void updateFieldIds();
     };
 }
\ No newline at end of file
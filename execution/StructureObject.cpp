@@ -0,0 +1,66 @@
+#include "StructureObject.hpp"
+#include "Exception.hpp"
+#include "GarbageCollector.hpp"
+
+GobLang::Struct::StructureObjectNode::StructureObjectNode(Structure const *type) : MemoryNode(Kind), m_type(type)
+{
+    static_assert(sizeof(StructureObjectNode) % alignof(Value) == 0, "Fields stored after the object must be aligned");
+    Value *fields = _getFields();
+    for (size_t i = 0; i < m_type->fields.size(); i++)
+    {
+        new (fields + i) Value(nullptr);
+    }
+}
+
+void GobLang::Struct::StructureObjectNode::setField(std::string const &field, Value const &value)
+{
+    size_t id = _getFieldId(field);
+    _writeBarrier(value);
+    _getFields()[id] = value;
+}
+
+GobLang::Value GobLang::Struct::StructureObjectNode::getField(std::string const &field)
+{
+    return _getFields()[_getFieldId(field)];
+}
+
+void GobLang::Struct::StructureObjectNode::trace(GarbageCollector &gc)
+{
+    Value *fields = _getFields();
+    for (size_t i = 0; i < m_type->fields.size(); i++)
+    {
+        gc.markValue(fields[i]);
+    }
+}
+
+std::string GobLang::Struct::StructureObjectNode::toString(bool pretty, size_t depth)
+{
+    std::string start = "{";
+    Value *fields = _getFields();
+    for (size_t i = 0; i < m_type->fields.size(); i++)
+    {
+        start += m_type->fields[i].name + "=" + valueToString(fields[i], pretty, depth);
+
+        start += (i + 1 == m_type->fields.size()) ? "}" : ",";
+    }
+    return start;
+}
+
+GobLang::Struct::StructureObjectNode::~StructureObjectNode()
+{
+    Value *fields = _getFields();
+    for (size_t i = 0; i < m_type->fields.size(); i++)
+    {
+        fields[i].~Value();
+    }
+}
+
+size_t GobLang::Struct::StructureObjectNode::_getFieldId(std::string const &field) const
+{
+    std::map<std::string, size_t>::const_iterator it = m_type->fieldIds.find(field);
+    if (it == m_type->fieldIds.end())
+    {
+        throw RuntimeException(std::string("Invalid field name ") + field);
+    }
+    return it->second;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Memory.hpp"
+#include "Structure.hpp"
+
+namespace GobLang::Struct
+{
+    /**
+     * @brief Instance of a structure declared in code. Values of the fields are stored right after the object in the same memory block,
+     * while names of the fields are stored once in the structure
+     *
+     * Because fields are stored after the object it must only be created using `Machine::allocateWithExtraSize` with `getFieldStorageSize` as the extra size
+     *
+     */
+    class StructureObjectNode : public MemoryNode
+    {
+    public:
+        static constexpr MemoryNodeKind Kind = MemoryNodeKind::Struct;
+
+        explicit StructureObjectNode(Structure const *type);
+
+        /**
+         * @brief Get how many bytes have to be allocated after the object to store the fields of the given structure
+         *
+         * @param type Structure of the object
+         * @return size_t Size of the storage in bytes
+         */
+        static size_t getFieldStorageSize(Structure const *type) { return type->fields.size() * sizeof(Value); }
+
+        void setField(std::string const &field, Value const &value) override;
+
+        Value getField(std::string const &field) override;
+
+        void trace(GarbageCollector &gc) override;
+
+        std::string toString(bool pretty = false, size_t depth = 0) override;
+
+        Structure const *getType() const { return m_type; }
+
+        Structure const *getStructure() const override { return m_type; }
+
+        /// @brief Get value of the field using id of the field in the structure
+        /// @param id Id of the field, which must be less than amount of fields
+        Value const &getFieldById(size_t id) { return _getFields()[id]; }
+
+        /// @brief Set value of the field using id of the field in the structure
+        /// @param id Id of the field, which must be less than amount of fields
+        /// @param value Value to assign
+        void setFieldById(size_t id, Value const &value)
+        {
+            _writeBarrier(value);
+            _getFields()[id] = value;
+        }
+
+        ~StructureObjectNode();
+
+    private:
+        /// @brief Get pointer to the first field stored after the object
+        Value *_getFields() { return std::launder(reinterpret_cast<Value *>(reinterpret_cast<std::byte *>(this) + sizeof(StructureObjectNode))); }
+
+        /**
+         * @brief Get id of the field with a given name
+         *
+         * @param field Name of the field
+         * @return size_t Id of the field
+         */
+        size_t _getFieldId(std::string const &field) const;
+
+        Structure const *m_type;
+    };
+}
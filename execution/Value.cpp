@@ -3,26 +3,26 @@
 #include <iostream>
 bool GobLang::areEqual(Value const &a, Value const &b)
 {
-    if (a.index() != b.index())
+    if (a.getType() != b.getType())
     {
         return false;
     }
-    switch ((Type)a.index())
+    switch (a.getType())
     {
     case Type::Null:
         return true;
     case Type::Bool:
-        return std::get<bool>(a) == std::get<bool>(b);
+        return a.as<bool>() == b.as<bool>();
     case Type::Float:
-        return std::get<float>(a) == std::get<float>(b);
+        return a.as<float>() == b.as<float>();
     case Type::Int:
-        return std::get<int32_t>(a) == std::get<int32_t>(b);
+        return a.as<int32_t>() == b.as<int32_t>();
     case Type::UnsignedInt:
-        return std::get<uint32_t>(a) == std::get<uint32_t>(b);
+        return a.as<uint32_t>() == b.as<uint32_t>();
     case Type::Char:
-        return std::get<char>(a) == std::get<char>(b);
+        return a.as<char>() == b.as<char>();
     case Type::MemoryObj:
-        return std::get<MemoryNode *>(a)->equalsTo(std::get<MemoryNode *>(b));
+        return a.as<MemoryNode *>()->equalsTo(b.as<MemoryNode *>());
     case Type::NativeFunction:
         // c++ has no equality check for std::function
         return false;
@@ -36,22 +36,22 @@ std::string GobLang::valueToString(Value const &val, bool pretty, size_t depth)
     {
         return "...";
     }
-    switch ((Type)val.index())
+    switch (val.getType())
     {
     case Type::Null:
         return "null";
     case Type::Bool:
-        return std::get<bool>(val) ? "true" : "false";
+        return val.as<bool>() ? "true" : "false";
     case Type::Float:
-        return std::to_string(std::get<float>(val));
+        return std::to_string(val.as<float>());
     case Type::Int:
-        return std::to_string(std::get<int32_t>(val));
+        return std::to_string(val.as<int32_t>());
     case Type::UnsignedInt:
-        return std::to_string(std::get<uint32_t>(val));
+        return std::to_string(val.as<uint32_t>());
     case Type::MemoryObj:
-        return std::get<MemoryNode *>(val)->toString(pretty, depth + 1);
+        return val.as<MemoryNode *>()->toString(pretty, depth + 1);
     case Type::Char:
-        return std::string{std::get<char>(val)};
+        return std::string{val.as<char>()};
     case Type::NativeFunction:
         // c++ has no equality check for std::function
         return "Native function";
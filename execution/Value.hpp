@@ -4,9 +4,17 @@
 #include <cstddef>
 #include <functional>
 #include <variant>
+#include <bit>
+#include <type_traits>
 #include <string>
+#include <cassert>
 #include "Type.hpp"
 
+// pointers are stored in the lower 48 bits of the value, which fits every user space address only on some 64 bit platforms
+#if UINTPTR_MAX > UINT32_MAX && !(defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__) || defined(_M_ARM64))
+#error "Value can only store pointers of x86-64, AArch64 and 32 bit platforms"
+#endif
+
 namespace GobLang
 {
      /**
@@ -18,8 +26,178 @@ namespace GobLang
     class Machine;
     class MemoryNode;
     using FunctionValue = void (*)(Machine *);
-    using Value = std::variant<nullptr_t, bool, char, float, int32_t, uint32_t, MemoryNode *, FunctionValue>;
 
+    /**
+     * @brief Get type that is used to store values of the given c++ type
+     *
+     * @tparam T One of the types that value can hold
+     * @return Type Type of the value
+     */
+    template <typename T>
+    constexpr Type getValueType()
+    {
+        if constexpr (std::is_same_v<T, std::nullptr_t>)
+        {
+            return Type::Null;
+        }
+        else if constexpr (std::is_same_v<T, bool>)
+        {
+            return Type::Bool;
+        }
+        else if constexpr (std::is_same_v<T, char>)
+        {
+            return Type::Char;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return Type::Float;
+        }
+        else if constexpr (std::is_same_v<T, int32_t>)
+        {
+            return Type::Int;
+        }
+        else if constexpr (std::is_same_v<T, uint32_t>)
+        {
+            return Type::UnsignedInt;
+        }
+        else if constexpr (std::is_same_v<T, MemoryNode *>)
+        {
+            return Type::MemoryObj;
+        }
+        else
+        {
+            static_assert(std::is_same_v<T, FunctionValue>, "Type can't be stored in a value");
+            return Type::NativeFunction;
+        }
+    }
+
+    /**
+     * @brief Value that is used by the interpreter, which fits into 8 bytes.
+     *
+     * Type is stored in the upper 16 bits and the payload in the lower 48 bits. Every type except pointers only needs 32 bits,
+     * while user space pointers on supported 64 bit platforms fit into 48 bits. Empty value is null, because null has type 0 and no payload
+     *
+     */
+    class Value
+    {
+    public:
+        constexpr Value() : m_bits(0) {}
+
+        constexpr Value(std::nullptr_t) : m_bits(0) {}
+
+        constexpr Value(bool val) : m_bits(_makeBits(Type::Bool, val ? 1 : 0)) {}
+
+        constexpr Value(char val) : m_bits(_makeBits(Type::Char, (uint8_t)val)) {}
+
+        constexpr Value(float val) : m_bits(_makeBits(Type::Float, std::bit_cast<uint32_t>(val))) {}
+
+        constexpr Value(int32_t val) : m_bits(_makeBits(Type::Int, (uint32_t)val)) {}
+
+        constexpr Value(uint32_t val) : m_bits(_makeBits(Type::UnsignedInt, val)) {}
+
+        Value(MemoryNode *val) : m_bits(_makePointerBits(Type::MemoryObj, reinterpret_cast<uintptr_t>(val))) {}
+
+        Value(FunctionValue val) : m_bits(_makePointerBits(Type::NativeFunction, reinterpret_cast<uintptr_t>(val))) {}
+
+        /// @brief Get type of the stored value
+        constexpr Type getType() const { return (Type)(m_bits >> TypeShift); }
+
+        /// @brief Get id of the stored type, same as `(size_t)getType()`. Kept for code written when value was a `std::variant`
+        constexpr size_t index() const { return (size_t)(m_bits >> TypeShift); }
+
+        /// @brief Check if value stores the given c++ type
+        template <typename T>
+        constexpr bool is() const
+        {
+            return (m_bits >> TypeShift) == (uint64_t)getValueType<T>();
+        }
+
+        /**
+         * @brief Get stored value without checking the type, which must be checked beforehand using `is` or `getType`
+         *
+         * @tparam T Type of the stored value
+         * @return T Stored value
+         */
+        template <typename T>
+        T as() const
+        {
+            if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                return nullptr;
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                return (m_bits & 1) != 0;
+            }
+            else if constexpr (std::is_same_v<T, char>)
+            {
+                return (char)(uint8_t)m_bits;
+            }
+            else if constexpr (std::is_same_v<T, float>)
+            {
+                return std::bit_cast<float>((uint32_t)m_bits);
+            }
+            else if constexpr (std::is_same_v<T, int32_t>)
+            {
+                return (int32_t)(uint32_t)m_bits;
+            }
+            else if constexpr (std::is_same_v<T, uint32_t>)
+            {
+                return (uint32_t)m_bits;
+            }
+            else if constexpr (std::is_same_v<T, MemoryNode *>)
+            {
+                return reinterpret_cast<MemoryNode *>((uintptr_t)(m_bits & PayloadMask));
+            }
+            else
+            {
+                static_assert(std::is_same_v<T, FunctionValue>, "Type can't be stored in a value");
+                return reinterpret_cast<FunctionValue>((uintptr_t)(m_bits & PayloadMask));
+            }
+        }
+
+    private:
+        static constexpr uint64_t TypeShift = 48;
+        static constexpr uint64_t PayloadMask = (uint64_t(1) << TypeShift) - 1;
+
+        static constexpr uint64_t _makeBits(Type type, uint64_t payload) { return ((uint64_t)type << TypeShift) | payload; }
+
+        /// @brief Make bits of a value holding a pointer, which must not use the upper 16 bits(for example with 5-level paging or tagged pointers)
+        static uint64_t _makePointerBits(Type type, uintptr_t pointer)
+        {
+            assert(((uint64_t)pointer & ~PayloadMask) == 0 && "Pointer doesn't fit into the payload of a value");
+            return _makeBits(type, (uint64_t)pointer);
+        }
+
+        uint64_t m_bits;
+    };
+
+    static_assert(sizeof(Value) == 8, "Value must fit into 8 bytes");
+
+    /**
+     * @brief Check if value stores the given c++ type. Mirrors `std::holds_alternative` for native code written when value was a `std::variant`
+     *
+     */
+    template <typename T>
+    bool holds_alternative(Value const &val)
+    {
+        return val.is<T>();
+    }
+
+    /**
+     * @brief Get stored value, checking the type. Mirrors `std::get` for native code written when value was a `std::variant`
+     *
+     * @throws std::bad_variant_access If value stores a different type
+     */
+    template <typename T>
+    T get(Value const &val)
+    {
+        if (!val.is<T>())
+        {
+            throw std::bad_variant_access();
+        }
+        return val.as<T>();
+    }
 
 
     /**
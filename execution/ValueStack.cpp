@@ -0,0 +1,54 @@
+#include "ValueStack.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+GobLang::ValueStack::~ValueStack()
+{
+    ::operator delete(m_begin);
+}
+
+void GobLang::ValueStack::resize(size_t size)
+{
+    if (size > capacity())
+    {
+        _grow(size);
+    }
+    Value *end = m_begin + size;
+    if (end > m_end)
+    {
+        std::uninitialized_fill(m_end, end, Value());
+    }
+    m_end = end;
+}
+
+void GobLang::ValueStack::reserve(size_t size)
+{
+    if (size <= capacity())
+    {
+        return;
+    }
+    size_t count = this->size();
+    Value *values = static_cast<Value *>(::operator new(size * sizeof(Value)));
+    if (count != 0)
+    {
+        std::memcpy(values, m_begin, count * sizeof(Value));
+    }
+    ::operator delete(m_begin);
+    m_begin = values;
+    m_end = values + count;
+    m_capacity = values + size;
+}
+
+void GobLang::ValueStack::insert(size_t pos, size_t count)
+{
+    size_t oldSize = size();
+    resize(oldSize + count);
+    std::memmove(m_begin + pos + count, m_begin + pos, (oldSize - pos) * sizeof(Value));
+    std::fill(m_begin + pos, m_begin + pos + count, Value());
+}
+
+void GobLang::ValueStack::_grow(size_t size)
+{
+    reserve(std::max(size, capacity() * 2));
+}
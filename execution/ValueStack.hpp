@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "Value.hpp"
+
+namespace GobLang
+{
+    /**
+     * @brief Stack of values that owns its memory and stores it as three pointers, which compiled code reads and moves directly.
+     *
+     * Unlike `std::vector` the position of the pointers is known, so native code can push and pop values by changing the end pointer
+     * without going through the container. Values are never destroyed, as they don't own anything
+     *
+     */
+    class ValueStack
+    {
+    public:
+        static_assert(std::is_trivially_copyable_v<Value> && std::is_trivially_destructible_v<Value>, "Values are moved between buffers as raw memory");
+
+        explicit ValueStack() = default;
+        ~ValueStack();
+
+        ValueStack(ValueStack const &) = delete;
+        ValueStack &operator=(ValueStack const &) = delete;
+
+        size_t size() const { return (size_t)(m_end - m_begin); }
+
+        size_t capacity() const { return (size_t)(m_capacity - m_begin); }
+
+        bool empty() const { return m_end == m_begin; }
+
+        Value *begin() { return m_begin; }
+
+        Value *end() { return m_end; }
+
+        Value const *begin() const { return m_begin; }
+
+        Value const *end() const { return m_end; }
+
+        Value &operator[](size_t i) { return m_begin[i]; }
+
+        Value const &operator[](size_t i) const { return m_begin[i]; }
+
+        Value &back() { return m_end[-1]; }
+
+        Value const &back() const { return m_end[-1]; }
+
+        void push(Value const &val)
+        {
+            if (m_end == m_capacity)
+            {
+                _grow(size() + 1);
+            }
+            *m_end++ = val;
+        }
+
+        void pop() { m_end--; }
+
+        /**
+         * @brief Change amount of values on the stack, new values are null
+         *
+         * @param size New amount of values
+         */
+        void resize(size_t size);
+
+        /**
+         * @brief Make sure that the stack can hold the given amount of values without moving them
+         *
+         * @param size Amount of values
+         */
+        void reserve(size_t size);
+
+        /**
+         * @brief Insert null values in the middle of the stack, moving every value after them
+         *
+         * @param pos Position of the first new value
+         * @param count Amount of values to insert
+         */
+        void insert(size_t pos, size_t count);
+
+        /// @brief Offset of the pointer to the first value from the start of the stack
+        static constexpr size_t getBeginOffset() { return offsetof(ValueStack, m_begin); }
+
+        /// @brief Offset of the pointer past the last value from the start of the stack
+        static constexpr size_t getEndOffset() { return offsetof(ValueStack, m_end); }
+
+        /// @brief Offset of the pointer to the end of the allocated memory from the start of the stack
+        static constexpr size_t getCapacityOffset() { return offsetof(ValueStack, m_capacity); }
+
+    private:
+        /// @brief Move values into a larger buffer, growing at least twice so that pushing stays amortized
+        void _grow(size_t size);
+
+        Value *m_begin = nullptr;
+        Value *m_end = nullptr;
+        Value *m_capacity = nullptr;
+    };
+}
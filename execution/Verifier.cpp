@@ -0,0 +1,363 @@
+#include "Verifier.hpp"
+#include <algorithm>
+#include <string>
+#include "Exception.hpp"
+#include "Value.hpp"
+
+namespace
+{
+    /// @brief Marks successor that ends the program instead of continuing with an operation
+    constexpr size_t ProgramEnd = SIZE_MAX;
+
+    GobLang::RuntimeException verificationError(std::string const &message, size_t address)
+    {
+        return GobLang::RuntimeException("Verification failed: " + message + " at " + std::to_string(address));
+    }
+} // namespace
+
+GobLang::Verifier::Verifier(
+    std::vector<uint8_t> const &operations,
+    std::vector<Function> const &functions,
+    size_t constantCount,
+    size_t structureCount,
+    size_t fieldCacheCount) : m_operations(operations),
+                              m_functions(functions),
+                              m_constantCount(constantCount),
+                              m_structureCount(structureCount),
+                              m_fieldCacheCount(fieldCacheCount)
+{
+}
+
+GobLang::VerifiedCode GobLang::Verifier::verify() const
+{
+    std::vector<DecodedOperation> operations = _decode();
+    std::vector<size_t> addressOperations(m_operations.size() + 1, SIZE_MAX);
+    for (size_t i = 0; i < operations.size(); i++)
+    {
+        addressOperations[operations[i].address] = i;
+        _checkIds(operations[i]);
+    }
+    addressOperations[m_operations.size()] = operations.size();
+
+    // every function ends where the code of the next one starts, regardless of the order of the functions
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < m_functions.size(); i++)
+    {
+        size_t start = m_functions[i].start;
+        if (start >= m_operations.size() || addressOperations[start] == SIZE_MAX)
+        {
+            throw verificationError("Function " + std::to_string(i) + " does not start at an operation", start);
+        }
+        if (std::find(starts.begin(), starts.end(), addressOperations[start]) != starts.end())
+        {
+            throw verificationError("Function " + std::to_string(i) + " starts at the same operation as another function", start);
+        }
+        starts.push_back(addressOperations[start]);
+    }
+    std::vector<size_t> sortedStarts = starts;
+    std::sort(sortedStarts.begin(), sortedStarts.end());
+    auto getEnd = [&](size_t first)
+    {
+        std::vector<size_t>::const_iterator next = std::upper_bound(sortedStarts.begin(), sortedStarts.end(), first);
+        return next == sortedStarts.end() ? operations.size() : *next;
+    };
+
+    VerifiedCode result;
+    result.states.resize(m_operations.size() + 1);
+    // reaching the end of the code ends the program, which needs nothing from the frame
+    result.states[m_operations.size()] = VerifiedState{.requiredOperands = 0, .localCount = 0};
+    size_t mainEnd = sortedStarts.empty() ? operations.size() : sortedStarts.front();
+    result.main = _verifyFrame(operations, addressOperations, 0, mainEnd, 0, mainEnd == operations.size(), result.states);
+    for (size_t i = 0; i < m_functions.size(); i++)
+    {
+        size_t end = getEnd(starts[i]);
+        result.functions.push_back(_verifyFrame(operations, addressOperations, starts[i], end, m_functions[i].arguments.size(), false, result.states));
+    }
+    return result;
+}
+
+std::vector<GobLang::Verifier::DecodedOperation> GobLang::Verifier::_decode() const
+{
+    std::vector<DecodedOperation> operations;
+    for (size_t address = 0; address < m_operations.size();)
+    {
+        EncodedOperation encoded = decodeOperation(m_operations, address);
+        if (encoded.op == Operation::None)
+        {
+            throw verificationError("Unknown operation", address);
+        }
+        DecodedOperation operation{.op = encoded.op, .address = address, .arg = encoded.arg, .arg2 = encoded.arg2, .target = std::nullopt};
+        switch (operation.op)
+        {
+        case Operation::Jump:
+        case Operation::JumpIf:
+        case Operation::JumpIfNot:
+            operation.target = address + operation.arg;
+            break;
+        case Operation::JumpBack:
+            if (operation.arg > address)
+            {
+                throw verificationError("Jump back offset is larger than the address of the jump", address);
+            }
+            operation.target = address - operation.arg;
+            break;
+        default:
+            break;
+        }
+        operations.push_back(operation);
+        address += 1 + encoded.argSize;
+    }
+    return operations;
+}
+
+void GobLang::Verifier::_checkIds(DecodedOperation const &operation) const
+{
+    switch (operation.op)
+    {
+    case Operation::PushConstString:
+    case Operation::GetGlobalSlot:
+    case Operation::SetGlobalSlot:
+        if (operation.arg >= m_constantCount)
+        {
+            throw verificationError("Constant " + std::to_string(operation.arg) + " doesn't exist", operation.address);
+        }
+        break;
+    case Operation::GetFieldSlot:
+    case Operation::SetFieldSlot:
+    case Operation::CallMethodSlot:
+        if (operation.arg >= m_constantCount)
+        {
+            throw verificationError("Constant " + std::to_string(operation.arg) + " doesn't exist", operation.address);
+        }
+        if (operation.arg2 >= m_fieldCacheCount)
+        {
+            throw verificationError("Inline cache " + std::to_string(operation.arg2) + " doesn't exist", operation.address);
+        }
+        break;
+    case Operation::GetLocalFunction:
+    case Operation::CallLocal:
+        if (operation.arg >= m_functions.size())
+        {
+            throw verificationError("Function " + std::to_string(operation.arg) + " doesn't exist", operation.address);
+        }
+        break;
+    case Operation::New:
+        if (operation.arg >= m_structureCount)
+        {
+            throw verificationError("Structure " + std::to_string(operation.arg) + " doesn't exist", operation.address);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+GobLang::VerifiedFrame GobLang::Verifier::_verifyFrame(
+    std::vector<DecodedOperation> const &operations,
+    std::vector<size_t> const &addressOperations,
+    size_t first,
+    size_t last,
+    size_t argCount,
+    bool endsProgram,
+    std::vector<VerifiedState> &states) const
+{
+    size_t count = last - first;
+    size_t endAddress = last < operations.size() ? operations[last].address : m_operations.size();
+    if (count == 0)
+    {
+        if (!endsProgram)
+        {
+            throw verificationError("Execution can continue past the end of the function", endAddress);
+        }
+        return VerifiedFrame{.start = endAddress, .end = endAddress, .maxStackDepth = 0, .maxLocalCount = 0};
+    }
+    // indices of the operations that can be executed after each operation, relative to the first operation of the frame
+    std::vector<std::vector<size_t>> successors(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        DecodedOperation const &operation = operations[first + i];
+        std::vector<size_t> addresses;
+        switch (operation.op)
+        {
+        case Operation::Jump:
+        case Operation::JumpBack:
+            addresses = {operation.target.value()};
+            break;
+        case Operation::JumpIf:
+        case Operation::JumpIfNot:
+            addresses = {first + i + 1 < operations.size() ? operations[first + i + 1].address : m_operations.size(), operation.target.value()};
+            break;
+        case Operation::Return:
+        case Operation::ReturnValue:
+        case Operation::End:
+            break;
+        default:
+            addresses = {first + i + 1 < operations.size() ? operations[first + i + 1].address : m_operations.size()};
+            break;
+        }
+        for (size_t address : addresses)
+        {
+            if (address == endAddress)
+            {
+                if (!endsProgram)
+                {
+                    throw verificationError("Execution can continue past the end of the function", operation.address);
+                }
+                successors[i].push_back(ProgramEnd);
+                continue;
+            }
+            if (address >= addressOperations.size() || addressOperations[address] == SIZE_MAX)
+            {
+                throw verificationError("Jump does not lead to the start of an operation", operation.address);
+            }
+            size_t target = addressOperations[address];
+            if (target < first || target >= last)
+            {
+                throw verificationError("Jump leads outside of the function", operation.address);
+            }
+            successors[i].push_back(target - first);
+        }
+    }
+
+    // local variables that always exist and that can exist, and how many operands can be on the stack at the start of every operation
+    struct FlowState
+    {
+        bool reached = false;
+        size_t minLocals = 0;
+        size_t maxLocals = 0;
+        size_t depth = 0;
+    };
+    std::vector<FlowState> flow(count);
+    VerifiedFrame frame{.start = operations[first].address, .end = endAddress, .maxStackDepth = std::nullopt, .maxLocalCount = argCount};
+    // operations push at most one value more than they pop, so a deeper stack means that a loop keeps pushing values
+    size_t const depthLimit = count + 1;
+    bool unbounded = false;
+    size_t maxDepth = 0;
+    std::vector<size_t> pending = {0};
+    flow[0] = FlowState{.reached = true, .minLocals = argCount, .maxLocals = argCount, .depth = 0};
+    while (!pending.empty())
+    {
+        size_t i = pending.back();
+        pending.pop_back();
+        DecodedOperation const &operation = operations[first + i];
+        FlowState out = flow[i];
+        if (operation.op == Operation::SetLocal)
+        {
+            out.minLocals = std::max(out.minLocals, (size_t)operation.arg + 1);
+            out.maxLocals = std::max(out.maxLocals, (size_t)operation.arg + 1);
+        }
+        else if (operation.op == Operation::ShrinkLocal)
+        {
+            // freeing more variables than exist is reported once the flow is known
+            out.minLocals -= std::min(out.minLocals, (size_t)operation.arg);
+            out.maxLocals -= std::min(out.maxLocals, (size_t)operation.arg);
+        }
+        StackEffect effect = getStackEffect(operation.op, operation.arg, operation.arg2);
+        out.depth = effect.clear ? 0 : out.depth - std::min(out.depth, effect.pops) + effect.maxPushes;
+        if (out.depth > depthLimit)
+        {
+            out.depth = depthLimit;
+            unbounded = true;
+        }
+        frame.maxLocalCount = std::max(frame.maxLocalCount, out.maxLocals);
+        maxDepth = std::max({maxDepth, flow[i].depth, out.depth});
+        for (size_t next : successors[i])
+        {
+            if (next == ProgramEnd)
+            {
+                continue;
+            }
+            FlowState &state = flow[next];
+            if (!state.reached)
+            {
+                state = out;
+                pending.push_back(next);
+                continue;
+            }
+            FlowState joined{
+                .reached = true,
+                .minLocals = std::min(state.minLocals, out.minLocals),
+                .maxLocals = std::max(state.maxLocals, out.maxLocals),
+                .depth = std::max(state.depth, out.depth)};
+            if (joined.minLocals != state.minLocals || joined.maxLocals != state.maxLocals || joined.depth != state.depth)
+            {
+                state = joined;
+                pending.push_back(next);
+            }
+        }
+    }
+    if (!unbounded)
+    {
+        frame.maxStackDepth = maxDepth;
+    }
+    // operands needed by each operation and everything after it are found going backwards until nothing changes.
+    // Operands after a call depend on the called function, so they are checked when the call returns instead
+    std::vector<size_t> required(count, 0);
+    size_t const requiredLimit = 3 * count + 3;
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (size_t i = count; i-- > 0;)
+        {
+            if (!flow[i].reached)
+            {
+                continue;
+            }
+            StackEffect effect = getStackEffect(operations[first + i].op, operations[first + i].arg, operations[first + i].arg2);
+            size_t needed = effect.pops;
+            // nothing that was on the stack before the operation is left after it
+            for (size_t next = 0; next < successors[i].size() && !effect.call && !effect.clear; next++)
+            {
+                size_t after = successors[i][next] == ProgramEnd ? 0 : required[successors[i][next]];
+                if (after > effect.minPushes)
+                {
+                    needed = std::max(needed, after - effect.minPushes + effect.pops);
+                }
+            }
+            if (needed > required[i])
+            {
+                if (needed > requiredLimit)
+                {
+                    throw verificationError("Loop pops more values than it pushes", operations[first + i].address);
+                }
+                required[i] = needed;
+                changed = true;
+            }
+        }
+    }
+    if (required[0] > 0)
+    {
+        throw verificationError("Code can pop from an empty stack", frame.start);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!flow[i].reached)
+        {
+            continue;
+        }
+        DecodedOperation const &operation = operations[first + i];
+        if (operation.op == Operation::GetLocal && operation.arg >= flow[i].minLocals)
+        {
+            throw verificationError("Local variable " + std::to_string(operation.arg) + " might not exist", operation.address);
+        }
+        if (operation.op == Operation::ShrinkLocal && operation.arg > flow[i].minLocals)
+        {
+            throw verificationError("Freeing more local variables than exist", operation.address);
+        }
+        if (operation.op == Operation::Discard)
+        {
+            for (size_t next : successors[i])
+            {
+                if (next != ProgramEnd && required[next] > 0)
+                {
+                    throw verificationError("Code pops from the stack after every operand was discarded", operation.address);
+                }
+            }
+        }
+        states[operation.address] = VerifiedState{
+            .requiredOperands = (uint32_t)std::min(required[i], (size_t)VerifiedState::Unreachable - 1),
+            .localCount = (uint32_t)flow[i].minLocals};
+    }
+    return frame;
+}
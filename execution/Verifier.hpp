@@ -0,0 +1,140 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include "Operations.hpp"
+#include "Function.hpp"
+
+namespace GobLang
+{
+    /**
+     * @brief What the verifier proved about the state of the frame whenever execution reaches an operation
+     *
+     */
+    struct VerifiedState
+    {
+        /// @brief Value of `requiredOperands` for operations that can never be reached, which no frame satisfies
+        static constexpr uint32_t Unreachable = UINT32_MAX;
+        /**
+         * @brief How many operands have to be on the stack for this operation and every operation that follows it, up to the next call, to never pop from an empty stack.
+         * Values left by calls depend on the called function, so this is only guaranteed while the frame is not changed by anything except the verified operations
+         *
+         */
+        uint32_t requiredOperands = Unreachable;
+        /// @brief How many local variables always exist when this operation is reached
+        uint32_t localCount = 0;
+    };
+
+    /**
+     * @brief What the verifier found out about the code of a single function or the main code
+     *
+     */
+    struct VerifiedFrame
+    {
+        /// @brief Address of the first operation
+        size_t start = 0;
+        /// @brief Address right after the last operation
+        size_t end = 0;
+        /**
+         * @brief Max amount of operands on the stack, assuming that every call leaves at most one value.
+         * Nothing if the code is a loop that can leave values on the stack on every iteration, so the amount has no limit
+         *
+         */
+        std::optional<size_t> maxStackDepth;
+        /// @brief Max amount of local variables, including the arguments
+        size_t maxLocalCount = 0;
+    };
+
+    /**
+     * @brief Result of the verification of the byte code
+     *
+     */
+    struct VerifiedCode
+    {
+        VerifiedFrame main;
+        /// @brief Code of every function defined by the user in the same order as the functions
+        std::vector<VerifiedFrame> functions;
+        /// @brief State of the frame by the address of the operation, with one extra state for the end of the code
+        std::vector<VerifiedState> states;
+    };
+
+    /**
+     * @brief Checks that the byte code can't pop from an empty stack, read local variables that don't exist, jump outside of the function
+     * or use ids of constants, functions, structures or inline caches that don't exist.
+     *
+     * Main code is the code before the first function and every function ends where the next one starts,
+     * which is the layout produced by the code generator
+     *
+     */
+    class Verifier
+    {
+    public:
+        /**
+         * @brief Create verifier of the byte code
+         *
+         * @param operations Byte code to check
+         * @param functions Functions defined by the user, whose code is part of the byte code
+         * @param constantCount Amount of constant strings
+         * @param structureCount Amount of structures
+         * @param fieldCacheCount Amount of inline caches used by the field operations
+         */
+        explicit Verifier(
+            std::vector<uint8_t> const &operations,
+            std::vector<Function> const &functions,
+            size_t constantCount,
+            size_t structureCount,
+            size_t fieldCacheCount);
+
+        /**
+         * @brief Verify the code, throwing `RuntimeException` that describes the first problem if code is malformed
+         *
+         * @return VerifiedCode Information about the frames and the operations of the code
+         */
+        VerifiedCode verify() const;
+
+    private:
+        /// @brief Operation of the byte code with parsed arguments
+        struct DecodedOperation
+        {
+            Operation op;
+            size_t address;
+            uint32_t arg = 0;
+            uint32_t arg2 = 0;
+            /// @brief Address the operation jumps to
+            std::optional<size_t> target;
+        };
+
+        /// @brief Parse the byte code into operations
+        std::vector<DecodedOperation> _decode() const;
+
+        /// @brief Check that ids used by the operation exist
+        void _checkIds(DecodedOperation const &operation) const;
+
+        /**
+         * @brief Verify operations from `first` up to `last`, which are the code of a single frame, and store the states of the operations
+         *
+         * @param operations Every operation of the code
+         * @param addressOperations Index of the operation by its address
+         * @param first Index of the first operation of the frame
+         * @param last Index right after the last operation of the frame
+         * @param argCount Amount of arguments, which are the local variables the frame starts with
+         * @param endsProgram Whether execution can continue past the last operation, which ends the program
+         * @param states Output for the states of the operations
+         * @return VerifiedFrame Information about the frame
+         */
+        VerifiedFrame _verifyFrame(
+            std::vector<DecodedOperation> const &operations,
+            std::vector<size_t> const &addressOperations,
+            size_t first,
+            size_t last,
+            size_t argCount,
+            bool endsProgram,
+            std::vector<VerifiedState> &states) const;
+
+        std::vector<uint8_t> const &m_operations;
+        std::vector<Function> const &m_functions;
+        size_t m_constantCount;
+        size_t m_structureCount;
+        size_t m_fieldCacheCount;
+    };
+}
@@ -46,8 +46,7 @@ public:
         using namespace GobLang;
         if (StringNode *str = m->popObjectFromStack<StringNode>(); str != nullptr)
         {
-            NativeNode *native = new NativeNode(str->getString(), m->getNativeStructure(NativeNode::ClassName));
-            m->addObject(native);
+            NativeNode *native = m->allocate<NativeNode>(str->getString(), m->getNativeStructure(NativeNode::ClassName));
             m->pushObjectToStack(native);
         }
         else
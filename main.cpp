@@ -9,6 +9,7 @@
 #include <cmath>
 #include <cstring>
 #include <fstream>
+#include <sstream>
 
 #include "codegen/Parser.hpp"
 #include "codegen/CodeGenerator.hpp"
@@ -26,6 +27,10 @@ int main(int argc, char **argv)
     std::vector<std::string> FileArgs = {"-i", "--input"};
     std::vector<std::string> DecompArgs = {"-s", "--showbytes"};
     std::vector<std::string> RecursionArgs = {"-p", "--printdepth"};
+    std::vector<std::string> JitArgs = {"-j", "--jit"};
+    std::vector<std::string> JitCheckArgs = {"--jit-check"};
+    std::vector<std::string> JitStencilArgs = {"--jit-stencils"};
+    std::vector<std::string> UncheckedArgs = {"-u", "--unchecked"};
     std::vector<std::string> args;
     for (int i = 0; i < argc; i++)
     {
@@ -49,6 +54,10 @@ int main(int argc, char **argv)
         std::cout << "-i | --input      : Run code from file in a given location" << std::endl;
         std::cout << "-s | --showbytes  : Show bytecode before running code" << std::endl;
         std::cout << "-p | --printdepth : Set the max print recursion depth" << std::endl;
+        std::cout << "-j | --jit        : Compile frequently called functions into native code" << std::endl;
+        std::cout << "--jit-stencils    : Compile functions by patching precompiled stencils of the instructions, if they are available" << std::endl;
+        std::cout << "--jit-check       : Run code with and without compiling functions and compare the output" << std::endl;
+        std::cout << "-u | --unchecked  : Verify the code and run it without checking the stack where the verifier proved it to be valid" << std::endl;
         return EXIT_SUCCESS;
     }
 
@@ -114,9 +123,60 @@ int main(int argc, char **argv)
         {
             GobLang::Codegen::byteCodeToText(byteCode.operations);
         }
+        if (std::find_first_of(args.begin(), args.end(), JitCheckArgs.begin(), JitCheckArgs.end()) != args.end())
+        {
+            // run the code with the interpreter and with every backend of the compiler, capturing everything it prints,
+            // to check that compiled code behaves the same way as the interpreter
+            size_t runCount = GobLang::Jit::areStencilsSupported() ? 3 : 2;
+            std::string outputs[3];
+            // runs that end with an error fail the check even if every run fails the same way, just like running the code normally
+            bool failed = false;
+            for (size_t i = 0; i < runCount; i++)
+            {
+                std::ostringstream output;
+                std::streambuf *stdoutBuffer = std::cout.rdbuf(output.rdbuf());
+                try
+                {
+                    GobLang::Machine machine(byteCode);
+                    MachineFunctions::bind(&machine);
+                    machine.setJitEnabled(i != 0);
+                    machine.setJitBackend(i == 2 ? GobLang::Jit::Backend::Stencils : GobLang::Jit::Backend::Assembler);
+                    // compile functions on the first call and loops on the first iteration to check as much compiled code as possible
+                    machine.setJitThreshold(1);
+                    machine.setJitLoopThreshold(1);
+                    machine.run();
+                }
+                catch (GobLang::RuntimeException e)
+                {
+                    output << e.what() << std::endl;
+                    failed = true;
+                }
+                std::cout.rdbuf(stdoutBuffer);
+                outputs[i] = output.str();
+            }
+            std::cout << outputs[0];
+            for (size_t i = 1; i < runCount; i++)
+            {
+                if (outputs[0] != outputs[i])
+                {
+                    std::cerr << "Output of the code compiled " << (i == 2 ? "from stencils" : "by the assembler") << " is different from the interpreter:" << std::endl;
+                    std::cerr << outputs[i];
+                    return EXIT_FAILURE;
+                }
+            }
+            return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
         GobLang::Machine machine(byteCode);
         MachineFunctions::bind(&machine);
+        bool useStencils = std::find_first_of(args.begin(), args.end(), JitStencilArgs.begin(), JitStencilArgs.end()) != args.end();
+        machine.setJitEnabled(useStencils || std::find_first_of(args.begin(), args.end(), JitArgs.begin(), JitArgs.end()) != args.end());
+        machine.setJitBackend(useStencils ? GobLang::Jit::Backend::Stencils : GobLang::Jit::Backend::Assembler);
+        machine.setUncheckedExecutionEnabled(std::find_first_of(args.begin(), args.end(), UncheckedArgs.begin(), UncheckedArgs.end()) != args.end());
         std::vector<size_t> debugPoints = {};
+        if (debugPoints.empty())
+        {
+            machine.run();
+        }
         while (!machine.isAtTheEnd())
         {
             if (std::find(debugPoints.begin(), debugPoints.end(), machine.getProgramCounter()) != debugPoints.end())
@@ -38,8 +38,7 @@ void MachineFunctions::File::FileNode::constructor(GobLang::Machine *m)
     if (StringNode *path = m->popObjectFromStack<StringNode>(); path != nullptr)
     {
 
-        FileNode *f = new FileNode(path->getString(), m->popFromStack<bool>(), m->getNativeStructure("File"));
-        m->addObject(f);
+        FileNode *f = m->allocate<FileNode>(path->getString(), m->popFromStack<bool>(), m->getNativeStructure("File"));
         m->pushToStack(Value(f));
     }
     else
@@ -10,6 +10,7 @@ void MachineFunctions::bind(GobLang::Machine *machine)
     machine->addFunction(MachineFunctions::print, "print");
     machine->addFunction(MachineFunctions::toString, "str");
     machine->addFunction(MachineFunctions::createArrayOfSize, "array");
+    machine->addFunction(MachineFunctions::createFilledArray, "array_of");
     machine->addFunction(MachineFunctions::append, "append");
     machine->addFunction(MachineFunctions::input, "input");
     machine->addFunction(MachineFunctions::Math::toInt, "int");
@@ -34,7 +35,27 @@ void MachineFunctions::print(GobLang::Machine *machine)
 void MachineFunctions::createArrayOfSize(GobLang::Machine *machine)
 {
     GobLang::Value sizeVal = machine->getStackTopAndPop();
-    machine->pushToStack(GobLang::Value(machine->createArrayOfSize(std::get<int32_t>(sizeVal))));
+    if (!sizeVal.is<int32_t>())
+    {
+        throw GobLang::RuntimeException(std::string("Attempted to create array with size of type ") + GobLang::typeToString(sizeVal.getType()));
+    }
+    machine->pushToStack(GobLang::Value(machine->createArrayOfSize(sizeVal.as<int32_t>())));
+}
+
+void MachineFunctions::createFilledArray(GobLang::Machine *machine)
+{
+    GobLang::Value fill = machine->getStackTopAndPop();
+    GobLang::Value sizeVal = machine->getStackTopAndPop();
+    if (!sizeVal.is<int32_t>())
+    {
+        throw GobLang::RuntimeException(std::string("Attempted to create array with size of type ") + GobLang::typeToString(sizeVal.getType()));
+    }
+    GobLang::ArrayNode *array = machine->createArrayOfSize(sizeVal.as<int32_t>(), GobLang::ArrayNode::getElementTypeOf(fill));
+    for (int32_t i = 0; i < sizeVal.as<int32_t>(); i++)
+    {
+        array->setItem(i, fill);
+    }
+    machine->pushToStack(GobLang::Value(array));
 }
 
 void MachineFunctions::append(GobLang::Machine *machine)
@@ -58,11 +79,11 @@ void MachineFunctions::getSizeof(GobLang::Machine *machine)
     {
         throw GobLang::RuntimeException("Attempted to get a size of a non array object");
     }
-    if (GobLang::ArrayNode *arrayNode = dynamic_cast<GobLang::ArrayNode *>(array); arrayNode != nullptr)
+    if (GobLang::ArrayNode *arrayNode = node_cast<GobLang::ArrayNode>(array); arrayNode != nullptr)
     {
         machine->pushToStack(GobLang::Value((int32_t)arrayNode->getSize()));
     }
-    else if (GobLang::StringNode *strNode = dynamic_cast<GobLang::StringNode *>(array); strNode != nullptr)
+    else if (GobLang::StringNode *strNode = node_cast<GobLang::StringNode>(array); strNode != nullptr)
     {
         machine->pushToStack(GobLang::Value((int32_t)strNode->getSize()));
     }
@@ -92,18 +113,18 @@ void MachineFunctions::Math::toInt(GobLang::Machine *machine)
 {
     using namespace GobLang;
     Value value = machine->getStackTopAndPop();
-    switch ((Type)value.index())
+    switch (value.getType())
     {
     case Type::Int:
         machine->pushToStack(value);
         break;
     case GobLang::Type::Float:
-        machine->pushToStack(Value((int32_t)std::get<float>(value)));
+        machine->pushToStack(Value((int32_t)value.as<float>()));
         break;
     case GobLang::Type::MemoryObj:
         try
         {
-            if (StringNode *node = dynamic_cast<StringNode *>(std::get<MemoryNode *>(value)); node != nullptr)
+            if (StringNode *node = node_cast<StringNode>(value.as<MemoryNode *>()); node != nullptr)
             {
                 machine->pushToStack(Value(std::stoi(node->getString())));
                 break;
@@ -118,7 +139,7 @@ void MachineFunctions::Math::toInt(GobLang::Machine *machine)
             throw RuntimeException(std::string("Unable to convert string to int. ") + e.what());
         }
     default:
-        throw RuntimeException(std::string("Unable to convert type ") + typeToString((Type)value.index()) + " to int");
+        throw RuntimeException(std::string("Unable to convert type ") + typeToString(value.getType()) + " to int");
     }
 }
 
@@ -126,10 +147,10 @@ void MachineFunctions::Math::toFloat(GobLang::Machine *machine)
 {
     using namespace GobLang;
     Value value = machine->getStackTopAndPop();
-    switch ((Type)value.index())
+    switch (value.getType())
     {
     case Type::Int:
-        machine->pushToStack(Value(std::get<int32_t>(value)));
+        machine->pushToStack(Value(value.as<int32_t>()));
         break;
     case GobLang::Type::Float:
         machine->pushToStack(value);
@@ -137,7 +158,7 @@ void MachineFunctions::Math::toFloat(GobLang::Machine *machine)
     case GobLang::Type::MemoryObj:
         try
         {
-            if (StringNode *node = dynamic_cast<StringNode *>(std::get<MemoryNode *>(value)); node != nullptr)
+            if (StringNode *node = node_cast<StringNode>(value.as<MemoryNode *>()); node != nullptr)
             {
                 machine->pushToStack(Value(std::stof(node->getString())));
                 break;
@@ -152,7 +173,7 @@ void MachineFunctions::Math::toFloat(GobLang::Machine *machine)
             throw RuntimeException(std::string("Unable to convert string to float. ") + e.what());
         }
     default:
-        throw RuntimeException(std::string("Unable to convert type ") + typeToString((Type)value.index()) + " to float");
+        throw RuntimeException(std::string("Unable to convert type ") + typeToString(value.getType()) + " to float");
     }
 }
 
@@ -19,6 +19,14 @@ namespace MachineFunctions
 
     void createArrayOfSize(GobLang::Machine *machine);
 
+    /**
+     * @brief Create array of a given size where every item is set to a given value. Arrays filled with values of a primitive type
+     * store items without their type until a value of a different type is stored
+     *
+     * @param machine
+     */
+    void createFilledArray(GobLang::Machine *machine);
+
     void append(GobLang::Machine * machine);
 
     void getSizeof(GobLang::Machine *machine);
@@ -0,0 +1,324 @@
+/**
+ * @file StencilExtractor.cpp
+ * @brief Tool that reads the object file with compiled stencils and writes a header with their code and holes.
+ *
+ * Usage: stencil_extractor <object file> <output header>
+ */
+#include <elf.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../execution/Stencil.hpp"
+
+/// @brief Prefix of the names of functions that are stencils
+static const std::string StencilPrefix = "gob_stencil_";
+
+/// @brief Hole with the name of its kind, as it is written to the header
+struct ExtractedHole
+{
+    uint32_t offset;
+    std::string kind;
+    int64_t addend;
+};
+
+struct ExtractedStencil
+{
+    std::string name;
+    std::vector<uint8_t> code;
+    std::vector<ExtractedHole> holes;
+    bool continuesAtEnd = false;
+};
+
+class ExtractionError : public std::exception
+{
+public:
+    explicit ExtractionError(std::string const &message) : m_message(message) {}
+    const char *what() const noexcept override { return m_message.c_str(); }
+
+private:
+    std::string m_message;
+};
+
+/**
+ * @brief Reader of relocatable ELF64 x86-64 object files
+ *
+ */
+class ObjectFile
+{
+public:
+    explicit ObjectFile(std::vector<char> &&data) : m_data(std::move(data))
+    {
+        Elf64_Ehdr const &header = _get<Elf64_Ehdr>(0);
+        if (std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 ||
+            header.e_ident[EI_CLASS] != ELFCLASS64 ||
+            header.e_machine != EM_X86_64 ||
+            header.e_type != ET_REL)
+        {
+            throw ExtractionError("Stencils must be a relocatable x86-64 ELF64 object file");
+        }
+        for (size_t i = 0; i < header.e_shnum; i++)
+        {
+            m_sections.push_back(_get<Elf64_Shdr>(header.e_shoff + i * sizeof(Elf64_Shdr)));
+        }
+        m_sectionNames = header.e_shstrndx;
+    }
+
+    std::vector<Elf64_Shdr> const &getSections() const { return m_sections; }
+
+    std::string getSectionName(Elf64_Shdr const &section) const
+    {
+        return _getString(m_sections.at(m_sectionNames), section.sh_name);
+    }
+
+    std::vector<uint8_t> getContents(Elf64_Shdr const &section) const
+    {
+        _checkRange(section.sh_offset, section.sh_size);
+        return std::vector<uint8_t>(m_data.begin() + section.sh_offset, m_data.begin() + section.sh_offset + section.sh_size);
+    }
+
+    /// @brief Get relocations that apply to the section with the given index
+    std::vector<Elf64_Rela> getRelocations(size_t sectionId) const
+    {
+        std::vector<Elf64_Rela> relocations;
+        for (Elf64_Shdr const &section : m_sections)
+        {
+            if (section.sh_type == SHT_REL && section.sh_info == sectionId)
+            {
+                throw ExtractionError("Relocations without addends are not supported");
+            }
+            if (section.sh_type != SHT_RELA || section.sh_info != sectionId)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < section.sh_size / sizeof(Elf64_Rela); i++)
+            {
+                relocations.push_back(_get<Elf64_Rela>(section.sh_offset + i * sizeof(Elf64_Rela)));
+            }
+        }
+        return relocations;
+    }
+
+    /// @brief Get name of the symbol used by the relocation
+    std::string getSymbolName(Elf64_Shdr const &symbolTable, size_t symbolId) const
+    {
+        Elf64_Sym const &symbol = _get<Elf64_Sym>(symbolTable.sh_offset + symbolId * sizeof(Elf64_Sym));
+        if (ELF64_ST_TYPE(symbol.st_info) == STT_SECTION)
+        {
+            return getSectionName(m_sections.at(symbol.st_shndx));
+        }
+        return _getString(m_sections.at(symbolTable.sh_link), symbol.st_name);
+    }
+
+    Elf64_Shdr const &getSymbolTable() const
+    {
+        for (Elf64_Shdr const &section : m_sections)
+        {
+            if (section.sh_type == SHT_SYMTAB)
+            {
+                return section;
+            }
+        }
+        throw ExtractionError("Object file has no symbol table");
+    }
+
+private:
+    void _checkRange(size_t offset, size_t size) const
+    {
+        if (offset > m_data.size() || size > m_data.size() - offset)
+        {
+            throw ExtractionError("Object file is truncated");
+        }
+    }
+
+    template <class T>
+    T _get(size_t offset) const
+    {
+        _checkRange(offset, sizeof(T));
+        T value;
+        std::memcpy(&value, m_data.data() + offset, sizeof(T));
+        return value;
+    }
+
+    std::string _getString(Elf64_Shdr const &table, size_t offset) const
+    {
+        _checkRange(table.sh_offset, table.sh_size);
+        if (offset >= table.sh_size)
+        {
+            throw ExtractionError("Invalid string offset in object file");
+        }
+        char const *start = m_data.data() + table.sh_offset + offset;
+        return std::string(start, strnlen(start, table.sh_size - offset));
+    }
+
+    std::vector<char> m_data;
+    std::vector<Elf64_Shdr> m_sections;
+    size_t m_sectionNames = 0;
+};
+
+/// @brief Get name of the kind of the hole that reads the value of the symbol
+static std::optional<std::string> getValueHoleKind(std::string const &symbol)
+{
+#define GOB_LANG_STENCIL_HOLE_NAME(name, holeSymbol) \
+    if (symbol == #holeSymbol)                       \
+    {                                                \
+        return #name;                                \
+    }
+    GOB_LANG_STENCIL_VALUE_HOLES(GOB_LANG_STENCIL_HOLE_NAME)
+#undef GOB_LANG_STENCIL_HOLE_NAME
+    return std::nullopt;
+}
+
+/// @brief Get name of the kind of the hole that jumps to the symbol
+static std::optional<std::string> getJumpHoleKind(std::string const &symbol)
+{
+#define GOB_LANG_STENCIL_HOLE_NAME(name, holeSymbol) \
+    if (symbol == #holeSymbol)                       \
+    {                                                \
+        return #name;                                \
+    }
+    GOB_LANG_STENCIL_JUMP_HOLES(GOB_LANG_STENCIL_HOLE_NAME)
+#undef GOB_LANG_STENCIL_HOLE_NAME
+    return std::nullopt;
+}
+
+/// @brief Check that 32 bit offset at `offset` belongs to a jump instruction and not to a call,
+/// because continuing to another instruction must not leave a return address on the stack
+static bool isJumpOffset(std::vector<uint8_t> const &code, uint32_t offset)
+{
+    // jmp rel32
+    if (offset >= 1 && code[offset - 1] == 0xE9)
+    {
+        return true;
+    }
+    // jcc rel32
+    return offset >= 2 && code[offset - 2] == 0x0F && (code[offset - 1] & 0xF0) == 0x80;
+}
+
+static ExtractedStencil extractStencil(ObjectFile const &object, size_t sectionId, std::string const &name)
+{
+    Elf64_Shdr const &section = object.getSections()[sectionId];
+    Elf64_Shdr const &symbols = object.getSymbolTable();
+    ExtractedStencil stencil{.name = name, .code = object.getContents(section), .holes = {}};
+    for (Elf64_Rela const &relocation : object.getRelocations(sectionId))
+    {
+        std::string symbol = object.getSymbolName(symbols, ELF64_R_SYM(relocation.r_info));
+        uint32_t type = ELF64_R_TYPE(relocation.r_info);
+        uint32_t offset = (uint32_t)relocation.r_offset;
+        if (type == R_X86_64_64 && offset + sizeof(uint64_t) <= stencil.code.size())
+        {
+            if (std::optional<std::string> kind = getValueHoleKind(symbol); kind.has_value())
+            {
+                stencil.holes.push_back(ExtractedHole{offset, kind.value(), relocation.r_addend});
+                continue;
+            }
+        }
+        else if ((type == R_X86_64_PLT32 || type == R_X86_64_PC32) && offset + sizeof(int32_t) <= stencil.code.size())
+        {
+            std::optional<std::string> kind = getJumpHoleKind(symbol);
+            if (kind.has_value() && isJumpOffset(stencil.code, offset))
+            {
+                stencil.holes.push_back(ExtractedHole{offset, kind.value(), relocation.r_addend});
+                continue;
+            }
+        }
+        throw ExtractionError("Stencil " + name + " uses " + symbol + " in a way that can not be patched");
+    }
+    // jump to the next instruction at the very end of the stencil can be left out if the next instruction is placed right after it
+    for (ExtractedHole const &hole : stencil.holes)
+    {
+        if (hole.kind == "Continue" &&
+            hole.offset + sizeof(int32_t) == stencil.code.size() &&
+            stencil.code[hole.offset - 1] == 0xE9 &&
+            hole.addend == -(int64_t)sizeof(int32_t))
+        {
+            stencil.continuesAtEnd = true;
+        }
+    }
+    return stencil;
+}
+
+static std::string generateHeader(std::vector<ExtractedStencil> const &stencils)
+{
+    std::stringstream header;
+    header << "// Generated by stencil_extractor from the compiled stencils/Stencils.cpp, do not edit\n";
+    header << "// Types of the stencils are declared in execution/Stencil.hpp, which has to be included first\n";
+    header << "#pragma once\n\n";
+    header << "namespace GobLang::Jit::Stencils\n{\n";
+    for (ExtractedStencil const &stencil : stencils)
+    {
+        header << "    inline constexpr uint8_t " << stencil.name << "Code[] = {";
+        for (size_t i = 0; i < stencil.code.size(); i++)
+        {
+            header << (i % 16 == 0 ? "\n        " : " ") << (uint32_t)stencil.code[i] << ",";
+        }
+        header << "\n    };\n";
+        if (!stencil.holes.empty())
+        {
+            header << "    inline constexpr Hole " << stencil.name << "Holes[] = {\n";
+            for (ExtractedHole const &hole : stencil.holes)
+            {
+                header << "        {" << hole.offset << ", HoleKind::" << hole.kind << ", " << hole.addend << "},\n";
+            }
+            header << "    };\n";
+        }
+        header << "    inline constexpr Stencil " << stencil.name << "{"
+               << stencil.name << "Code, sizeof(" << stencil.name << "Code), "
+               << (stencil.holes.empty() ? "nullptr" : stencil.name + "Holes") << ", "
+               << stencil.holes.size() << ", "
+               << (stencil.continuesAtEnd ? "true" : "false") << "};\n\n";
+    }
+    header << "}\n";
+    return header.str();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: stencil_extractor <object file> <output header>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::ifstream input(argv[1], std::ios::binary);
+    if (!input.is_open())
+    {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        std::vector<char> data{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        ObjectFile object(std::move(data));
+        std::vector<ExtractedStencil> stencils;
+        std::string const sectionPrefix = ".text." + StencilPrefix;
+        for (size_t i = 0; i < object.getSections().size(); i++)
+        {
+            std::string name = object.getSectionName(object.getSections()[i]);
+            if (name.starts_with(sectionPrefix))
+            {
+                stencils.push_back(extractStencil(object, i, name.substr(sectionPrefix.size())));
+            }
+        }
+        if (stencils.empty())
+        {
+            throw ExtractionError("Object file contains no stencils, it must be compiled with -ffunction-sections");
+        }
+        std::ofstream output(argv[2]);
+        output << generateHeader(stencils);
+        if (!output.good())
+        {
+            std::cerr << "Failed to write " << argv[2] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (ExtractionError const &e)
+    {
+        std::cerr << "Failed to extract stencils: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+/**
+ * @file Stencils.cpp
+ * @brief Native code of the instructions used by the stencil compiler.
+ *
+ * Every `gob_stencil_` function is the code of a single instruction. This file is compiled on its own and `stencil_extractor` copies
+ * the machine code of every stencil out of the object file together with its relocations, which mark the places that have to be
+ * patched once the code is copied into the compiled function.
+ * Values that are only known at that point, like arguments of the instruction or the layout of the machine, are read from holes,
+ * symbols that are never defined. Moving to the next instruction or to the target of a jump is done by tail calling `gob_continue`
+ * or `gob_branch`, which become jumps to the code of that instruction, while returning leaves the compiled code.
+ * Stencils must not use anything else that needs a relocation, such as constants or functions that were not inlined
+ */
+#include <cstdint>
+#include <cstddef>
+#include "../execution/Jit.hpp"
+
+/// @brief Read the 64 bit value of the hole with the given symbol
+#define GOB_LANG_HOLE(symbol)                       \
+    ({                                              \
+        uint64_t value;                             \
+        asm("movabs $" #symbol ", %0" : "=r"(value)); \
+        value;                                      \
+    })
+
+#define GOB_LANG_STENCIL_INLINE inline __attribute__((always_inline))
+
+extern "C" void gob_continue(GobLang::Machine *machine);
+extern "C" void gob_branch(GobLang::Machine *machine);
+
+namespace
+{
+    using GobLang::Jit::HelperResult;
+    using GobLang::Jit::OperationHelper;
+
+    /// @brief Call the helper of the instruction
+    GOB_LANG_STENCIL_INLINE uint32_t callHelper(GobLang::Machine *machine)
+    {
+        OperationHelper helper = reinterpret_cast<OperationHelper>(GOB_LANG_HOLE(gob_hole_helper));
+        return helper(
+            machine,
+            (uint32_t)GOB_LANG_HOLE(gob_hole_pc),
+            (uint32_t)GOB_LANG_HOLE(gob_hole_arg),
+            (uint32_t)GOB_LANG_HOLE(gob_hole_arg2),
+            (uint32_t)GOB_LANG_HOLE(gob_hole_arg3));
+    }
+
+    /// @brief Perform the instruction using its helper and continue with the next instruction unless the helper asks to leave
+    GOB_LANG_STENCIL_INLINE void performOperation(GobLang::Machine *machine)
+    {
+        if (callHelper(machine) == HelperResult::Continue)
+        {
+            return gob_continue(machine);
+        }
+    }
+
+    /// @brief Perform the instruction that can jump using its helper
+    GOB_LANG_STENCIL_INLINE void performBranchOperation(GobLang::Machine *machine)
+    {
+        uint32_t result = callHelper(machine);
+        if (result == HelperResult::Continue)
+        {
+            return gob_continue(machine);
+        }
+        if (result == HelperResult::Branch)
+        {
+            return gob_branch(machine);
+        }
+    }
+
+    template <class T>
+    GOB_LANG_STENCIL_INLINE T &field(GobLang::Machine *machine, uint64_t offset)
+    {
+        return *reinterpret_cast<T *>(reinterpret_cast<char *>(machine) + offset);
+    }
+
+    /// @brief Pointer past the last value of the stack
+    GOB_LANG_STENCIL_INLINE uint64_t *&stackEnd(GobLang::Machine *machine)
+    {
+        return field<uint64_t *>(machine, GOB_LANG_HOLE(gob_hole_stack_end));
+    }
+
+    /// @brief Whether there is space for another value on the stack
+    GOB_LANG_STENCIL_INLINE bool hasCapacity(GobLang::Machine *machine)
+    {
+        return stackEnd(machine) < field<uint64_t *>(machine, GOB_LANG_HOLE(gob_hole_stack_capacity));
+    }
+
+    /// @brief Pointer to the first local variable of the current frame
+    GOB_LANG_STENCIL_INLINE uint64_t *locals(GobLang::Machine *machine)
+    {
+        return field<uint64_t *>(machine, GOB_LANG_HOLE(gob_hole_stack_begin)) + field<size_t>(machine, GOB_LANG_HOLE(gob_hole_frame_base));
+    }
+
+    /// @brief Pointer to the first operand of the current frame, which is right after the values reserved for the local variables
+    GOB_LANG_STENCIL_INLINE uint64_t *operands(GobLang::Machine *machine)
+    {
+        return locals(machine) + field<size_t>(machine, GOB_LANG_HOLE(gob_hole_frame_local_capacity));
+    }
+
+    /// @brief Whether the current function has at least `count` values above its local variables
+    GOB_LANG_STENCIL_INLINE bool hasOperands(GobLang::Machine *machine, ptrdiff_t count)
+    {
+        return stackEnd(machine) - operands(machine) >= count;
+    }
+
+    /// @brief Whether the current frame has a local variable with the given id
+    GOB_LANG_STENCIL_INLINE bool hasLocal(GobLang::Machine *machine, uint64_t id)
+    {
+        return id < field<size_t>(machine, GOB_LANG_HOLE(gob_hole_frame_local_count));
+    }
+
+    GOB_LANG_STENCIL_INLINE bool isInt(uint64_t bits)
+    {
+        return (bits >> 32) == (GOB_LANG_HOLE(gob_hole_int_bits) >> 32);
+    }
+
+    GOB_LANG_STENCIL_INLINE uint64_t makeInt(uint32_t value)
+    {
+        return GOB_LANG_HOLE(gob_hole_int_bits) | value;
+    }
+
+    GOB_LANG_STENCIL_INLINE uint64_t makeBool(bool value)
+    {
+        return value ? GOB_LANG_HOLE(gob_hole_true_bits) : GOB_LANG_HOLE(gob_hole_false_bits);
+    }
+
+    GOB_LANG_STENCIL_INLINE void pushConst(GobLang::Machine *machine, uint64_t bits)
+    {
+        if (hasCapacity(machine))
+        {
+            *stackEnd(machine)++ = bits;
+            return gob_continue(machine);
+        }
+        return performOperation(machine);
+    }
+}
+
+/// @brief Instruction that is always performed by its helper
+extern "C" void gob_stencil_CallHelper(GobLang::Machine *machine)
+{
+    return performOperation(machine);
+}
+
+/// @brief Instruction that can jump and is always performed by its helper
+extern "C" void gob_stencil_CallBranchingHelper(GobLang::Machine *machine)
+{
+    return performBranchOperation(machine);
+}
+
+extern "C" void gob_stencil_PushConstInt(GobLang::Machine *machine)
+{
+    return pushConst(machine, makeInt((uint32_t)GOB_LANG_HOLE(gob_hole_arg)));
+}
+
+extern "C" void gob_stencil_PushTrue(GobLang::Machine *machine)
+{
+    return pushConst(machine, GOB_LANG_HOLE(gob_hole_true_bits));
+}
+
+extern "C" void gob_stencil_PushFalse(GobLang::Machine *machine)
+{
+    return pushConst(machine, GOB_LANG_HOLE(gob_hole_false_bits));
+}
+
+extern "C" void gob_stencil_GetLocal(GobLang::Machine *machine)
+{
+    uint64_t id = (uint32_t)GOB_LANG_HOLE(gob_hole_arg);
+    if (hasLocal(machine, id) && hasCapacity(machine))
+    {
+        uint64_t value = locals(machine)[id];
+        *stackEnd(machine)++ = value;
+        return gob_continue(machine);
+    }
+    return performOperation(machine);
+}
+
+extern "C" void gob_stencil_SetLocal(GobLang::Machine *machine)
+{
+    uint64_t id = (uint32_t)GOB_LANG_HOLE(gob_hole_arg);
+    if (hasLocal(machine, id) && hasOperands(machine, 1))
+    {
+        locals(machine)[id] = *--stackEnd(machine);
+        return gob_continue(machine);
+    }
+    return performOperation(machine);
+}
+
+// Operation on two integers on top of the stack, which are available as `a` and `b`, using helper if operands are not integers
+#define GOB_LANG_INT_STENCIL(name, result)                             \
+    extern "C" void gob_stencil_##name(GobLang::Machine *machine)      \
+    {                                                                  \
+        if (hasOperands(machine, 2))                                   \
+        {                                                              \
+            uint64_t *end = stackEnd(machine);                         \
+            if (isInt(end[-2]) && isInt(end[-1]))                      \
+            {                                                          \
+                uint32_t a = (uint32_t)end[-2];                        \
+                uint32_t b = (uint32_t)end[-1];                        \
+                end[-2] = result;                                      \
+                stackEnd(machine) = end - 1;                           \
+                return gob_continue(machine);                          \
+            }                                                          \
+        }                                                              \
+        return performOperation(machine);                              \
+    }
+
+// unsigned arithmetic wraps around the same way as the 32 bit instructions of the interpreter
+GOB_LANG_INT_STENCIL(AddInt, makeInt(a + b))
+GOB_LANG_INT_STENCIL(SubInt, makeInt(a - b))
+GOB_LANG_INT_STENCIL(MulInt, makeInt(a * b))
+GOB_LANG_INT_STENCIL(LessInt, makeBool((int32_t)a < (int32_t)b))
+GOB_LANG_INT_STENCIL(MoreInt, makeBool((int32_t)a > (int32_t)b))
+GOB_LANG_INT_STENCIL(LessOrEqInt, makeBool((int32_t)a <= (int32_t)b))
+GOB_LANG_INT_STENCIL(MoreOrEqInt, makeBool((int32_t)a >= (int32_t)b))
+
+#undef GOB_LANG_INT_STENCIL
+
+// Jump depending on the boolean on top of the stack, using helper if the value is not a boolean
+#define GOB_LANG_CONDITION_STENCIL(name, onTrue, onFalse)              \
+    extern "C" void gob_stencil_##name(GobLang::Machine *machine)      \
+    {                                                                  \
+        if (hasOperands(machine, 1))                                   \
+        {                                                              \
+            uint64_t condition = stackEnd(machine)[-1];                \
+            if (condition == GOB_LANG_HOLE(gob_hole_true_bits))        \
+            {                                                          \
+                stackEnd(machine)--;                                   \
+                return onTrue(machine);                                \
+            }                                                          \
+            if (condition == GOB_LANG_HOLE(gob_hole_false_bits))       \
+            {                                                          \
+                stackEnd(machine)--;                                   \
+                return onFalse(machine);                               \
+            }                                                          \
+        }                                                              \
+        return performBranchOperation(machine);                        \
+    }
+
+GOB_LANG_CONDITION_STENCIL(JumpIfNot, gob_continue, gob_branch)
+GOB_LANG_CONDITION_STENCIL(JumpIf, gob_branch, gob_continue)
+
+#undef GOB_LANG_CONDITION_STENCIL
+
+extern "C" void gob_stencil_IncLocalByConst(GobLang::Machine *machine)
+{
+    uint64_t id = (uint32_t)GOB_LANG_HOLE(gob_hole_arg2);
+    if (hasLocal(machine, id))
+    {
+        uint64_t *local = locals(machine) + id;
+        if (isInt(*local))
+        {
+            *local = makeInt((uint32_t)*local + (uint32_t)GOB_LANG_HOLE(gob_hole_arg));
+            return gob_continue(machine);
+        }
+    }
+    return performOperation(machine);
+}
+
+// Push sum or difference of the local variable and the constant, using helper if the variable is not an integer
+#define GOB_LANG_LOCAL_CONST_STENCIL(name, op)                                   \
+    extern "C" void gob_stencil_##name(GobLang::Machine *machine)                \
+    {                                                                            \
+        uint64_t id = (uint32_t)GOB_LANG_HOLE(gob_hole_arg2);                    \
+        if (hasLocal(machine, id) && hasCapacity(machine))                       \
+        {                                                                        \
+            uint64_t local = locals(machine)[id];                                \
+            if (isInt(local))                                                    \
+            {                                                                    \
+                *stackEnd(machine)++ = makeInt((uint32_t)local op(uint32_t) GOB_LANG_HOLE(gob_hole_arg)); \
+                return gob_continue(machine);                                    \
+            }                                                                    \
+        }                                                                        \
+        return performOperation(machine);                                        \
+    }
+
+GOB_LANG_LOCAL_CONST_STENCIL(PushLocalAddConst, +)
+GOB_LANG_LOCAL_CONST_STENCIL(PushLocalSubConst, -)
+
+#undef GOB_LANG_LOCAL_CONST_STENCIL
+
+// Compare local variable with the constant and jump if the comparison fails, using helper if the variable is not an integer
+#define GOB_LANG_COMPARE_LOCAL_CONST_STENCIL(name, op)                                    \
+    extern "C" void gob_stencil_##name(GobLang::Machine *machine)                         \
+    {                                                                                     \
+        uint64_t id = (uint32_t)GOB_LANG_HOLE(gob_hole_arg2);                             \
+        if (hasLocal(machine, id))                                                        \
+        {                                                                                 \
+            uint64_t local = locals(machine)[id];                                         \
+            if (isInt(local))                                                             \
+            {                                                                             \
+                if ((int32_t)local op(int32_t) GOB_LANG_HOLE(gob_hole_arg))               \
+                {                                                                         \
+                    return gob_continue(machine);                                         \
+                }                                                                         \
+                return gob_branch(machine);                                               \
+            }                                                                             \
+        }                                                                                 \
+        return performBranchOperation(machine);                                           \
+    }
+
+GOB_LANG_COMPARE_LOCAL_CONST_STENCIL(JumpIfNotLessLocalConst, <)
+GOB_LANG_COMPARE_LOCAL_CONST_STENCIL(JumpIfNotLessOrEqLocalConst, <=)
+
+#undef GOB_LANG_COMPARE_LOCAL_CONST_STENCIL
+
+extern "C" void gob_stencil_JumpIfNotLessLocals(GobLang::Machine *machine)
+{
+    uint64_t first = (uint32_t)GOB_LANG_HOLE(gob_hole_arg);
+    uint64_t second = (uint32_t)GOB_LANG_HOLE(gob_hole_arg2);
+    if (hasLocal(machine, first) && hasLocal(machine, second))
+    {
+        uint64_t a = locals(machine)[first];
+        uint64_t b = locals(machine)[second];
+        if (isInt(a) && isInt(b))
+        {
+            if ((int32_t)a < (int32_t)b)
+            {
+                return gob_continue(machine);
+            }
+            return gob_branch(machine);
+        }
+    }
+    return performBranchOperation(machine);
+}